@@ -0,0 +1,22 @@
+#include "AllocationCounter.hh"
+
+#include <cstdlib>
+#include <new>
+
+namespace decomp {
+namespace {
+size_t num_allocations = 0;
+}  // namespace
+
+size_t allocation_count() { return num_allocations; }
+}  // namespace decomp
+
+void* operator new(size_t size) {
+  decomp::num_allocations++;
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
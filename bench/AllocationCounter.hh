@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+namespace decomp {
+// Calls to the global operator new so far, counted by the replacement AllocationCounter.cc links in. The replacement
+// lives in its own translation unit so no caller sees it paired with free()
+size_t allocation_count();
+}  // namespace decomp
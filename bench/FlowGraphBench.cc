@@ -0,0 +1,252 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "utl/FlowGraph.hh"
+#include "utl/FlowGraphSnapshot.hh"
+#include "utl/LoopForest.hh"
+#include "utl/ReachabilityIndex.hh"
+
+using namespace decomp;
+
+namespace {
+constexpr size_t kNumGraphs = 4000;
+constexpr int kMaxBlocks = 400;
+constexpr int kRounds = 5;
+constexpr size_t kNumLargeGraphs = 5;
+constexpr int kLargeBlocks = 100000;
+
+struct BlockData {
+  uint32_t _start = 0;
+  uint32_t _end = 0;
+
+  BlockData() = default;
+  BlockData(uint32_t start, uint32_t end) : _start(start), _end(end) {}
+};
+using Graph = FlowGraph<BlockData>;
+
+// Shapes like compiled functions: mostly fallthroughs and two way branches, short backward loops and the odd jump
+// table fanning out to many cases
+void build_graph(std::mt19937& rng, Graph& gr) {
+  auto pick = [&rng](uint32_t n) { return static_cast<uint32_t>(rng() % n); };
+  const int num_blocks = 8 + static_cast<int>(pick(kMaxBlocks));
+
+  std::vector<int> blocks;
+  for (int i = 0; i < num_blocks; i++) {
+    blocks.push_back(gr.emplace_vertex(4 * i, 4 * i + 4));
+  }
+  gr.emplace_link(gr.root()->_idx, blocks[0], BlockTransfer::kFallthrough);
+  for (int i = 0; i < num_blocks - 1; i++) {
+    const uint32_t kind = pick(16);
+    if (kind < 6) {
+      gr.emplace_link(blocks[i], blocks[i + 1], BlockTransfer::kFallthrough);
+    } else if (kind < 14) {
+      const int lo = std::max(0, i - 8);
+      const int target = pick(4) == 0 ? lo + static_cast<int>(pick(i - lo + 1))
+                                      : i + 1 + static_cast<int>(pick(std::min(16, num_blocks - i - 1)));
+      gr.emplace_link(blocks[i], blocks[target], BlockTransfer::kConditionTrue);
+      gr.emplace_link(blocks[i], blocks[i + 1], BlockTransfer::kConditionFalse);
+    } else {
+      const uint32_t num_cases = 3 + pick(10);
+      for (uint32_t c = 0; c < num_cases; c++) {
+        const int target = i + 1 + static_cast<int>(pick(std::min(32, num_blocks - i - 1)));
+        const auto tr = static_cast<BlockTransfer>(static_cast<uint32_t>(BlockTransfer::kFirstSwitchCase) + c);
+        gr.emplace_link(blocks[i], blocks[target], tr);
+      }
+    }
+  }
+  gr.emplace_link(blocks.back(), gr.terminal()->_idx, BlockTransfer::kUnconditional);
+}
+
+// One long function body, a straight spine with back edges to anywhere above. Dominator trees come out very deep,
+// which is what the old parent chain walk in Lengauer-Tarjan choked on
+void build_large_graph(std::mt19937& rng, Graph& gr) {
+  std::vector<int> blocks;
+  for (int i = 0; i < kLargeBlocks; i++) {
+    blocks.push_back(gr.emplace_vertex(4 * i, 4 * i + 4));
+  }
+  gr.emplace_link(gr.root()->_idx, blocks[0], BlockTransfer::kFallthrough);
+  for (int i = 0; i < kLargeBlocks - 1; i++) {
+    if (rng() % 3 == 0) {
+      gr.emplace_link(blocks[i], blocks[rng() % (i + 1)], BlockTransfer::kConditionTrue);
+      gr.emplace_link(blocks[i], blocks[i + 1], BlockTransfer::kConditionFalse);
+    } else {
+      gr.emplace_link(blocks[i], blocks[i + 1], BlockTransfer::kFallthrough);
+    }
+  }
+  gr.emplace_link(blocks.back(), gr.terminal()->_idx, BlockTransfer::kUnconditional);
+}
+
+template <typename Fn>
+void timed(char const* name, Fn&& fn) {
+  double best = 0;
+  uint64_t sink = 0;
+  for (int round = 0; round < kRounds; round++) {
+    const auto start = std::chrono::steady_clock::now();
+    sink = fn();
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    best = round == 0 ? secs : std::min(best, secs);
+  }
+  fmt::print("{:<20} {:.4f}s (checksum {:x})\n", name, best, sink);
+}
+}  // namespace
+
+int main() {
+  std::vector<Graph> graphs(kNumGraphs);
+  size_t num_vertices = 0;
+  {
+    std::mt19937 rng(0x5eed);
+    const auto start = std::chrono::steady_clock::now();
+    for (Graph& gr : graphs) {
+      build_graph(rng, gr);
+      num_vertices += gr.size();
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fmt::print("{:<20} {:.4f}s for {} graphs, {} vertices\n", "build", secs, graphs.size(), num_vertices);
+  }
+
+  timed("foreach_real", [&graphs] {
+    uint64_t sum = 0;
+    for (Graph const& gr : graphs) {
+      gr.foreach_real([&sum](Graph::Vertex const& v) { sum += v.data()._end - v.data()._start + v._out.size(); });
+    }
+    return sum;
+  });
+  timed("preorder", [&graphs] {
+    uint64_t sum = 0;
+    for (Graph const& gr : graphs) {
+      gr.preorder_fwd([&sum](Graph::Vertex const& v) { sum = sum * 31 + v._idx; }, gr.root());
+    }
+    return sum;
+  });
+  timed("reverse preorder", [&graphs] {
+    uint64_t sum = 0;
+    for (Graph const& gr : graphs) {
+      gr.preorder<false>([&sum](Graph::Vertex const& v) { sum = sum * 31 + v._idx; }, gr.terminal());
+    }
+    return sum;
+  });
+  timed("postorder", [&graphs] {
+    uint64_t sum = 0;
+    for (Graph& gr : graphs) {
+      gr.postorder_fwd([&sum](Graph::Vertex& v) { sum = sum * 31 + v._idx; }, gr.root());
+    }
+    return sum;
+  });
+  timed("dominators", [&graphs] {
+    uint64_t sum = 0;
+    for (Graph& gr : graphs) {
+      for (int idom : gr.compute_dom_tree()) {
+        sum = sum * 31 + idom;
+      }
+    }
+    return sum;
+  });
+  timed("reachability", [&graphs] {
+    uint64_t sum = 0;
+    for (Graph const& gr : graphs) {
+      ReachabilityIndex reach(gr);
+      for (size_t v = 0; v < gr.size(); v++) {
+        sum = sum * 31 + reach.reaches(gr, v, (v * 7) % gr.size());
+      }
+    }
+    return sum;
+  });
+
+  std::vector<FlowGraphSnapshot> shapes;
+  timed("snapshot", [&graphs, &shapes] {
+    shapes.clear();
+    for (Graph const& gr : graphs) {
+      shapes.emplace_back(gr);
+    }
+    return shapes.size();
+  });
+  timed("snapshot preorder", [&shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : shapes) {
+      shape.preorder<true>([&sum](int idx) { sum = sum * 31 + idx; }, shape.root());
+    }
+    return sum;
+  });
+  timed("snapshot rpo", [&shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : shapes) {
+      for (int idx : shape.rpo()) {
+        sum = sum * 31 + shape.successors(idx).size();
+      }
+    }
+    return sum;
+  });
+  timed("snapshot dominators", [&shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : shapes) {
+      for (int idom : shape.compute_dom_tree()) {
+        sum = sum * 31 + idom;
+      }
+    }
+    return sum;
+  });
+  timed("snapshot postdoms", [&shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : shapes) {
+      for (int ipdom : shape.compute_pdom_tree()) {
+        sum = sum * 31 + ipdom;
+      }
+    }
+    return sum;
+  });
+  // Built directly rather than through loops() so every round pays for it
+  timed("snapshot loops", [&shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : shapes) {
+      LoopForest loops(shape);
+      for (size_t v = 0; v < shape.size(); v++) {
+        sum = sum * 31 + loops.depth(v);
+      }
+    }
+    return sum;
+  });
+
+  std::vector<FlowGraphSnapshot> large_shapes;
+  {
+    std::mt19937 rng(0x1a29e);
+    for (size_t i = 0; i < kNumLargeGraphs; i++) {
+      Graph gr;
+      build_large_graph(rng, gr);
+      large_shapes.emplace_back(gr);
+    }
+  }
+  timed("large dominators", [&large_shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : large_shapes) {
+      for (int idom : shape.compute_dom_tree()) {
+        sum = sum * 31 + idom;
+      }
+    }
+    return sum;
+  });
+  timed("large postdoms", [&large_shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : large_shapes) {
+      for (int ipdom : shape.compute_pdom_tree()) {
+        sum = sum * 31 + ipdom;
+      }
+    }
+    return sum;
+  });
+  timed("large loops", [&large_shapes] {
+    uint64_t sum = 0;
+    for (FlowGraphSnapshot const& shape : large_shapes) {
+      LoopForest loops(shape);
+      for (size_t v = 0; v < shape.size(); v++) {
+        sum = sum * 31 + loops.depth(v);
+      }
+    }
+    return sum;
+  });
+  return 0;
+}
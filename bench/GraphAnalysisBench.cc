@@ -0,0 +1,73 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "ppc/BinaryContext.hh"
+#include "ppc/Subroutine.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kFunctionBase = 0x80003100;
+constexpr uint32_t kBlr = 0x4e800020;
+constexpr int kRounds = 3;
+
+constexpr uint32_t addi(uint32_t rd, uint32_t ra, int16_t simm) {
+  return (14 << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t beq(int32_t rel) { return (16 << 26) | (12 << 21) | (2 << 16) | (static_cast<uint32_t>(rel) & 0xfffc); }
+
+// One block per counter bump and conditional jump to a block up to 1000 blocks away, the same shape the graph tests
+// use. Every instruction pair is its own block, so block lookups dominate
+std::vector<char> make_state_machine(uint32_t num_blocks) {
+  std::vector<char> code;
+  auto push_be = [&code](uint32_t word) {
+    code.push_back(static_cast<char>(word >> 24));
+    code.push_back(static_cast<char>(word >> 16));
+    code.push_back(static_cast<char>(word >> 8));
+    code.push_back(static_cast<char>(word));
+  };
+  for (uint32_t i = 0; i < num_blocks; i++) {
+    const int64_t spread = static_cast<int64_t>((i * 7919 + 3) % 2001) - 1000;
+    const int64_t target_block = std::clamp<int64_t>(i + spread, 0, num_blocks - 1);
+    push_be(addi(3, 3, 1));
+    push_be(beq(static_cast<int32_t>(target_block * 8) - static_cast<int32_t>(i * 8 + 4)));
+  }
+  push_be(kBlr);
+  return code;
+}
+
+void run(uint32_t num_blocks) {
+  std::vector<char> code = make_state_machine(num_blocks);
+  BinaryContext ctx = create_raw(kFunctionBase, kFunctionBase, code.data(), code.size());
+
+  double best = 0;
+  size_t num_vertices = 0;
+  for (int round = 0; round < kRounds; round++) {
+    Subroutine routine;
+    const auto start = std::chrono::steady_clock::now();
+    run_graph_analysis(routine, ctx, kFunctionBase);
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    best = round == 0 ? secs : std::min(best, secs);
+    num_vertices = routine._graph->size();
+  }
+  fmt::print("graph analysis {:>7} blocks {:>7} vertices, {:.4f}s ({:.1f}ns/block)\n",
+    num_blocks,
+    num_vertices,
+    best,
+    1e9 * best / num_blocks);
+}
+}  // namespace
+
+int main() {
+  for (uint32_t num_blocks : {2500u, 20000u, 80000u}) {
+    run(num_blocks);
+  }
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ppc/BinaryContext.hh"
+#include "ppc/RegisterLiveness.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+constexpr uint32_t kBlr = 0x4e800020;
+constexpr size_t kNumFunctions = 2000;
+constexpr int kMaxLoopDepth = 5;
+
+constexpr uint32_t dform(uint32_t op, uint32_t rd, uint32_t ra, int16_t simm) {
+  return (op << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t add(uint32_t rd, uint32_t ra, uint32_t rb) {
+  return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (266 << 1);
+}
+constexpr uint32_t fadd(uint32_t frd, uint32_t fra, uint32_t frb) {
+  return (63 << 26) | (frd << 21) | (fra << 16) | (frb << 11) | (21 << 1);
+}
+constexpr uint32_t cmpwi(uint32_t crf, uint32_t ra, int16_t simm) { return dform(11, crf << 2, ra, simm); }
+constexpr uint32_t bc(uint32_t bo, uint32_t bi, int32_t rel) {
+  return (16 << 26) | (bo << 21) | (bi << 16) | (static_cast<uint32_t>(rel) & 0xfffc);
+}
+
+// Loop nests like the ones in unrolled math and collision code: several levels deep, with conditional skips inside
+// every level and values moving between a small pool of registers
+struct Generator {
+  std::mt19937 _rng{0x5eed};
+  std::vector<uint32_t> _words;
+
+  uint32_t pick(uint32_t n) { return static_cast<uint32_t>(_rng() % n); }
+  uint32_t gpr() { return 3 + pick(10); }
+  uint32_t fpr() { return 1 + pick(8); }
+
+  void straight() {
+    switch (pick(4)) {
+      case 0:
+        _words.push_back(add(gpr(), gpr(), gpr()));
+        break;
+      case 1:
+        _words.push_back(dform(14, gpr(), gpr(), static_cast<int16_t>(pick(64))));
+        break;
+      case 2:
+        _words.push_back(fadd(fpr(), fpr(), fpr()));
+        break;
+      default:
+        _words.push_back(cmpwi(pick(8), gpr(), static_cast<int16_t>(pick(16))));
+        break;
+    }
+  }
+
+  void body(int depth) {
+    const uint32_t len = 3 + pick(6);
+    for (uint32_t i = 0; i < len; i++) {
+      const uint32_t kind = pick(8);
+      if (kind < 2 && depth < kMaxLoopDepth) {
+        loop(depth + 1);
+      } else if (kind < 4) {
+        const size_t branch = _words.size();
+        _words.push_back(0);
+        for (uint32_t skipped = 1 + pick(3); skipped > 0; skipped--) {
+          straight();
+        }
+        _words[branch] = bc(pick(2) == 0 ? 12 : 4, pick(32), static_cast<int32_t>(4 * (_words.size() - branch)));
+      } else {
+        straight();
+      }
+    }
+  }
+
+  void loop(int depth) {
+    const size_t head = _words.size();
+    body(depth);
+    const uint32_t crf = pick(8);
+    _words.push_back(cmpwi(crf, gpr(), static_cast<int16_t>(pick(16))));
+    const size_t latch = _words.size();
+    _words.push_back(bc(4, crf * 4 + 2, -static_cast<int32_t>(4 * (latch - head))));
+  }
+
+  uint32_t function() {
+    const uint32_t start = kProgramBase + static_cast<uint32_t>(4 * _words.size());
+    body(0);
+    _words.push_back(kBlr);
+    return start;
+  }
+};
+
+void run(char const* name, BinaryContext const& ctx, std::vector<uint32_t> const& starts, LivenessSolver solver) {
+  std::vector<Subroutine> routines(starts.size());
+  size_t num_blocks = 0;
+  for (size_t i = 0; i < starts.size(); i++) {
+    run_graph_analysis(routines[i], ctx, starts[i]);
+    num_blocks += routines[i]._graph->size();
+  }
+
+  LivenessStats stats;
+  const auto start = std::chrono::steady_clock::now();
+  uint32_t sink = 0;
+  for (Subroutine& routine : routines) {
+    run_liveness_analysis(routine, ctx, {}, solver, &stats);
+    sink ^= routine._gpr_param._set ^ routine._fpr_param._set ^ routine._gpr_clobber._set;
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const double secs = std::chrono::duration<double>(end - start).count();
+  fmt::print("{:<12} {:>10} propagate + {:>10} backpropagate visits ({:.2f}/vertex), {:.3f}s, checksum {:08x}\n",
+    name,
+    stats._propagate_visits,
+    stats._backpropagate_visits,
+    static_cast<double>(stats._propagate_visits + stats._backpropagate_visits) / num_blocks,
+    secs,
+    sink);
+}
+}  // namespace
+
+int main() {
+  Generator gen;
+  std::vector<uint32_t> starts;
+  for (size_t i = 0; i < kNumFunctions; i++) {
+    starts.push_back(gen.function());
+  }
+
+  std::vector<char> code;
+  code.reserve(4 * gen._words.size());
+  for (uint32_t word : gen._words) {
+    code.push_back(static_cast<char>(word >> 24));
+    code.push_back(static_cast<char>(word >> 16));
+    code.push_back(static_cast<char>(word >> 8));
+    code.push_back(static_cast<char>(word));
+  }
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  run("full sweep", ctx, starts, LivenessSolver::kFullSweep);
+  run("worklist", ctx, starts, LivenessSolver::kWorklist);
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "producers/SectionedData.hh"
+#include "utl/IntervalTree.hh"
+
+using namespace decomp;
+
+namespace {
+// Mirrors a retail DOL layout: a handful of text sections followed by data sections
+constexpr uint32_t kSectionBases[] = {0x80003100, 0x80005560, 0x803a2000, 0x803a4f00, 0x803c0000, 0x80410000};
+constexpr uint32_t kSectionSizes[] = {0x2460, 0x39c8a0, 0x2e00, 0x1b100, 0x4f800, 0x2c000};
+constexpr size_t kNumReads = 1 << 24;
+
+// The interval tree lookup SectionedData used before the flat page table
+uint32_t tree_read_word(dinterval_tree<Section> const& regions, uint32_t address) {
+  Section const* sect = regions.query(address, address + 4);
+  if (sect == nullptr || !sect->contains(address) || !sect->contains(address + 3)) {
+    return 0;
+  }
+
+  uint32_t ret;
+  uint8_t* t_write = reinterpret_cast<uint8_t*>(&ret) + 4;
+  for (size_t i = 0; i < 4; i++) {
+    *--t_write = sect->_data[i + (address - sect->_base)];
+  }
+  return ret;
+}
+
+template <typename ReadFn>
+void run(char const* name, std::vector<uint32_t> const& addrs, ReadFn&& read) {
+  const auto start = std::chrono::steady_clock::now();
+  uint32_t sink = 0;
+  for (uint32_t addr : addrs) {
+    sink ^= read(addr);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const double secs = std::chrono::duration<double>(end - start).count();
+  fmt::print("{:<24} {:>8.2f} Mreads/s  ({:.3f}s, checksum {:08x})\n", name, addrs.size() / secs / 1e6, secs, sink);
+}
+}  // namespace
+
+int main() {
+  std::mt19937 rng(0x5eed);
+
+  SectionedData table_data;
+  dinterval_tree<Section> tree_data;
+  for (size_t i = 0; i < std::size(kSectionBases); i++) {
+    std::vector<uint8_t> bytes(kSectionSizes[i]);
+    for (uint8_t& b : bytes) {
+      b = static_cast<uint8_t>(rng());
+    }
+    tree_data.try_emplace(kSectionBases[i], kSectionBases[i] + bytes.size(), kSectionBases[i], std::vector(bytes));
+    table_data.add_section(kSectionBases[i], std::move(bytes));
+  }
+
+  // Sequential sweep over the big text section (CFG construction, pattern scans) and random word reads
+  // across all sections (liveness, data references)
+  std::vector<uint32_t> sequential, random;
+  sequential.reserve(kNumReads);
+  random.reserve(kNumReads);
+  for (size_t i = 0; i < kNumReads; i++) {
+    sequential.push_back(kSectionBases[1] + static_cast<uint32_t>((i * 4) % kSectionSizes[1]));
+    const size_t sect = rng() % std::size(kSectionBases);
+    random.push_back(kSectionBases[sect] + (rng() % (kSectionSizes[sect] / 4)) * 4);
+  }
+
+  RandomAccessData const& ram = table_data;
+  run("tree, sequential", sequential, [&](uint32_t addr) { return tree_read_word(tree_data, addr); });
+  run("page table, sequential", sequential, [&](uint32_t addr) { return ram.read_word(addr); });
+  run("tree, random", random, [&](uint32_t addr) { return tree_read_word(tree_data, addr); });
+  run("page table, random", random, [&](uint32_t addr) { return ram.read_word(addr); });
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "AllocationCounter.hh"
+#include "hll/SemanticPreservingStructurizer.hh"
+#include "ir/GekkoTranslator.hh"
+#include "ppc/BinaryContext.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+constexpr uint32_t kBlr = 0x4e800020;
+constexpr size_t kNumFunctions = 2000;
+constexpr size_t kNumLargeFunctions = 4;
+constexpr uint32_t kLargeBodyLength = 1500;
+constexpr int kMaxNesting = 3;
+
+constexpr uint32_t dform(uint32_t op, uint32_t rd, uint32_t ra, int16_t simm) {
+  return (op << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t add(uint32_t rd, uint32_t ra, uint32_t rb) {
+  return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (266 << 1);
+}
+constexpr uint32_t cmpwi(uint32_t crf, uint32_t ra, int16_t simm) { return dform(11, crf << 2, ra, simm); }
+constexpr uint32_t bc(uint32_t bo, uint32_t bi, int32_t rel) {
+  return (16 << 26) | (bo << 21) | (bi << 16) | (static_cast<uint32_t>(rel) & 0xfffc);
+}
+constexpr uint32_t b(int32_t rel) { return (18 << 26) | (static_cast<uint32_t>(rel) & 0x3fffffc); }
+
+// Branchy function bodies: if, if-else and short-circuited conditions nested inside each other, with a few loops the
+// acyclic passes have to work around
+struct Generator {
+  std::mt19937 _rng{0x57c7};
+  std::vector<uint32_t> _words;
+
+  uint32_t pick(uint32_t n) { return static_cast<uint32_t>(_rng() % n); }
+  uint32_t gpr() { return 3 + pick(10); }
+
+  void straight() {
+    if (pick(2) == 0) {
+      _words.push_back(add(gpr(), gpr(), gpr()));
+    } else {
+      _words.push_back(dform(14, gpr(), gpr(), static_cast<int16_t>(pick(64))));
+    }
+  }
+
+  int32_t offset_to(size_t from) const { return static_cast<int32_t>(4 * (_words.size() - from)); }
+
+  void condition() {
+    const uint32_t crf = pick(8);
+    _words.push_back(cmpwi(crf, gpr(), static_cast<int16_t>(pick(16))));
+    _words.push_back(crf * 4 + pick(3));
+  }
+
+  // Condition bits are stashed in the branch slot until the target is known
+  uint32_t branch_slot() {
+    condition();
+    return static_cast<uint32_t>(_words.size() - 1);
+  }
+  void patch(uint32_t slot, uint32_t bo) { _words[slot] = bc(bo, _words[slot], offset_to(slot)); }
+
+  void statement(int depth) {
+    const uint32_t kind = pick(10);
+    if (kind < 3 || depth == kMaxNesting) {
+      straight();
+    } else if (kind < 5) {
+      const uint32_t skip = branch_slot();
+      body(depth + 1, 1 + pick(2));
+      patch(skip, pick(2) == 0 ? 12 : 4);
+    } else if (kind < 7) {
+      const uint32_t to_else = branch_slot();
+      body(depth + 1, 1 + pick(2));
+      const size_t to_end = _words.size();
+      _words.push_back(0);
+      patch(to_else, 4);
+      body(depth + 1, 1 + pick(2));
+      _words[to_end] = b(offset_to(to_end));
+    } else if (kind < 9) {
+      std::vector<uint32_t> skips;
+      for (uint32_t terms = 2 + pick(3); terms > 0; terms--) {
+        skips.push_back(branch_slot());
+      }
+      body(depth + 1, 1 + pick(2));
+      const uint32_t bo = pick(2) == 0 ? 12 : 4;
+      for (uint32_t skip : skips) {
+        patch(skip, bo);
+      }
+    } else {
+      const size_t head = _words.size();
+      body(depth + 1, 1 + pick(3));
+      condition();
+      const size_t latch = _words.size() - 1;
+      _words[latch] = bc(12, _words[latch], -static_cast<int32_t>(4 * (latch - head)));
+    }
+  }
+
+  void body(int depth, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+      statement(depth);
+    }
+    straight();
+  }
+
+  uint32_t function(uint32_t len) {
+    const uint32_t start = kProgramBase + static_cast<uint32_t>(4 * _words.size());
+    body(0, len);
+    _words.push_back(kBlr);
+    return start;
+  }
+};
+
+// translate_subroutine is still a work in progress, the structurizer only looks at the block shape so that is copied
+// straight over from the subroutine graph
+std::vector<ir::IrRoutine> load(BinaryContext const& ctx, std::vector<uint32_t> const& starts, size_t& num_blocks) {
+  std::vector<ir::IrRoutine> routines;
+  for (uint32_t start : starts) {
+    Subroutine routine;
+    run_graph_analysis(routine, ctx, start);
+    ir::IrRoutine& ir = routines.emplace_back(routine);
+    for (size_t i = 0; i < routine._graph->size(); i++) {
+      ir._graph.vertex(i)->_out = routine._graph->vertex(i)->_out;
+      ir._graph.vertex(i)->_in = routine._graph->vertex(i)->_in;
+    }
+    num_blocks += routine._graph->size();
+  }
+  return routines;
+}
+
+void run(char const* name, std::vector<ir::IrRoutine> const& routines, size_t num_blocks) {
+  size_t reduced = 0;
+  const size_t allocations_before = allocation_count();
+  const auto start = std::chrono::steady_clock::now();
+  for (ir::IrRoutine const& routine : routines) {
+    hll::SemanticPreservingStructurizer sps;
+    reduced += hll::run_control_flow_analysis(&sps, routine)._root != hll::kInvalidACNRef;
+  }
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const size_t allocations = allocation_count() - allocations_before;
+  fmt::print("{:<16} {:>5} routines, {:>7} blocks, {:>5} fully reduced, {:>9} allocations ({:.2f}/block), {:.3f}s\n",
+    name,
+    routines.size(),
+    num_blocks,
+    reduced,
+    allocations,
+    static_cast<double>(allocations) / num_blocks,
+    secs);
+}
+}  // namespace
+
+int main() {
+  Generator gen;
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> large_starts;
+  for (size_t i = 0; i < kNumFunctions; i++) {
+    starts.push_back(gen.function(2 + gen.pick(10)));
+  }
+  for (size_t i = 0; i < kNumLargeFunctions; i++) {
+    large_starts.push_back(gen.function(kLargeBodyLength));
+  }
+
+  std::vector<char> code;
+  code.reserve(4 * gen._words.size());
+  for (uint32_t word : gen._words) {
+    code.push_back(static_cast<char>(word >> 24));
+    code.push_back(static_cast<char>(word >> 16));
+    code.push_back(static_cast<char>(word >> 8));
+    code.push_back(static_cast<char>(word));
+  }
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  size_t num_blocks = 0;
+  size_t num_large_blocks = 0;
+  const std::vector<ir::IrRoutine> routines = load(ctx, starts, num_blocks);
+  const std::vector<ir::IrRoutine> large_routines = load(ctx, large_starts, num_large_blocks);
+  run("sps", routines, num_blocks);
+  run("sps large", large_routines, num_large_blocks);
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+#include "AnalysisPipeline.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "ppc/Perilogue.hh"
+#include "ppc/RegisterLiveness.hh"
+#include "utl/ParallelFor.hh"
+
+namespace decomp {
+namespace {
+// Every pass the pipeline can run, in the order they run
+constexpr ppc::PassRequirements const* kPasses[] = {
+  &ppc::kGraphPass,
+  &ppc::kLivenessPass,
+  &ppc::kStackPass,
+  &ppc::kPeriloguePass,
+  &ir::kTranslatePass,
+};
+
+// Rows of the report
+enum PassRow : size_t {
+  kGraphRow,
+  kLivenessRow,
+  kFprLivenessRow,
+  kCrLivenessRow,
+  kStackRow,
+  kPerilogueRow,
+  kTranslateRow,
+  kNumRows,
+};
+
+struct PassCounters {
+  std::atomic<size_t> _ran = 0;
+  std::atomic<size_t> _skipped = 0;
+  std::atomic<int64_t> _nanos = 0;
+};
+using PipelineCounters = std::array<PassCounters, kNumRows>;
+
+bool has_products(ppc::Subroutine const& routine, ppc::AnalysisProduct products) {
+  return (routine._products & products) == products;
+}
+
+template <typename Fn>
+void run_timed(PassCounters& counters, Fn&& fn) {
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto end = std::chrono::steady_clock::now();
+  counters._nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  counters._ran++;
+}
+
+void analyze_function(
+  ppc::BinaryContext const& ctx, FunctionAnalysis& slot, ppc::AnalysisProduct needed, PipelineCounters& counters) {
+  ppc::Subroutine& routine = slot._routine;
+  if (check_flags(needed, ppc::kGraphPass._produces)) {
+    if (has_products(routine, ppc::kGraphPass._produces)) {
+      counters[kGraphRow]._skipped++;
+    } else {
+      run_timed(counters[kGraphRow], [&] { ppc::run_graph_analysis(routine, ctx, routine._start_va); });
+    }
+  }
+  if (check_flags(needed, ppc::kLivenessPass._produces)) {
+    if (has_products(routine, ppc::kLivenessPass._produces)) {
+      counters[kLivenessRow]._skipped++;
+    } else {
+      ppc::LivenessStats stats;
+      run_timed(counters[kLivenessRow],
+        [&] { ppc::run_liveness_analysis(routine, ctx, {}, ppc::LivenessSolver::kWorklist, &stats); });
+      counters[kFprLivenessRow]._ran += 1 - stats._skipped_fpr;
+      counters[kFprLivenessRow]._skipped += stats._skipped_fpr;
+      counters[kCrLivenessRow]._ran += 1 - stats._skipped_cr;
+      counters[kCrLivenessRow]._skipped += stats._skipped_cr;
+    }
+  }
+  if (check_flags(needed, ppc::kStackPass._produces)) {
+    if (has_products(routine, ppc::kStackPass._produces)) {
+      counters[kStackRow]._skipped++;
+    } else if (!ppc::references_stack(routine)) {
+      // An empty stack is exactly what the pass would find
+      routine._stack = std::make_unique<ppc::SubroutineStack>();
+      routine._products = routine._products | ppc::kStackPass._produces;
+      counters[kStackRow]._skipped++;
+    } else {
+      run_timed(counters[kStackRow], [&] { ppc::run_stack_analysis(routine); });
+    }
+  }
+  if (check_flags(needed, ppc::kPeriloguePass._produces)) {
+    if (has_products(routine, ppc::kPeriloguePass._produces)) {
+      counters[kPerilogueRow]._skipped++;
+    } else {
+      run_timed(counters[kPerilogueRow], [&] { ppc::run_perilogue_analysis(routine, ctx); });
+    }
+  }
+  if (check_flags(needed, ir::kTranslatePass._produces)) {
+    if (slot._ir.has_value()) {
+      counters[kTranslateRow]._skipped++;
+    } else {
+      run_timed(counters[kTranslateRow], [&] { slot._ir.emplace(ir::translate_subroutine(routine)); });
+    }
+  }
+}
+
+PipelineReport make_report(PipelineCounters const& counters, ppc::AnalysisProduct needed) {
+  constexpr std::array<char const*, kNumRows> kRowNames = {ppc::kGraphPass._name,
+    ppc::kLivenessPass._name,
+    "fpr liveness",
+    "cr liveness",
+    ppc::kStackPass._name,
+    ppc::kPeriloguePass._name,
+    ir::kTranslatePass._name};
+  constexpr std::array<ppc::AnalysisProduct, kNumRows> kRowProducts = {ppc::kGraphPass._produces,
+    ppc::kLivenessPass._produces,
+    ppc::kLivenessPass._produces,
+    ppc::kLivenessPass._produces,
+    ppc::kStackPass._produces,
+    ppc::kPeriloguePass._produces,
+    ir::kTranslatePass._produces};
+
+  PipelineReport report;
+  for (size_t row = 0; row < kNumRows; row++) {
+    if (!check_flags(needed, kRowProducts[row])) {
+      continue;
+    }
+    report._passes.push_back({
+      kRowNames[row],
+      counters[row]._ran.load(),
+      counters[row]._skipped.load(),
+      static_cast<double>(counters[row]._nanos.load()) / 1e9,
+    });
+  }
+  return report;
+}
+}  // namespace
+
+ppc::AnalysisProduct required_products(ppc::AnalysisProduct requested) {
+  ppc::AnalysisProduct needed = requested;
+  for (auto it = std::rbegin(kPasses); it != std::rend(kPasses); it++) {
+    if (check_flags(needed, (*it)->_produces)) {
+      needed = needed | (*it)->_consumes;
+    }
+  }
+  return needed;
+}
+
+PipelineReport run_pipeline(ppc::BinaryContext const& ctx,
+  std::span<FunctionAnalysis> functions,
+  ppc::AnalysisProduct requested,
+  size_t num_threads) {
+  const ppc::AnalysisProduct needed = required_products(requested);
+  PipelineCounters counters;
+  parallel_for(functions.size(), num_threads, [&ctx, functions, needed, &counters](size_t i) {
+    analyze_function(ctx, functions[i], needed, counters);
+  });
+  return make_report(counters, needed);
+}
+
+std::vector<FunctionAnalysis> run_pipeline(ppc::BinaryContext const& ctx,
+  std::span<uint32_t const> starts,
+  ppc::AnalysisProduct requested,
+  size_t num_threads) {
+  std::vector<FunctionAnalysis> functions(starts.size());
+  for (size_t i = 0; i < starts.size(); i++) {
+    functions[i]._routine._start_va = starts[i];
+  }
+  run_pipeline(ctx, functions, requested, num_threads);
+  return functions;
+}
+}  // namespace decomp
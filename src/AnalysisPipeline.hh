@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "ir/GekkoTranslator.hh"
+#include "ppc/BinaryContext.hh"
+#include "ppc/Subroutine.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+
+namespace decomp {
+// Results for one function, only the worker analyzing it ever writes here
+struct FunctionAnalysis {
+  ppc::Subroutine _routine;
+  std::optional<ir::IrRoutine> _ir;
+};
+
+// Time spent in one pass over a whole pipeline run. A pass is skipped for a function when its results are already
+// there or when the function has nothing the pass could find, like a stack without any r1 references
+struct PassTiming {
+  char const* _name;
+  size_t _ran = 0;
+  size_t _skipped = 0;
+  double _seconds = 0;
+};
+
+// Per pass timing in pipeline order, one row for every pass that was needed. FPR and CR liveness get their own rows
+// since they can be skipped separately, their time is counted in the liveness row
+struct PipelineReport {
+  std::vector<PassTiming> _passes;
+};
+
+// The requested products plus everything the passes producing them consume, following the requirements each pass
+// declares
+ppc::AnalysisProduct required_products(ppc::AnalysisProduct requested);
+
+// Runs every pass needed for the requested products on every slot across num_threads workers, 0 picks the hardware
+// thread count. Passes whose products a slot already has are skipped. BinaryContext is only read, and since each slot
+// is produced independently the results don't depend on thread count or scheduling
+PipelineReport run_pipeline(ppc::BinaryContext const& ctx,
+  std::span<FunctionAnalysis> functions,
+  ppc::AnalysisProduct requested,
+  size_t num_threads = 0);
+// One slot per start address, in the same order
+std::vector<FunctionAnalysis> run_pipeline(ppc::BinaryContext const& ctx,
+  std::span<uint32_t const> starts,
+  ppc::AnalysisProduct requested,
+  size_t num_threads = 0);
+}  // namespace decomp
@@ -2,22 +2,28 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <set>
 
+#include "AnalysisPipeline.hh"
 #include "dbgutil/Disassembler.hh"
 #include "dbgutil/IrPrinter.hh"
 #include "ir/GekkoTranslator.hh"
 #include "hll/Function.hh"
 #include "ppc/BinaryContext.hh"
+#include "ppc/InterproceduralLiveness.hh"
 #include "ppc/Perilogue.hh"
+#include "ppc/ProgramDiscovery.hh"
 #include "ppc/RegisterLiveness.hh"
 #include "ppc/Subroutine.hh"
 #include "ppc/SubroutineStack.hh"
 #include "producers/DolData.hh"
 #include "utl/LaunchCommand.hh"
+#include "utl/MappedFile.hh"
 #include "utl/VariantOverloaded.hh"
 
 namespace decomp {
@@ -35,6 +41,10 @@ char const* color_for_type(BlockTransfer type) {
       return "black";
   }
 }
+
+ppc::BinaryType binary_type_for_path(std::string_view path) {
+  return path.ends_with(".elf") ? ppc::BinaryType::kELF : ppc::BinaryType::kDOL;
+}
 }
 
 int test_cmd(CommandParamList const& cpl) {
@@ -43,26 +53,17 @@ int test_cmd(CommandParamList const& cpl) {
   BinaryContext ctx;
   {
     char const* path = "test.elf";
-    std::ifstream file_in(path, std::ios::binary);
-    if (!file_in.is_open()) {
-      std::cerr << fmt::format("Failed to open path {}\n", path);
-      return 1;
-    }
-
-    ErrorOr<BinaryContext> result = create_from_stream(file_in, BinaryType::kELF);
+    ErrorOr<BinaryContext> result = create_from_path(path, BinaryType::kELF);
     if (result.is_error()) {
       std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, result.err());
       return 1;
     }
     ctx = std::move(result.val());
   }
-  Subroutine subroutine;
-  run_graph_analysis(subroutine, ctx, 0x10000);
-
-  run_liveness_analysis(subroutine, ctx);
-  run_stack_analysis(subroutine);
-  run_perilogue_analysis(subroutine, ctx);
-  ir::IrRoutine irr = ir::translate_subroutine(subroutine);
+  constexpr uint32_t kAnalysisStart = 0x10000;
+  std::vector<FunctionAnalysis> functions =
+    run_pipeline(ctx, std::span<uint32_t const>(&kAnalysisStart, 1), AnalysisProduct::kIr, 1);
+  ir::IrRoutine const& irr = *functions[0]._ir;
 
   for (size_t i = 0; i < irr._gpr_binds.ntemps(); i++) {
     ir::BindInfo<GPR> const* bi = irr._gpr_binds.get_temp(i);
@@ -87,13 +88,7 @@ int summarize_subroutine(CommandParamList const& cpl) {
   BinaryContext ctx;
   {
     std::string const& path = cpl.param_v<std::string>(0);
-    std::ifstream file_in(path, std::ios::binary);
-    if (!file_in.is_open()) {
-      std::cerr << fmt::format("Failed to open path {}\n", path);
-      return 1;
-    }
-
-    ErrorOr<BinaryContext> result = create_from_stream(file_in, BinaryType::kDOL);
+    ErrorOr<BinaryContext> result = create_from_path(path, BinaryType::kDOL);
     if (result.is_error()) {
       std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, result.err());
       return 1;
@@ -101,11 +96,9 @@ int summarize_subroutine(CommandParamList const& cpl) {
 
     ctx = std::move(result.val());
   }
-  Subroutine subroutine;
-
-  run_graph_analysis(subroutine, ctx, analysis_start);
-  run_liveness_analysis(subroutine, ctx);
-  run_stack_analysis(subroutine);
+  std::vector<FunctionAnalysis> functions =
+    run_pipeline(ctx, std::span<uint32_t const>(&analysis_start, 1), AnalysisProduct::kAll, 1);
+  Subroutine const& subroutine = functions[0]._routine;
 
   constexpr auto types_list = [](TypeSet ts) {
     reserved_vector<char const*, 5> types;
@@ -151,11 +144,11 @@ int summarize_subroutine(CommandParamList const& cpl) {
     }
   }
 
-  subroutine._graph->foreach_real([](BasicBlockVertex& bbv) {
+  subroutine._graph->foreach_real([](BasicBlockVertex const& bbv) {
     ppc::BasicBlock const& block = bbv.data();
     std::cout << fmt::format("Block 0x{:08x} -- 0x{:08x}\n", block._block_start, block._block_end);
 
-    GprLiveness* rlt = block._gpr_lifetimes.get();
+    GprLiveness const* rlt = block._gpr_lifetimes.get();
     std::cout << "  Input regs: ";
     for (uint32_t i = 0; i < 32; i++) {
       if (rlt->_input.in_set(static_cast<GPR>(i))) {
@@ -178,9 +171,7 @@ int summarize_subroutine(CommandParamList const& cpl) {
     std::cout << "\n";
   });
 
-  run_perilogue_analysis(subroutine, ctx);
-  ir::IrRoutine irg = ir::translate_subroutine(subroutine);
-
+  ir::IrRoutine const& irg = *functions[0]._ir;
   for (size_t i = 0; i < irg._gpr_binds.ntemps(); i++) {
     ir::BindInfo<GPR> const* bi = irg._gpr_binds.get_temp(i);
     std::cout << fmt::format("Bind t{} on gpr r{} over range(s):", bi->_num, static_cast<uint8_t>(bi->_reg));
@@ -199,13 +190,7 @@ int dump_dotfile(CommandParamList const& cpl) {
   BinaryContext ctx;
   {
     std::string const& path = cpl.param_v<std::string>(0);
-    std::ifstream file_in(path, std::ios::binary);
-    if (!file_in.is_open()) {
-      std::cerr << fmt::format("Failed to open path {}\n", path);
-      return 1;
-    }
-
-    ErrorOr<BinaryContext> result = create_from_stream(file_in, BinaryType::kDOL);
+    ErrorOr<BinaryContext> result = create_from_path(path, BinaryType::kDOL);
     if (result.is_error()) {
       std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, result.err());
       return 1;
@@ -214,8 +199,9 @@ int dump_dotfile(CommandParamList const& cpl) {
     ctx = std::move(result.val());
   }
 
-  Subroutine subroutine;
-  run_graph_analysis(subroutine, ctx, analysis_start);
+  std::vector<FunctionAnalysis> functions =
+    run_pipeline(ctx, std::span<uint32_t const>(&analysis_start, 1), AnalysisProduct::kGraph, 1);
+  Subroutine const& subroutine = functions[0]._routine;
 
   std::string const& dot_path = cpl.option_v<std::string>("out");
   std::ofstream dotfile_out(dot_path, std::ios::trunc);
@@ -231,7 +217,7 @@ int dump_dotfile(CommandParamList const& cpl) {
     uint32_t i = 0;
     for (auto& inst : block._instructions) {
       dotfile_out << fmt::format("{:08x}  ", block._block_start + 4 * i);
-      write_inst_disassembly(inst, dotfile_out);
+      write_inst_disassembly(inst.expand(), dotfile_out);
       dotfile_out << "\\l";
       i++;
     }
@@ -256,17 +242,115 @@ int dump_dotfile(CommandParamList const& cpl) {
   return 0;
 }
 
+int list_functions(CommandParamList const& cpl) {
+  using namespace ppc;
+
+  BinaryContext ctx;
+  {
+    std::string const& path = cpl.param_v<std::string>(0);
+    ErrorOr<BinaryContext> result = create_from_path(path, binary_type_for_path(path));
+    if (result.is_error()) {
+      std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, result.err());
+      return 1;
+    }
+
+    ctx = std::move(result.val());
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  ErrorOr<FunctionTable> table = discover_program(ctx, cpl.option_v<uint32_t>("threads"));
+  const auto end = std::chrono::steady_clock::now();
+  if (table.is_error()) {
+    std::cerr << fmt::format("Function discovery failed, reason: {}\n", table.err());
+    return 1;
+  }
+
+  std::cout << "ADDRESS         BLOCKS          CALLS\n";
+  for (Subroutine const& routine : table.val()._routines) {
+    size_t num_blocks = 0;
+    routine._graph->foreach_real([&num_blocks](BasicBlockVertex const&) { num_blocks++; });
+    std::cout << fmt::format(
+      "{:08x}        {:<16}{}\n", routine._start_va, num_blocks, routine._graph->_direct_calls.size());
+  }
+  std::cout << fmt::format("Discovered {} functions in {:.3f}s\n",
+    table.val()._routines.size(),
+    std::chrono::duration<double>(end - start).count());
+  return 0;
+}
+
+int analyze_program(CommandParamList const& cpl) {
+  using namespace ppc;
+  const uint32_t num_threads = cpl.option_v<uint32_t>("threads");
+
+  BinaryContext ctx;
+  {
+    std::string const& path = cpl.param_v<std::string>(0);
+    ErrorOr<BinaryContext> result = create_from_path(path, binary_type_for_path(path));
+    if (result.is_error()) {
+      std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, result.err());
+      return 1;
+    }
+
+    ctx = std::move(result.val());
+  }
+
+  const auto discovery_start = std::chrono::steady_clock::now();
+  ErrorOr<FunctionTable> table = discover_program(ctx, num_threads);
+  if (table.is_error()) {
+    std::cerr << fmt::format("Function discovery failed, reason: {}\n", table.err());
+    return 1;
+  }
+
+  const auto pipeline_start = std::chrono::steady_clock::now();
+  if (cpl.option_v<bool>("interprocedural")) {
+    run_interprocedural_liveness(table.val(), ctx, num_threads);
+  }
+
+  // Discovery already built the graphs, the pipeline picks up from there
+  std::vector<FunctionAnalysis> functions(table.val()._routines.size());
+  for (size_t i = 0; i < functions.size(); i++) {
+    functions[i]._routine = std::move(table.val()._routines[i]);
+  }
+  // Functions that already went through interprocedural liveness skip the per function pass
+  PipelineReport report = run_pipeline(ctx, functions, AnalysisProduct::kMachineLevel, num_threads);
+  const auto end = std::chrono::steady_clock::now();
+
+  std::cout << "ADDRESS         BLOCKS          STACK SIZE      GPR PARAMS\n";
+  for (FunctionAnalysis const& fa : functions) {
+    Subroutine const& routine = fa._routine;
+    size_t num_blocks = 0;
+    routine._graph->foreach_real([&num_blocks](BasicBlockVertex const&) { num_blocks++; });
+    std::cout << fmt::format("{:08x}        {:<16}{:<16x}", routine._start_va, num_blocks, routine._stack->stack_size());
+    for (uint32_t i = 0; i < 32; i++) {
+      if (routine._gpr_param.in_set(static_cast<GPR>(i))) {
+        std::cout << fmt::format("r{} ", i);
+      }
+    }
+    std::cout << "\n";
+  }
+  std::cout << fmt::format("Analyzed {} functions, discovery {:.3f}s, analysis {:.3f}s\n",
+    functions.size(),
+    std::chrono::duration<double>(pipeline_start - discovery_start).count(),
+    std::chrono::duration<double>(end - pipeline_start).count());
+
+  std::cout << "PASS            RAN             SKIPPED         TIME\n";
+  for (PassTiming const& pass : report._passes) {
+    std::cout << fmt::format("{:<16}{:<16}{:<16}{:.3f}s\n", pass._name, pass._ran, pass._skipped, pass._seconds);
+  }
+  return 0;
+}
+
 int print_sections(CommandParamList const& cpl) {
   using namespace ppc;
   DolData dol_data;
   {
     std::string const& path = cpl.param_v<std::string>(0);
-    std::ifstream file_in(path, std::ios::binary);
-    if (!file_in.is_open()) {
-      std::cerr << fmt::format("Failed to open path {}\n", path);
+    ErrorOr<MappedFile> image = MappedFile::open(path);
+    if (image.is_error()) {
+      std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, image.err());
       return 1;
     }
-    if (!dol_data.load_from(file_in)) {
+    if (!dol_data.load_from(std::move(image.val()))) {
       std::cerr << fmt::format("Provided file {} is not a DOL\n", path);
       return 1;
     }
@@ -307,13 +391,7 @@ int linear_dis(CommandParamList const& cpl) {
   BinaryContext ctx;
   {
     std::string const& path = cpl.param_v<std::string>(0);
-    std::ifstream file_in(path, std::ios::binary);
-    if (!file_in.is_open()) {
-      std::cerr << fmt::format("Failed to open path {}\n", path);
-      return 1;
-    }
-
-    ErrorOr<BinaryContext> result = create_from_stream(file_in, BinaryType::kDOL);
+    ErrorOr<BinaryContext> result = create_from_path(path, BinaryType::kDOL);
     if (result.is_error()) {
       std::cerr << fmt::format("Failed to open path {}, reason: {}\n", path, result.err());
       return 1;
@@ -323,9 +401,10 @@ int linear_dis(CommandParamList const& cpl) {
   }
 
   std::cout << "ADDRESS         INST WORD       DISASSEMBLY\n";
+  std::vector<MetaInst> insts = ctx._ram->read_instructions(disassembly_start, std::max(disassembly_len, 0));
   for (int i = 0; i < disassembly_len; i++) {
     uint32_t address = disassembly_start + i * 4;
-    MetaInst inst = ctx._ram->read_instruction(address);
+    MetaInst const& inst = insts[i];
     std::cout << fmt::format("{:08x}        {:08x}        ", address, inst._binst._bytes);
     write_inst_disassembly(inst, std::cout);
     std::cout << "\n";
@@ -6,6 +6,8 @@ namespace decomp {
 int test_cmd(CommandParamList const&);
 int summarize_subroutine(CommandParamList const&);
 int dump_dotfile(CommandParamList const&);
+int list_functions(CommandParamList const&);
+int analyze_program(CommandParamList const&);
 int print_sections(CommandParamList const&);
 int linear_dis(CommandParamList const&);
 }  // namespace decomp
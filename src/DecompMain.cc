@@ -59,6 +59,56 @@ std::vector<LaunchCommand> sCommands = {
     },
     dump_dotfile,
   },
+  LaunchCommand{
+    "functions",
+    "Discover every function reachable from the entrypoint through direct calls and list them",
+    {
+      ParamDesc{
+        "binpath",
+        "Path to the executable to be analyzed (DOL, ELF)",
+        CommandParamType::kPath,
+      },
+    },
+    {
+      OptionDesc{
+        "threads",
+        'j',
+        "Number of worker threads to use for discovery. If 0 or not provided, one per hardware thread",
+        CommandParamType::kU32,
+        uint32_t(0),
+      },
+    },
+    list_functions,
+  },
+  LaunchCommand{
+    "analyze",
+    "Discover every function reachable from the entrypoint and run the machine level analyses on all of them",
+    {
+      ParamDesc{
+        "binpath",
+        "Path to the executable to be analyzed (DOL, ELF)",
+        CommandParamType::kPath,
+      },
+    },
+    {
+      OptionDesc{
+        "threads",
+        'j',
+        "Number of worker threads to use. If 0 or not provided, one per hardware thread",
+        CommandParamType::kU32,
+        uint32_t(0),
+      },
+      OptionDesc{
+        "interprocedural",
+        'i',
+        "Compute register liveness bottom up over the call graph, using each callee's actual parameters and "
+        "clobbers at call sites instead of the ABI contract",
+        CommandParamType::kBoolean,
+        false,
+      },
+    },
+    analyze_program,
+  },
   LaunchCommand{
     "sections",
     "Print out a list of all sections from the specified DOL",
@@ -1,29 +1,40 @@
 #include "hll/GraphSubstitution.hh"
 
-namespace decomp::hll {
-void SeqSubstitutor::substitute() {
-  std::replace(_dom.begin(), _dom.end(), );
-}
+#include <algorithm>
 
-std::vector<int> SeqSubstitutor::membership() {
-}
-
-void IfSubstitutor::substitute() {
+namespace decomp::hll {
+int Substitutor::substitute(RegionLinks& links) {
+  const std::span<int const> members = membership();
+  const int repl_idx = _gr.substitute_region(members, links, _repl);
+  _dom.collapse(members, members.front(), repl_idx);
+  _pdom.collapse(members, members.front(), repl_idx);
+  return repl_idx;
 }
 
-std::vector<int> IfSubstitutor::membership() {
-}
+std::span<int const> SeqSubstitutor::membership() const { return _list; }
 
-void IfElseSubstitutor::substitute() {
-}
+std::span<int const> IfSubstitutor::membership() const { return _members; }
 
-std::vector<int> IfElseSubstitutor::membership() {
-}
+std::span<int const> IfElseSubstitutor::membership() const { return _members; }
 
-void CCondSubstitutor::substitute() {
-}
+int CCondSubstitutor::substitute(RegionLinks& links) {
+  const int repl_idx = Substitutor::substitute(links);
 
-std::vector<int> CCondSubstitutor::membership() {
+  // Exits reached from several members got merged into unconditional edges, put back the combined condition's sense
+  ACNVertex* repl = _gr.vertex(repl_idx);
+  for (EdgeData& out : repl->_out) {
+    auto exit = std::find_if(
+      _exits.begin(), _exits.end(), [&out](EdgeData const& ed) { return ed._target == out._target; });
+    if (exit == _exits.end()) {
+      continue;
+    }
+    ACNVertex* target = _gr.vertex(out._target);
+    auto in = std::find(target->_in.begin(), target->_in.end(), EdgeData(repl_idx, out._tr));
+    in->_tr = exit->_tr;
+    out._tr = exit->_tr;
+  }
+  return repl_idx;
 }
 
-}
+std::span<int const> CCondSubstitutor::membership() const { return _nodes; }
+}  // namespace decomp::hll
@@ -1,82 +1,98 @@
 #pragma once
 
+#include <array>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "hll/Structurizer.hh"
+#include "utl/DominatorTree.hh"
 
 namespace decomp::hll {
-class AbstractControlNode;
-
+// Collapses a matched region of the ACN graph into one vertex holding _repl. Every region is single entry through
+// the first member of membership(), so the dominator and post-dominator trees are patched in place
 struct Substitutor {
-  AbstractControlNode* _repl;
+  ACNRef _repl;
   ACNGraph& _gr;
+  DominatorTree& _dom;
+  DominatorTree& _pdom;
 
-  Substitutor(AbstractControlNode* repl, ACNGraph& gr)
-      : _repl(repl), _gr(gr) {}
+  Substitutor(ACNRef repl, ACNGraph& gr, DominatorTree& dom, DominatorTree& pdom)
+      : _repl(repl), _gr(gr), _dom(dom), _pdom(pdom) {}
 
-  virtual void substitute() = 0;
-  virtual std::vector<int> membership() = 0;
+  // Returns the index of the vertex replacing the region, links is scratch space for the edges being moved
+  virtual int substitute(RegionLinks& links);
+  // Vertex indices of the region, header first. Owned by the substitutor, so the region can be walked without copying
+  virtual std::span<int const> membership() const = 0;
   virtual ~Substitutor() {}
 };
 
 struct SeqSubstitutor : public Substitutor {
-  std::vector<ACNVertex*> _list;
+  std::vector<int> _list;
 
-  SeqSubstitutor(AbstractControlNode* repl,
+  SeqSubstitutor(ACNRef repl,
     ACNGraph& gr,
-    std::vector<ACNVertex*>&& list)
-      : Substitutor(repl, gr), _list(list) {}
+    DominatorTree& dom,
+    DominatorTree& pdom,
+    std::vector<int>&& list)
+      : Substitutor(repl, gr, dom, pdom), _list(std::move(list)) {}
 
-  void substitute() override;
-  std::vector<int> membership() override;
+  std::span<int const> membership() const override;
   ~SeqSubstitutor() override {}
 };
 
 struct IfSubstitutor : public Substitutor {
-  ACNVertex* _hdr;
-  ACNVertex* _true;
-  ACNVertex* _next;
+  // Header then the conditional block
+  std::array<int, 2> _members;
+  int _next;
 
-  IfSubstitutor(AbstractControlNode* repl,
+  IfSubstitutor(ACNRef repl,
     ACNGraph& gr,
-    ACNVertex* hdr,
-    ACNVertex* t,
-    ACNVertex* next)
-      : Substitutor(repl, gr), _hdr(hdr), _true(t), _next(next) {}
-
-  void substitute() override;
-  std::vector<int> membership() override;
+    DominatorTree& dom,
+    DominatorTree& pdom,
+    int hdr,
+    int t,
+    int next)
+      : Substitutor(repl, gr, dom, pdom), _members{hdr, t}, _next(next) {}
+
+  std::span<int const> membership() const override;
   ~IfSubstitutor() override {}
 };
 
 struct IfElseSubstitutor : public Substitutor {
-  ACNVertex* _hdr;
-  ACNVertex* _true;
-  ACNVertex* _false;
-  ACNVertex* _next;
+  // Header, then the true and false blocks
+  std::array<int, 3> _members;
+  int _next;
 
-  IfElseSubstitutor(AbstractControlNode* repl,
+  IfElseSubstitutor(ACNRef repl,
     ACNGraph& gr,
-    ACNVertex* hdr,
-    ACNVertex* t,
-    ACNVertex* f,
-    ACNVertex* next)
-      : Substitutor(repl, gr), _hdr(hdr), _true(t), _false(f), _next(next) {}
-
-  void substitute() override;
-  std::vector<int> membership() override;
+    DominatorTree& dom,
+    DominatorTree& pdom,
+    int hdr,
+    int t,
+    int f,
+    int next)
+      : Substitutor(repl, gr, dom, pdom), _members{hdr, t, f}, _next(next) {}
+
+  std::span<int const> membership() const override;
   ~IfElseSubstitutor() override {}
 };
 
 struct CCondSubstitutor : public Substitutor {
-  std::vector<ACNVertex*> _nodes;
-  CCondSubstitutor(AbstractControlNode* repl,
-    ACNGraph& gr,
-    std::vector<ACNVertex*>&& nodes)
-      : Substitutor(repl, gr), _nodes(nodes) {}
+  std::vector<int> _nodes;
+  // Where the combined condition leads, taken from the last vertex of the reduction
+  std::vector<EdgeData> _exits;
 
-  void substitute() override;
-  std::vector<int> membership() override;
+  CCondSubstitutor(ACNRef repl,
+    ACNGraph& gr,
+    DominatorTree& dom,
+    DominatorTree& pdom,
+    std::vector<int>&& nodes,
+    std::vector<EdgeData>&& exits)
+      : Substitutor(repl, gr, dom, pdom), _nodes(std::move(nodes)), _exits(std::move(exits)) {}
+
+  int substitute(RegionLinks& links) override;
+  std::span<int const> membership() const override;
   ~CCondSubstitutor() override {}
 };
 
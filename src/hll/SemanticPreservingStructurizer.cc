@@ -1,50 +1,88 @@
 #include "hll/SemanticPreservingStructurizer.hh"
 
 #include <algorithm>
-#include <deque>
+#include <cassert>
 #include <iterator>
-#include <unordered_map>
+#include <memory>
+#include <optional>
+#include <span>
 #include <unordered_set>
+#include <variant>
 #include <vector>
 
 #include "hll/GraphSubstitution.hh"
+#include "utl/DominatorTree.hh"
 #include "utl/FlowGraph.hh"
+#include "utl/PostorderList.hh"
+#include "utl/ReachabilityIndex.hh"
 #include "utl/ReservedVector.hh"
 
 namespace decomp::hll {
-struct SPSState {
-  ACNGraph _gr;
-  std::unordered_map<AbstractControlNode*, AbstractControlNode*> _structof;
-  std::vector<int> _post;
-  std::vector<int> _dom;
-  std::vector<int> _pdom;
-};
+// Membership over vertex indices, emptied in O(1) by moving on to a new epoch
+class StampedSet {
+  std::vector<uint32_t> _stamp;
+  uint32_t _epoch = 0;
 
-template <typename T, typename... Us>
-std::unique_ptr<T> build_substitutor(AbstractControlNode* node, SPSState& state, Us&&... args) {
-  return std::make_unique<T>(node, state._gr, state._dom, state._pdom, std::forward<Us>(args)...);
-}
+public:
+  // Empties the set and makes room for indices below size
+  void reset(size_t size) {
+    if (size > _stamp.size()) {
+      _stamp.resize(size, 0);
+    }
+    if (++_epoch == 0) {
+      std::fill(_stamp.begin(), _stamp.end(), 0);
+      _epoch = 1;
+    }
+  }
 
+  bool contains(int num) const { return _stamp[num] == _epoch; }
+  void insert(int num) { _stamp[num] = _epoch; }
+  void erase(int num) { _stamp[num] = 0; }
+};
+
+// Counted set over vertex indices that iterates in insertion order. Entries from before the last reset are stale and
+// read as absent, so resetting doesn't touch the table
 class OutputSet {
   struct Entry {
+    uint32_t _stamp;
     int _ct;
     int _next;
     int _prev;
   };
   std::vector<Entry> _set;
+  uint32_t _epoch = 0;
   int _fst = -1;
   int _lst = -1;
   int _sz = 0;
 
+  Entry& entry(int num) {
+    Entry& e = _set[num];
+    if (e._stamp != _epoch) {
+      e = Entry{_epoch, 0, -1, -1};
+    }
+    return e;
+  }
+
 public:
-  OutputSet(int cap) : _set(cap, Entry{0, 0}) {}
+  // Empties the set and makes room for indices below size
+  void reset(size_t size) {
+    if (size > _set.size()) {
+      _set.resize(size, Entry{0, 0, -1, -1});
+    }
+    if (++_epoch == 0) {
+      std::fill(_set.begin(), _set.end(), Entry{0, 0, -1, -1});
+      _epoch = 1;
+    }
+    _fst = _lst = -1;
+    _sz = 0;
+  }
 
   constexpr int size() const { return _sz; }
 
-  bool contains(int num) const { return _set[num]._ct > 0; }
+  bool contains(int num) const { return _set[num]._stamp == _epoch && _set[num]._ct > 0; }
 
   void add(int num) {
-    Entry& e = _set[num];
+    Entry& e = entry(num);
     if (e._ct++ > 0) {
       return;
     }
@@ -60,7 +98,7 @@ public:
   }
 
   void remove(int num) {
-    Entry& e = _set[num];
+    Entry& e = entry(num);
     if (--e._ct > 0) {
       return;
     }
@@ -103,6 +141,49 @@ public:
   iterator end() const { return iterator(_set, -1); }
 };
 
+// Working buffers the region probes and substitutions keep between calls. A probe resets what it uses rather than
+// allocating, and only a region that matches copies its members out into the substitutor
+struct ProbeScratch {
+  std::vector<ACNVertex*> _pord;
+  StampedSet _in_pord;
+  OutputSet _outset;
+  // Worked through front to back, entries are never popped so a plain vector serves as the queue
+  std::vector<int> _pend;
+  std::vector<std::pair<int, int>> _local;
+  std::vector<int> _seqsub;
+  RegionLinks _links;
+};
+
+struct SPSState {
+  ACNGraph _gr;
+  // Owned here while structurizing, then handed to the resulting tree
+  ACNPool _pool;
+  // Structure each node was last folded into, indexed by node id
+  std::vector<ACNRef> _structof;
+  // Taken once, collapsed regions are spliced into the header's slot so later passes walk it as it stands
+  PostorderList _post;
+  // Both trees are kept exact as regions collapse, only the graph is ever rebuilt from scratch
+  DominatorTree _dom;
+  DominatorTree _pdom;
+  ReachabilityIndex _reach;
+  ProbeScratch _scratch;
+  // Real vertices still in the graph
+  int _live = 0;
+  bool _check_dominators = false;
+  // Substitutions since the trees were last checked
+  int _unchecked = 0;
+  size_t _dominator_checks = 0;
+  size_t _dominator_mismatches = 0;
+};
+
+// A full recompute is O(n), checking after every substitution of a large graph would make structuring quadratic
+constexpr size_t kCheckStrideDivisor = 256;
+
+template <typename T, typename... Us>
+std::unique_ptr<T> build_substitutor(ACNRef node, SPSState& state, Us&&... args) {
+  return std::make_unique<T>(node, state._gr, state._dom, state._pdom, std::forward<Us>(args)...);
+}
+
 // This algorithm is an implementation of the following paper:
 // Tao Wei, Jian Mao, Wei Zou, and Yu Chen. 2007. Structuring 2-way Branches in Binary Executables. In Proceedings of
 // the 31st Annual International Computer Software and Applications Conference - Volume 01 (COMPSAC '07). IEEE Computer
@@ -114,53 +195,73 @@ std::unique_ptr<Substitutor> complex_conditional_type(SPSState& state, ACNVertex
   // Judging cascading conditionals is dependant on better dataflow anlysis, so leaving it as a to-do
   constexpr auto try_compound_conditional = [](SPSState& state, ACNVertex& vert) -> std::unique_ptr<Substitutor> {
     ACNGraph& gr = state._gr;
+    // One of the header's successors always reaches the other in a compound conditional, that rules out most two way
+    // branches before paying for the expansion
+    const int s0 = vert._out[0]._target;
+    const int s1 = vert._out[1]._target;
+    if (!state._reach.reaches(gr, s0, s1) && !state._reach.reaches(gr, s1, s0)) {
+      return nullptr;
+    }
+
     // Expansion phase
-    std::vector<ACNVertex*> pord;
-    std::vector<bool> in_pord(gr.size());
-    OutputSet outset(gr.size());
-    std::deque<int> pend;
+    ProbeScratch& scratch = state._scratch;
+    std::vector<ACNVertex*>& pord = scratch._pord;
+    StampedSet& in_pord = scratch._in_pord;
+    OutputSet& outset = scratch._outset;
+    std::vector<int>& pend = scratch._pend;
+    pord.clear();
+    in_pord.reset(gr.size());
+    outset.reset(gr.size());
+    pend.clear();
     pord.push_back(&vert);
-    in_pord[vert._idx] = true;
+    in_pord.insert(vert._idx);
     pend.push_back(vert._out[0]._target);
     pend.push_back(vert._out[1]._target);
     outset.add(vert._out[0]._target);
     outset.add(vert._out[1]._target);
 
-    while (!pend.empty()) {
-      ACNVertex* cur = gr.vertex(pend.front());
-      pend.pop_front();
+    for (size_t front = 0; front < pend.size(); front++) {
+      ACNVertex* cur = gr.vertex(pend[front]);
 
-      if (!cur->icbs() || in_pord[cur->_idx]) {
+      if (!cur->icbs() || in_pord.contains(cur->_idx)) {
         continue;
       }
       bool incoming_nodes_in_set = true;
       for (auto [target, _] : cur->_in) {
-        incoming_nodes_in_set &= in_pord[target];
+        incoming_nodes_in_set &= in_pord.contains(target);
       }
       if (!incoming_nodes_in_set) {
         continue;
       }
 
       pord.push_back(cur);
-      in_pord[cur->_idx] = true;
+      in_pord.insert(cur->_idx);
       for (auto [target, _] : cur->_out) {
         pend.push_back(target);
+        outset.add(target);
       }
       outset.remove(cur->_idx);
     }
 
     // Contraction phase
-    while (outset.size() != 2) {
+    while (outset.size() != 2 && pord.size() > 1) {
       ACNVertex* removed = pord.back();
       pord.pop_back();
+      in_pord.erase(removed->_idx);
       outset.remove(removed->_out[0]._target);
       outset.remove(removed->_out[1]._target);
       outset.add(removed->_idx);
     }
 
-    if (pord.size() == 1) {
+    if (pord.size() == 1 || outset.size() != 2) {
       return nullptr;
     }
+    // Exits looping back into the region aren't a compound conditional
+    for (int casen : outset) {
+      if (in_pord.contains(casen)) {
+        return nullptr;
+      }
+    }
 
     using ReduceGraph = FlowGraph<std::variant<ACNVertex*, int>>;
     using ReduceVertex = FlowVertex<std::variant<ACNVertex*, int>>;
@@ -173,48 +274,68 @@ std::unique_ptr<Substitutor> complex_conditional_type(SPSState& state, ACNVertex
       EdgeData _n1_n2;
       EdgeData _n1_n3;
     };
+    // ACN index to reduce graph index, for the region and its two exits
+    std::vector<std::pair<int, int>>& local = scratch._local;
+    local.clear();
+    const auto local_idx = [&local](int acn_idx) {
+      return std::find_if(local.begin(), local.end(), [acn_idx](auto const& p) { return p.first == acn_idx; })->second;
+    };
     for (ACNVertex* v : pord) {
-      ccond_gr.emplace_vertex(v);
+      local.emplace_back(v->_idx, ccond_gr.emplace_vertex(v));
     }
     for (int casen : outset) {
-      ccond_gr.emplace_vertex(gr.vertex(casen));
+      local.emplace_back(casen, ccond_gr.emplace_vertex(gr.vertex(casen)));
     }
     for (ACNVertex* v : pord) {
-      ccond_gr.emplace_link(v->_idx, v->_out[0]._target, v->_out[0]._tr);
-      ccond_gr.emplace_link(v->_idx, v->_out[1]._target, v->_out[1]._tr);
+      ccond_gr.emplace_link(local_idx(v->_idx), local_idx(v->_out[0]._target), v->_out[0]._tr);
+      ccond_gr.emplace_link(local_idx(v->_idx), local_idx(v->_out[1]._target), v->_out[1]._tr);
     }
 
     CCond cond_node;
-    while (ccond_gr.size() > 3) {
+    int last = local_idx(vert._idx);
+    for (size_t remaining = pord.size(); remaining > 1; remaining--) {
       std::optional<ReduceData> rdata;
-      ccond_gr.foreach_real([&gr, &ccond_gr, &rdata](ReduceVertex& reduce_candidate) {
+      ccond_gr.foreach_real([&ccond_gr, &rdata](ReduceVertex& reduce_candidate) {
+        // The exits have no out edges of their own
+        if (reduce_candidate._out.size() != 2) {
+          return true;
+        }
         auto e0 = reduce_candidate._out[0];
         auto e1 = reduce_candidate._out[1];
-        auto v0 = gr.vertex(e0._target);
-        auto v1 = gr.vertex(e1._target);
-        if (v0->icbs() && v0->_out[0]._target == e1._target) {
+        auto v0 = ccond_gr.vertex(e0._target);
+        auto v1 = ccond_gr.vertex(e1._target);
+        // n1 can only fold into n0 when n0 is the only way in
+        if (v0->icbs() && v0->single_pred() && v0->_out[0]._target == e1._target) {
           rdata = ReduceData{
+            ._n0 = &reduce_candidate,
+            ._n1 = v0,
             ._n0_n1 = e0,
             ._n0_n2 = e1,
             ._n1_n2 = v0->_out[0],
             ._n1_n3 = v0->_out[1],
           };
-        } else if (v0->icbs() && v0->_out[1]._target == e1._target) {
+        } else if (v0->icbs() && v0->single_pred() && v0->_out[1]._target == e1._target) {
           rdata = ReduceData{
+            ._n0 = &reduce_candidate,
+            ._n1 = v0,
             ._n0_n1 = e0,
             ._n0_n2 = e1,
             ._n1_n2 = v0->_out[1],
             ._n1_n3 = v0->_out[0],
           };
-        } else if (v1->icbs() && v1->_out[0]._target == e0._target) {
+        } else if (v1->icbs() && v1->single_pred() && v1->_out[0]._target == e0._target) {
           rdata = ReduceData{
+            ._n0 = &reduce_candidate,
+            ._n1 = v1,
             ._n0_n1 = e1,
             ._n0_n2 = e0,
             ._n1_n2 = v1->_out[0],
             ._n1_n3 = v1->_out[1],
           };
-        } else if (v1->icbs() && v1->_out[1]._target == e0._target) {
+        } else if (v1->icbs() && v1->single_pred() && v1->_out[1]._target == e0._target) {
           rdata = ReduceData{
+            ._n0 = &reduce_candidate,
+            ._n1 = v1,
             ._n0_n1 = e1,
             ._n0_n2 = e0,
             ._n1_n2 = v1->_out[1],
@@ -222,18 +343,14 @@ std::unique_ptr<Substitutor> complex_conditional_type(SPSState& state, ACNVertex
           };
         }
 
-        if (rdata) {
-          rdata->_n0 = &reduce_candidate;
-          rdata->_n1 = ccond_gr.vertex(rdata->_n0_n1._target);
-          return false;
-        }
-        return true;
+        return !rdata;
       });
 
-      // TODO: remove assertions in this codebase
-      assert(rdata);
+      if (!rdata) {
+        return nullptr;
+      }
 
-      constexpr auto get_rv_data = [](ReduceVertex* rv) -> std::variant<AbstractControlNode*, int> {
+      constexpr auto get_rv_data = [](ReduceVertex* rv) -> std::variant<ACNRef, int> {
         if (std::holds_alternative<ACNVertex*>(rv->data())) {
           return std::get<ACNVertex*>(rv->data())->data();
         } else {
@@ -248,10 +365,27 @@ std::unique_ptr<Substitutor> complex_conditional_type(SPSState& state, ACNVertex
         rdata->_n0_n2._tr != rdata->_n1_n2._tr,
         // If the short-circuit path occurs when true, presume the condition to be an or, otherwise an and
         rdata->_n0_n2._tr == BlockTransfer::kConditionTrue ? CCond::BoolOp::kOr : CCond::BoolOp::kAnd);
-      ccond_gr.substitute_pair(std::make_pair(rdata->_n0->_idx, rdata->_n1->_idx), new_cond_tree_vtx);
+      last = ccond_gr.substitute_pair(std::make_pair(rdata->_n0->_idx, rdata->_n1->_idx), new_cond_tree_vtx);
+
+      // The combined condition takes the short-circuit path on the same sense as n0, and the other exit on the inverse
+      for (EdgeData& out : ccond_gr.vertex(last)->_out) {
+        out._tr = out._target == rdata->_n0_n2._target ? rdata->_n0_n2._tr : invert_condition(rdata->_n0_n2._tr);
+        ReduceVertex* target = ccond_gr.vertex(out._target);
+        std::find_if(target->_in.begin(), target->_in.end(), [last](EdgeData const& ed) {
+          return ed._target == last;
+        })->_tr = out._tr;
+      }
     }
 
-    return build_substitutor<CCondSubstitutor>(new CCond(std::move(cond_node)), state, pord);
+    // Map the final condition's two edges back onto the ACN graph
+    std::vector<EdgeData> exits;
+    for (EdgeData const& out : ccond_gr.vertex(last)->_out) {
+      exits.emplace_back(std::get<ACNVertex*>(ccond_gr.vertex(out._target)->data())->_idx, out._tr);
+    }
+    std::vector<int> members;
+    std::transform(pord.begin(), pord.end(), std::back_inserter(members), [](ACNVertex* v) { return v->_idx; });
+    return build_substitutor<CCondSubstitutor>(
+      state._pool.make<CCond>(std::move(cond_node)), state, std::move(members), std::move(exits));
   };
 
   auto compound_cond = try_compound_conditional(state, vert);
@@ -271,56 +405,70 @@ std::unique_ptr<Substitutor> complex_conditional_type(SPSState& state, ACNVertex
 std::unique_ptr<Substitutor> acyclic_region_type(SPSState& state, ACNVertex& vert) {
   ACNGraph& gr = state._gr;
   {
-    std::vector<AbstractControlNode*> seqlist;
-    std::vector<ACNVertex*> seqsub;
+    std::vector<int>& seqsub = state._scratch._seqsub;
+    seqsub.clear();
+    // Both walks stop short of vert so a ring of single entry, single exit vertices isn't walked forever
     if (vert.single_pred()) {
-      for (ACNVertex* cur = gr.vertex(vert._in[0]._target); cur->sess(); cur = gr.vertex(cur->_in[0]._target)) {
-        seqsub.push_back(cur);
-        seqlist.push_back(cur->data());
+      for (ACNVertex* cur = gr.vertex(vert._in[0]._target); cur != &vert && cur->sess();
+           cur = gr.vertex(cur->_in[0]._target)) {
+        seqsub.push_back(cur->_idx);
       }
     }
 
     std::reverse(seqsub.begin(), seqsub.end());
-    std::reverse(seqlist.begin(), seqlist.end());
-    seqsub.push_back(&vert);
-    seqlist.push_back(vert.data());
+    seqsub.push_back(vert._idx);
 
     if (vert.single_succ()) {
-      for (ACNVertex* cur = gr.vertex(vert._out[0]._target); cur->sess(); cur = gr.vertex(cur->_out[0]._target)) {
-        seqsub.push_back(cur);
-        seqlist.push_back(cur->data());
+      for (ACNVertex* cur = gr.vertex(vert._out[0]._target);
+           cur != &vert && cur->sess() && cur->_idx != seqsub.front();
+           cur = gr.vertex(cur->_out[0]._target)) {
+        seqsub.push_back(cur->_idx);
       }
     }
 
-    if (seqlist.size() > 1) {
-      return build_substitutor<SeqSubstitutor>(new Seq(std::move(seqlist)), state, std::move(seqsub));
+    if (seqsub.size() > 1) {
+      std::vector<ACNRef> seqlist;
+      std::transform(
+        seqsub.begin(), seqsub.end(), std::back_inserter(seqlist), [&gr](int idx) { return gr.vertex(idx)->data(); });
+      return build_substitutor<SeqSubstitutor>(
+        state._pool.make<Seq>(std::move(seqlist)), state, std::vector<int>(seqsub));
     }
   }
 
   if (vert.icbs()) {
     ACNVertex* m = gr.vertex(vert._out[0]._target);
     ACNVertex* n = gr.vertex(vert._out[1]._target);
-    if (m->sess() && n->sess() && gr.vertex(m->_out[0]._target) == gr.vertex(n->_out[0]._target)) {
+    // Case blocks running back into the header are loops, not conditionals
+    if (m == &vert || n == &vert) {
+      return nullptr;
+    }
+    const int m_next = m->single_succ() ? m->_out[0]._target : ACNGraph::kInvalidVertexId;
+    const int n_next = n->single_succ() ? n->_out[0]._target : ACNGraph::kInvalidVertexId;
+    if (m->sess() && n->sess() && m_next == n_next && m_next != vert._idx) {
       if (vert._out[0]._tr == BlockTransfer::kConditionTrue) {
         return build_substitutor<IfElseSubstitutor>(
-          new IfElse(vert.data(), m->data(), n->data()), state, &vert, m, n, gr.vertex(m->_out[0]._target));
+          state._pool.make<IfElse>(vert.data(), m->data(), n->data()), state, vert._idx, m->_idx, n->_idx, m_next);
       } else {
         return build_substitutor<IfElseSubstitutor>(
-          new IfElse(vert.data(), n->data(), m->data()), state, &vert, n, m, gr.vertex(m->_out[0]._target));
+          state._pool.make<IfElse>(vert.data(), n->data(), m->data()), state, vert._idx, n->_idx, m->_idx, m_next);
       }
     }
-    if (m->sess() && gr.vertex(m->_out[0]._target) == n) {
+    if (m->sess() && m_next == n->_idx) {
       if (vert._out[0]._tr == BlockTransfer::kConditionTrue) {
-        return build_substitutor<IfSubstitutor>(new If(vert.data(), m->data(), false), state, &vert, m, n);
+        return build_substitutor<IfSubstitutor>(
+          state._pool.make<If>(vert.data(), m->data(), false), state, vert._idx, m->_idx, n->_idx);
       } else {
-        return build_substitutor<IfSubstitutor>(new If(vert.data(), m->data(), true), state, &vert, m, n);
+        return build_substitutor<IfSubstitutor>(
+          state._pool.make<If>(vert.data(), m->data(), true), state, vert._idx, m->_idx, n->_idx);
       }
     }
-    if (n->sess() && gr.vertex(n->_out[0]._target) == m) {
+    if (n->sess() && n_next == m->_idx) {
       if (vert._out[1]._tr == BlockTransfer::kConditionTrue) {
-        return build_substitutor<IfSubstitutor>(new If(vert.data(), n->data(), false), state, &vert, n, m);
+        return build_substitutor<IfSubstitutor>(
+          state._pool.make<If>(vert.data(), n->data(), false), state, vert._idx, n->_idx, m->_idx);
       } else {
-        return build_substitutor<IfSubstitutor>(new If(vert.data(), n->data(), true), state, &vert, n, m);
+        return build_substitutor<IfSubstitutor>(
+          state._pool.make<If>(vert.data(), n->data(), true), state, vert._idx, n->_idx, m->_idx);
       }
     }
 
@@ -363,294 +511,103 @@ std::unique_ptr<Substitutor> acyclic_region_type(SPSState& state, ACNVertex& ver
 //  }
 //}
 
-int replace_seq_in_graph(SPSState& state, SeqSubstitution const& ssub, Seq* seq, int post_ctr) {
-  ACNVertex* hdr_node = ssub._list.front();
-  ACNVertex* tail_node = ssub._list.back();
+// Graphs up to kCheckStrideDivisor vertices are checked after every substitution, larger ones a few hundred times in
+// total
+int check_stride(SPSState const& state) { return 1 + static_cast<int>(state._gr.size() / kCheckStrideDivisor); }
 
-  // Link nodes entering this structure to the new node
-  for (auto inedge : hdr_node->_in) {
-    state._gr.emplace_link(inedge._target, repl_node_id, inedge._tr);
-  }
-  for (auto outedge : tail_node->_out) {
-    state._gr.emplace_link(repl_node_id, outedge._target, outedge._tr);
-  }
-
-  // Detach and mark parent structure
-  for (auto node : ssub._list) {
-    state._gr.detach(node);
-    state._structof[node->data()] = repl;
-  }
-
-  // Update the dominator tree
-  // Since this is a sequential list of nodes, the only dominators needing updating are nodes dominated by the tail
-  std::replace(state._dom.begin(), state._dom.end(), tail_node->_idx, repl_node_id);
-  // And the dominator of this structure is the dominator of the header node
-  state._dom[repl_node_id] = state._dom[hdr_node->_idx];
-  // Clear out old dominator info
-  for (auto seqnode : seq->_seq) {
-    state._dom[state._data2vert[seqnode]->_idx] = -1;
-  }
-  // TODO: finish the fixup and test
-
-  // Update the postorder index to point to this new node
-  int seq_end = post_ctr;
-  if (state._post[post_ctr] != hdr_node->_idx) {
-    // Header node can't possibly appear before the current postorder counter
-    seq_end = *std::find(state._post.begin() + post_ctr, state._post.end(), hdr_node->_idx);
-  }
-  state._post[seq_end] = repl_node_id;
-  // Since this is a sequential list of nodes, they must all appear sequentially in the postorder iteration
-  const int seq_begin = seq_end - seq->_seq.size() + 1;
-  state._post.erase(state._post.begin() + seq_begin, state._post.begin() + seq_end);
-
-  return seq_begin;
+void check_dominators(SPSState& state) {
+  state._unchecked = 0;
+  state._dominator_checks++;
+  state._dominator_mismatches += !state._dom.matches(state._gr);
+  state._dominator_mismatches += !state._pdom.matches(state._gr);
 }
 
-int replace_in_graph(SPSState& state, AcyclicSubstitution const& asub, AbstractControlNode* repl, int post_ctr) {
-  const int repl_node_id = state._gr.emplace_vertex(repl);
-  state._dom.push_back(-1);
-  // Sanity check that everywhere we update the graph, the dom tree is updated to match
-  assert(state._dom.size() == state._gr.size());
-
-  switch (repl->_type) {
-    case ACNType::Seq: {
-      replace_seq_in_graph(state, std::get<SeqSubstitution>(asub), reinterpret_cast<Seq*>(repl), post_ctr);
-    }
-
-    case ACNType::If: {
-      If* ifn = static_cast<If*>(repl);
-      ACNVertex* hdr_node = state._data2vert[ifn->_head];
-      ACNVertex* tail_node = state._data2vert[ifn->_true];
-
-      // Sanity check
-      assert(hdr_node->_out.size() == 2);
-      assert(tail_node->_out.size() == 1);
-
-      // Link nodes entering this structure to the new node
-      for (auto inedge : hdr_node->_in) {
-        state._gr.emplace_link(inedge._target, repl_node_id, inedge._tr);
-      }
-      state._gr.emplace_link(repl_node_id, tail_node->_out[0]._target, tail_node->_out[0]._tr);
-
-      // Detach and mark parent structure
-      state._gr.detach(hdr_node);
-      state._gr.detach(tail_node);
-      state._structof[ifn->_head] = repl;
-      state._structof[ifn->_true] = repl;
-
-      // Update the dominator tree
-      // Since this is an If node, the 'true' block should be a leaf in the dominator tree, thus anything dominated by
-      // this structure is dominated only by the header
-      std::replace(state._dom.begin(), state._dom.end(), hdr_node->_idx, repl_node_id);
-      // And the dominator of this structure is the dominator of the header node (again)
-      state._dom[repl_node_id] = state._dom[hdr_node->_idx];
-      // Clear out old dominator info
-      state._dom[hdr_node->_idx] = -1;
-      state._dom[tail_node->_idx] = -1;
-
-      int hdr_post_idx = post_ctr;
-      if (state._post[post_ctr] != hdr_node->_idx) {
-        hdr_post_idx = *std::find(state._post.begin() + post_ctr, state._post.end(), hdr_node->_idx);
-      }
-      state._post[hdr_post_idx] = repl_node_id;
-      // Finding the true block of an if is a bit harder, as it could be the immediate previous postorder node, or it
-      // could be much further away
-      if (state._post[hdr_post_idx - 1] == tail_node->_idx) {
-        state._post.erase(state._post.begin() + hdr_post_idx - 1);
-      } else {
-        state._post.erase(std::find(state._post.begin(), state._post.begin() + post_ctr, tail_node->_idx));
-      }
-      return hdr_post_idx - 1;
-    }
-
-    case ACNType::IfElse: {
-      IfElse* ifelse = static_cast<IfElse*>(repl);
-      ACNVertex* hdr_node = state._data2vert[ifelse->_head];
-      ACNVertex* tail1 = state._data2vert[ifelse->_true];
-      ACNVertex* tail2 = state._data2vert[ifelse->_false];
-
-      // Sanity check
-      assert(hdr_node->_out.size() == 2);
-      assert(tail1->_out.size() == 1);
-      assert(tail2->_out.size() == 1);
-
-      // Link nodes entering this structure to the new node
-      for (auto inedge : hdr_node->_in) {
-        state._gr.emplace_link(inedge._target, repl_node_id, inedge._tr);
-      }
-      // Since tail1.out == tail2.out only need one link emplaced
-      state._gr.emplace_link(repl_node_id, tail1->_out[0]._target, tail1->_out[0]._tr);
-
-      // Detach and mark parent structure
-      state._gr.detach(hdr_node);
-      state._gr.detach(tail1);
-      state._gr.detach(tail2);
-      state._structof[ifelse->_head] = repl;
-      state._structof[ifelse->_true] = repl;
-      state._structof[ifelse->_false] = repl;
-
-      // Update the dominator tree
-      // Same rule in the If case applies for IfElse
-      std::replace(state._dom.begin(), state._dom.end(), hdr_node->_idx, repl_node_id);
-      state._dom[repl_node_id] = state._dom[hdr_node->_idx];
-      // Clear out old dominator info
-      state._dom[hdr_node->_idx] = -1;
-      state._dom[tail1->_idx] = -1;
-      state._dom[tail2->_idx] = -1;
-
-      int hdr_post_idx = post_ctr;
-      if (state._post[post_ctr] != hdr_node->_idx) {
-        hdr_post_idx = *std::find(state._post.begin() + post_ctr, state._post.end(), hdr_node->_idx);
-      }
-      state._post[hdr_post_idx] = repl_node_id;
-
-      // One of the case nodes must be the header's postorder predecessor, the other one must be searched for
-      if (state._post[hdr_post_idx - 1] == tail1->_idx) {
-        state._post.erase(std::find(state._post.begin(), state._post.begin() + post_ctr, tail2->_idx));
-      } else {  // == tail2->_idx
-        state._post.erase(std::find(state._post.begin(), state._post.begin() + post_ctr, tail1->_idx));
-      }
-      state._post.erase(state._post.begin() + hdr_post_idx - 1);
-      return hdr_post_idx - 2;
-    }
-
-    case ACNType::CCond: {
-      CCond* ccond = static_cast<CCond*>(repl);
-      std::vector<int> repl_nodes;
-      std::transform(
-        ccond->_leaves.begin(), ccond->_leaves.end(), std::back_inserter(repl_nodes), [&state](AbstractControlNode* n) {
-          return state._data2vert[n]->_idx;
-        });
-      // TODO: replace every single thing in this function with a call to "substitute in graph"
-      // TODO: flesh out graph substitution algorithm a bit more?
-      return 0;
-    }
-
-    case ACNType::Switch: {
-      Switch* switchn = static_cast<Switch*>(repl);
-      ACNVertex* hdr_node = state._data2vert[switchn->_head];
-      ACNVertex* first_case_node = state._data2vert[switchn->_cases[0].second];
-
-      // Link nodes entering this structure to the new node
-      for (auto inedge : hdr_node->_in) {
-        state._gr.emplace_link(inedge._target, repl_node_id, inedge._tr);
-      }
-      // Switch schema case nodes must lead to the same merge point, therefore
-      // _cases[0].out == _cases[1].out == ... == cases[n].out
-      state._gr.emplace_link(repl_node_id, first_case_node->_out[0]._target, first_case_node->_out[0]._tr);
-
-      // Detach and mark parent structure
-      state._gr.detach(hdr_node);
-      state._structof[switchn->_head] = repl;
-      for (auto [_, casen] : switchn->_cases) {
-        state._gr.detach(state._data2vert[casen]);
-        state._structof[casen] = repl;
-      }
-
-      // Update the dominator tree
-      // Same rule in the If and IfElse case applies to Switches too
-      std::replace(state._dom.begin(), state._dom.end(), hdr_node->_idx, repl_node_id);
-      state._dom[repl_node_id] = state._dom[hdr_node->_idx];
-      // Clear out old dominator info
-      state._dom[hdr_node->_idx] = -1;
-      for (auto [_, casen] : switchn->_cases) {
-        state._dom[state._data2vert[casen]->_idx] = -1;
-      }
-
-      int hdr_post_idx = post_ctr;
-      if (state._post[post_ctr] != hdr_node->_idx) {
-        hdr_post_idx = *std::find(state._post.begin() + post_ctr, state._post.end(), hdr_node->_idx);
-      }
-      state._post[hdr_post_idx] = repl_node_id;
-
-      // Instead of thinking hard about this, just bruteforce search for all case nodes and remove them
-      for (auto [_, c] : switchn->_cases) {
-        ACNVertex* casen = state._data2vert[c];
-        state._post.erase(std::find(state._post.begin(), state._post.begin() + hdr_post_idx, casen->_idx));
-        hdr_post_idx--;
-      }
-      return hdr_post_idx;
-    }
-
-    default:
-      return -1;
+// Collapses the region matched by sub and patches the postorder, returning the vertex the walk at cursor resumes from
+int replace_in_graph(SPSState& state, Substitutor& sub, int cursor) {
+  const std::span<int const> members = sub.membership();
+  const int header = members.front();
+  assert(state._post.contains(header));
+  // Resume at the new vertex if the walk already passed the header or the cursor is collapsed away
+  const bool resume_at_repl = std::find(members.begin(), members.end(), cursor) != members.end() ||
+                              state._post.precedes(header, cursor);
+
+  const int repl_idx = sub.substitute(state._scratch._links);
+  state._reach.collapse(state._gr, header, repl_idx);
+  state._structof.resize(state._pool.size(), kInvalidACNRef);
+  for (int m : members) {
+    state._structof[state._gr.vertex(m)->data()] = sub._repl;
   }
-}
+  state._live -= static_cast<int>(members.size()) - 1;
 
-enum PathCacheState {
-  kUndecided,
-  kPathBack,
-  kNoPathBack,
-};
+  if (state._check_dominators && ++state._unchecked >= check_stride(state)) {
+    check_dominators(state);
+  }
 
-std::vector<int> loop_membership(SPSState& state, ACNVertex* head) {
-  enum class Reachability : uint8_t {
-    kUnprocessed,
-    kPathBack,
-    kNoPathBack,
-  };
-  std::vector<Reachability> reachability(state._gr.size(), Reachability::kUnprocessed);
-  std::vector<int> reach_under;
-
-  bool is_header = false;
-  // Determine backedges of header
-  for (auto [in_idx, _] : head->_in) {
-    if (dominates(state._dom, head->_idx, in_idx)) {
-      reachability[in_idx] = Reachability::kPathBack;
-      is_header = true;
+  // The header's slot becomes the new vertex and the other members are dropped
+  state._post.replace(header, repl_idx);
+  for (auto it = members.begin() + 1; it != members.end(); ++it) {
+    if (state._post.contains(*it)) {
+      state._post.erase(*it);
     }
   }
-  if (!is_header) {
-    return reach_under;
-  }
-  reachability[head->_idx] = Reachability::kNoPathBack;
-
-  state._gr.postorder_fwd(
-    [&reach_under, &reachability](ACNVertex& v) {
-      Reachability r = Reachability::kNoPathBack;
-      for (auto [out_idx, _] : v._out) {
-        if (reachability[out_idx] == Reachability::kPathBack) {
-          r = Reachability::kPathBack;
-          reach_under.push_back(v._idx);
-        }
-      }
-      reachability[v._idx] = r;
-    },
-    head);
-
-  reach_under.push_back(head->_idx);
-  return reach_under;
+  return resume_at_repl ? repl_idx : cursor;
 }
 
 HLLControlTree SemanticPreservingStructurizer::structurize() {
   SPSState state;
+  state._pool = std::move(_pool);
+  state._check_dominators = _check_dominators;
   // Copy IR graph shape over the ACN graph, assigning the set of basic blocks as leaves
   state._gr.copy_shape_generator(
-    &_routine->_graph, [this, &state](ir::IrBlockVertex const& ibv, ACNVertex& acnv) { acnv._d = _leaves[ibv._idx]; });
-  state._dom = state._gr.compute_dom_tree();
-
-  do {
-    state._post.clear();
-    state._gr.postorder_fwd([&state](ACNVertex const& acnv) { state._post.push_back(acnv._idx); }, state._gr.root());
+    &_routine->_graph, [this](ir::IrBlockVertex const& ibv, ACNVertex& acnv) { acnv._d = _leaves[ibv._idx]; });
+  // The only full dominator computations, every substitution after this patches the trees in place
+  state._dom = DominatorTree::dominators(state._gr);
+  state._pdom = DominatorTree::postdominators(state._gr);
+  state._reach = ReachabilityIndex(state._gr);
+  state._gr.foreach_real([&state](ACNVertex const& acnv) { state._live += state._dom.contains(acnv._idx); });
+  std::vector<int> order;
+  state._gr.postorder_fwd([&order](ACNVertex const& acnv) { order.push_back(acnv._idx); }, state._gr.root());
+  // Every collapse adds one vertex, and at most one collapse can happen per live vertex
+  state._post = PostorderList(order, state._gr.size() + state._live);
+
+  bool progress = true;
+  while (progress && state._live > 1) {
+    progress = false;
+    for (int cursor = state._post.first(); cursor != -1 && state._live > 1;) {
+      ACNVertex* vert = state._gr.vertex(cursor);
+      if (vert->is_pseudo()) {
+        cursor = state._post.next(cursor);
+        continue;
+      }
 
-    for (int post_ctr = 0; post_ctr < static_cast<int>(state._post.size()) && state._gr.size() > 1;) {
-      ACNVertex* vert = state._gr.vertex(state._post[post_ctr]);
       auto acyclic_result = acyclic_region_type(state, *vert);
-
       if (acyclic_result != nullptr) {
-        acyclic_result->substitute();
-        post_ctr = replace_in_graph(state, acyclic_result.right().first, acyclic_result.right().second, post_ctr);
+        cursor = replace_in_graph(state, *acyclic_result, cursor);
+        progress = true;
         continue;
       }
 
-      // std::vector<int> loop_memb = loop_membership(state, vert);
-      // if (!loop_memb.empty()) {
-      //   Either<RefinementSuggestion, AbstractControlNode*> cyclic_result = cyclic_region_type(state, *vert,
-      //   loop_memb);
-      // }
+      // Cyclic regions aren't reduced yet, so a loop stays in the graph and the routine doesn't fully reduce
+      cursor = state._post.next(cursor);
     }
-  } while (state._gr.size() > 1);
+  }
 
-  return HLLControlTree{};
+  HLLControlTree tree;
+  if (state._live == 1) {
+    state._gr.foreach_real([&state, &tree](ACNVertex& acnv) {
+      if (!state._dom.contains(acnv._idx)) {
+        return true;
+      }
+      tree._root = acnv.data();
+      return false;
+    });
+  }
+  if (state._check_dominators && state._unchecked > 0) {
+    check_dominators(state);
+  }
+  _dominator_checks = state._dominator_checks;
+  _dominator_mismatches = state._dominator_mismatches;
+  tree._pool = std::move(state._pool);
+  return tree;
 }
 }  // namespace decomp::hll
@@ -1,8 +1,5 @@
 #pragma once
 
-#include <unordered_map>
-#include <vector>
-
 #include "hll/Structurizer.hh"
 
 namespace decomp::hll {
@@ -11,15 +8,18 @@ namespace decomp::hll {
 // Contains some additional refinement steps
 class SemanticPreservingStructurizer : public ControlFlowStructurizer {
 public:
+  explicit SemanticPreservingStructurizer(bool check_dominators = false) : _check_dominators(check_dominators) {}
+
   HLLControlTree structurize() override;
 
-private:
+  // Results of the last structurize() when checking is on, every check compares both trees
+  size_t dominator_checks() const { return _dominator_checks; }
+  size_t dominator_mismatches() const { return _dominator_mismatches; }
 
-  ACNGraph _gr;
-  int _post_ctr;
-  std::unordered_map<AbstractControlNode*, AbstractControlNode*> _structof;
-  std::vector<int> _post;
-  std::vector<int> _dom;
-  std::vector<int> _pdom;
+private:
+  // Cross-check the incrementally maintained dominator trees against a full recompute as substitutions go
+  bool _check_dominators;
+  size_t _dominator_checks = 0;
+  size_t _dominator_mismatches = 0;
 };
 }  // namespace decomp::hll
@@ -9,7 +9,7 @@ namespace decomp::hll {
 void ControlFlowStructurizer::prepare(ir::IrRoutine const& routine) {
   _routine = &routine;
   for (ir::IrBlockVertex const& block : routine._graph) {
-    _leaves.push_back(new BasicBlock(block));
+    _leaves.push_back(_pool.make<BasicBlock>(block));
   }
 }
 
@@ -1,30 +1,22 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
 #include "ir/GekkoTranslator.hh"
 
 namespace decomp::hll {
-struct AbstractControlNode;
-using ACNVertex = FlowVertex<AbstractControlNode*>;
-using ACNGraph = FlowGraph<AbstractControlNode*>;
-
-struct HLLControlTree {
-  AbstractControlNode* _root;
-};
-
-// Generic control flow structurizer, transforms an IrGraph into a structured AST
-class ControlFlowStructurizer {
-public:
-  virtual HLLControlTree structurize() = 0;
-
-  // This is called by run_control_flow_analysis
-  void prepare(ir::IrRoutine const& routine);
+// Dense id of an abstract control node within its routine's ACNPool
+using ACNRef = uint32_t;
+constexpr ACNRef kInvalidACNRef = 0xffffffff;
 
-protected:
-  // IR Graph to structurize
-  ir::IrRoutine const* _routine;
-  // Initial node set
-  std::vector<AbstractControlNode*> _leaves;
-};
+using ACNVertex = FlowVertex<ACNRef>;
+using ACNGraph = FlowGraph<ACNRef>;
 
 enum class ACNType {
   Basic,
@@ -44,7 +36,9 @@ enum class ACNType {
 
 struct AbstractControlNode {
   AbstractControlNode(ACNType type) : _type(type) {}
+  virtual ~AbstractControlNode() {}
   ACNType _type;
+  ACNRef _id = kInvalidACNRef;
 };
 
 template <ACNType NT>
@@ -66,49 +60,49 @@ struct BasicBlock : StaticTypedACN<ACNType::Basic> {
 // Sequence of abstract nodes
 struct Seq : StaticTypedACN<ACNType::Seq> {
   Seq() {}
-  Seq(std::vector<AbstractControlNode*>&& seq) : _seq(std::move(seq)) {}
-  std::vector<AbstractControlNode*> _seq;
+  Seq(std::vector<ACNRef>&& seq) : _seq(std::move(seq)) {}
+  std::vector<ACNRef> _seq;
 };
 
 // If-sans-else schema
 struct If : StaticTypedACN<ACNType::If> {
-  If() : _head(nullptr), _true(nullptr), _invert(false) {}
-  If(AbstractControlNode* head, AbstractControlNode* t, bool invert) : _head(head), _true(t), _invert(invert) {}
-  AbstractControlNode* _head;
-  AbstractControlNode* _true;
+  If() : _head(kInvalidACNRef), _true(kInvalidACNRef), _invert(false) {}
+  If(ACNRef head, ACNRef t, bool invert) : _head(head), _true(t), _invert(invert) {}
+  ACNRef _head;
+  ACNRef _true;
   bool _invert;
 };
 
 // If-else schema
 struct IfElse : StaticTypedACN<ACNType::IfElse> {
-  IfElse() : _head(nullptr), _true(nullptr), _false(nullptr) {}
-  IfElse(AbstractControlNode* head, AbstractControlNode* t, AbstractControlNode* f)
-      : _head(head), _true(t), _false(f) {}
-  AbstractControlNode* _head;
-  AbstractControlNode* _true;
-  AbstractControlNode* _false;
+  IfElse() : _head(kInvalidACNRef), _true(kInvalidACNRef), _false(kInvalidACNRef) {}
+  IfElse(ACNRef head, ACNRef t, ACNRef f) : _head(head), _true(t), _false(f) {}
+  ACNRef _head;
+  ACNRef _true;
+  ACNRef _false;
 };
 
 // If-elseif-else schema
 struct IfElseIf : StaticTypedACN<ACNType::IfElseIf> {
-  std::vector<std::pair<AbstractControlNode*, AbstractControlNode*>> _conds;
-  std::optional<AbstractControlNode*> _fallthrough;
+  std::vector<std::pair<ACNRef, ACNRef>> _conds;
+  std::optional<ACNRef> _fallthrough;
 };
 
 struct CCond : StaticTypedACN<ACNType::CCond> {
   enum class BoolOp {
     kAnd, kOr
   };
+  // Operands are either a node or the index of an earlier entry in _nodes
   struct CCondNode {
-    std::variant<AbstractControlNode*, int> _lhs;
-    std::variant<AbstractControlNode*, int> _rhs;
+    std::variant<ACNRef, int> _lhs;
+    std::variant<ACNRef, int> _rhs;
     bool _inv_rhs;
     BoolOp _op;
   };
   std::vector<CCondNode> _nodes;
 
-  int put(std::variant<AbstractControlNode*, int> l,
-               std::variant<AbstractControlNode*, int> r,
+  int put(std::variant<ACNRef, int> l,
+               std::variant<ACNRef, int> r,
                bool inv_rhs, BoolOp op) {
     _nodes.push_back(CCondNode {
       ._lhs = l,
@@ -122,37 +116,83 @@ struct CCond : StaticTypedACN<ACNType::CCond> {
 
 // Switch schema
 struct Switch : StaticTypedACN<ACNType::Switch> {
-  Switch() : _head(nullptr) {}
-  Switch(AbstractControlNode* head, std::vector<std::pair<BlockTransfer, AbstractControlNode*>>&& cases)
-      : _head(nullptr), _cases(std::move(cases)) {}
-  AbstractControlNode* _head;
-  std::vector<std::pair<BlockTransfer, AbstractControlNode*>> _cases;
+  Switch() : _head(kInvalidACNRef) {}
+  Switch(ACNRef head, std::vector<std::pair<BlockTransfer, ACNRef>>&& cases)
+      : _head(head), _cases(std::move(cases)) {}
+  ACNRef _head;
+  std::vector<std::pair<BlockTransfer, ACNRef>> _cases;
 };
 
 // Do-while schema
 struct DoWhile : StaticTypedACN<ACNType::DoWhile> {
-  AbstractControlNode* _body;
-  AbstractControlNode* _cond;
+  ACNRef _body;
+  ACNRef _cond;
 };
 
 // While schema
 struct While : StaticTypedACN<ACNType::While> {
-  AbstractControlNode* _cond;
-  AbstractControlNode* _body;
+  ACNRef _cond;
+  ACNRef _body;
 };
 
 // For schema
 struct For : StaticTypedACN<ACNType::For> {
-  AbstractControlNode* _init;
-  AbstractControlNode* _cond;
-  AbstractControlNode* _body;
-  AbstractControlNode* _it;
+  ACNRef _init;
+  ACNRef _cond;
+  ACNRef _body;
+  ACNRef _it;
 };
 
 struct SelfLoop : StaticTypedACN<ACNType::SelfLoop> {
-  SelfLoop() : _n(nullptr) {}
-  SelfLoop(AbstractControlNode* n) : _n(n) {}
-  AbstractControlNode* _n;
+  SelfLoop() : _n(kInvalidACNRef) {}
+  SelfLoop(ACNRef n) : _n(n) {}
+  ACNRef _n;
+};
+
+// Owns every abstract control node built for one routine and hands out dense ids in creation order, so per-node
+// state elsewhere can live in flat vectors indexed by id
+class ACNPool {
+  std::vector<std::unique_ptr<AbstractControlNode>> _nodes;
+
+public:
+  template <typename T, typename... Args>
+  ACNRef make(Args&&... args) {
+    const ACNRef id = static_cast<ACNRef>(_nodes.size());
+    _nodes.push_back(std::make_unique<T>(std::forward<Args>(args)...));
+    _nodes.back()->_id = id;
+    return id;
+  }
+
+  size_t size() const { return _nodes.size(); }
+  AbstractControlNode* node(ACNRef id) const { return _nodes[id].get(); }
+  template <typename T>
+  T* get(ACNRef id) const {
+    assert(_nodes[id]->_type == T::kStaticType);
+    return static_cast<T*>(_nodes[id].get());
+  }
+};
+
+struct HLLControlTree {
+  ACNRef _root = kInvalidACNRef;
+  // Holds _root and everything under it
+  ACNPool _pool;
+};
+
+// Generic control flow structurizer, transforms an IrGraph into a structured AST
+class ControlFlowStructurizer {
+public:
+  virtual HLLControlTree structurize() = 0;
+
+  // This is called by run_control_flow_analysis
+  void prepare(ir::IrRoutine const& routine);
+
+protected:
+  // IR Graph to structurize
+  ir::IrRoutine const* _routine;
+  // Nodes built so far, handed over to the resulting tree
+  ACNPool _pool;
+  // Initial node set, one leaf per IR block
+  std::vector<ACNRef> _leaves;
 };
 
 // TODO: remove structurizer parameter, refer to it from global options perhaps?
@@ -3,9 +3,11 @@
 #include <algorithm>
 
 #include "ir/RegisterBinding.hh"
+#include "ppc/LivenessCursor.hh"
 #include "ppc/RegisterLiveness.hh"
 #include "ppc/SubroutineGraph.hh"
 #include "ppc/SubroutineStack.hh"
+#include "utl/FlowGraphSnapshot.hh"
 #include "utl/VariantOverloaded.hh"
 
 #if defined(_WIN32)
@@ -91,22 +93,26 @@ void GekkoTranslator::compute_block_binds(ppc::BasicBlockVertex const& block) {
   using RegType = typename SetType::RegType;
   auto& bind_tracker = _ir_routine.get_binds<SetType>();
   auto const* lt = ppc::get_liveness<SetType>(&block.data());
+  // Nothing in the subroutine uses this register class
+  if (lt == nullptr) {
+    return;
+  }
   SetType connect_in = lt->_input;
   SetType param_in = lt->_routine_inputs;
 
   std::array<uint32_t, 32> rgn_begin;
   std::fill(rgn_begin.begin(), rgn_begin.end(), block.data()._block_start);
-  for (size_t i = 0; i < lt->_live_in.size(); i++) {
-    const uint32_t cur_addr = block.data()._block_start + 4 * i;
-    SetType delta_reg = lt->_live_in[i] ^ lt->_live_out[i];
-    SetType unused = lt->_def[i] - (lt->_live_in[i] + lt->_live_out[i]);
+  for (ppc::LivenessCursor<SetType> cursor(block.data()); !cursor.at_end(); cursor.next()) {
+    const uint32_t cur_addr = block.data()._block_start + 4 * cursor.index();
+    SetType delta_reg = cursor.live_in() ^ cursor.live_out();
+    SetType unused = cursor.def() - (cursor.live_in() + cursor.live_out());
     while (delta_reg) {
       RegType ref_reg = static_cast<RegType>(count_trailing_zero(delta_reg._set));
       delta_reg -= ref_reg;
       if (std::get<SetType>(ppc::kRegSets._abi_regs).in_set(ref_reg)) {
         continue;
       }
-      if (lt->_live_in[i].in_set(ref_reg)) {
+      if (cursor.live_in().in_set(ref_reg)) {
         bool is_param = param_in.in_set(ref_reg);
         param_in -= ref_reg;
         const uint32_t new_temp =
@@ -668,7 +674,7 @@ void GekkoTranslator::translate_ppc_inst(ppc::MetaInst const& inst) {
 }
 
 void GekkoTranslator::translate_block_condition(ppc::BasicBlockVertex const& blk) {
-  ppc::MetaInst const& inst = blk.data()._instructions.back();
+  ppc::MetaInst const& inst = blk.data()._instructions.back().expand();
   if (inst._op == ppc::InstOperation::kBc) {
     TempVar var;
 
@@ -774,30 +780,34 @@ void GekkoTranslator::compute_parameters() {
 }
 
 void GekkoTranslator::translate() {
-  _ppc_routine._graph->preorder_fwd(
-    [this](ppc::BasicBlockVertex const& cur) {
+  ppc::SubroutineGraph const& graph = *_ppc_routine._graph;
+  FlowGraphSnapshot const& shape = graph._shape;
+  shape.preorder<true>(
+    [this, &graph, &shape](int idx) {
       // Don't compute binds on pseudo vertices
-      if (cur.is_real()) {
+      if (!shape.is_real(idx)) {
         return;
       }
+      ppc::BasicBlockVertex const& cur = *graph.vertex(idx);
       compute_block_binds<ppc::GprSet>(cur);
       compute_block_binds<ppc::FprSet>(cur);
       compute_block_binds<ppc::CrSet>(cur);
     },
-    _ppc_routine._graph->root());
+    shape.root());
   _ir_routine._gpr_binds.collect_block_scope_temps();
   _ir_routine._fpr_binds.collect_block_scope_temps();
   _ir_routine._cr_binds.collect_block_scope_temps();
 
   compute_parameters();
 
-  _ppc_routine._graph->preorder_fwd(
-    [this](ppc::BasicBlockVertex const& cur) {
+  shape.preorder<true>(
+    [this, &graph](int idx) {
+      ppc::BasicBlockVertex const& cur = *graph.vertex(idx);
       _active_blk = _ir_routine._graph.vertex(cur._idx);
       if (cur.is_real()) {
         for (size_t i = 0; i < cur.data()._instructions.size(); i++) {
           if (cur.data()._perilogue_types[i] == ppc::PerilogueInstructionType::kNormalInst) {
-            translate_ppc_inst(cur.data()._instructions[i]);
+            translate_ppc_inst(cur.data()._instructions[i].expand());
           }
         }
 
@@ -807,7 +817,7 @@ void GekkoTranslator::translate() {
       _active_blk->_out = cur._out;
       _active_blk->_in = cur._in;
     },
-    _ppc_routine._graph->root());
+    shape.root());
 }
 }  // namespace
 
@@ -71,5 +71,7 @@ struct IrRoutine {
   }
 };
 
+constexpr ppc::PassRequirements kTranslatePass = {
+  "translate", ppc::AnalysisProduct::kMachineLevel, ppc::AnalysisProduct::kIr};
 IrRoutine translate_subroutine(ppc::Subroutine const& routine);
 }  // namespace decomp::ir
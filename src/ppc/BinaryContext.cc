@@ -1,10 +1,12 @@
 #include "ppc/BinaryContext.hh"
 
 #include <memory>
+#include <utility>
 
 #include "producers/DolData.hh"
 #include "producers/ElfData.hh"
 #include "utl/Either.hh"
+#include "utl/MappedFile.hh"
 #include "utl/PatternScan.hh"
 
 namespace decomp::ppc {
@@ -16,12 +18,13 @@ constexpr std::string_view kRestGprPattern =
   "81 cb ff b8 81 eb ff bc 82 0b ff c0 82 2b ff c4 82 4b ff c8 82 6b ff cc 82 8b ff d0 82 ab ff d4 82 cb ff d8 82 eb "
   "ff dc 83 0b ff e0 83 2b ff e4 83 4b ff e8 83 6b ff ec 83 8b ff f0 83 ab ff f4 83 cb ff f8 83 eb ff fc 4e 80 00 20";
 
-ErrorOr<BinaryContext> load_dol(std::ifstream& data_in, bool do_abi_discovery) {
+template <typename Source>
+ErrorOr<BinaryContext> load_dol(Source&& data_in, bool do_abi_discovery) {
   BinaryContext ret;
   ret._btype = BinaryType::kDOL;
 
   std::unique_ptr<DolData> ram = std::make_unique<DolData>();
-  if (!ram->load_from(data_in)) {
+  if (!ram->load_from(std::forward<Source>(data_in))) {
     return "Failed to parse DOL file, invalid format";
   }
 
@@ -37,12 +40,13 @@ ErrorOr<BinaryContext> load_dol(std::ifstream& data_in, bool do_abi_discovery) {
   return ret;
 }
 
-ErrorOr<BinaryContext> load_elf(std::ifstream& data_in, bool do_abi_discovery) {
+template <typename Source>
+ErrorOr<BinaryContext> load_elf(Source&& data_in, bool do_abi_discovery) {
   BinaryContext ret;
   ret._btype = BinaryType::kELF;
 
   std::unique_ptr<ElfData> ram = std::make_unique<ElfData>();
-  if (!ram->load_from(data_in)) {
+  if (!ram->load_from(std::forward<Source>(data_in))) {
     return "Failed to parse ELF file, invalid format";
   }
 
@@ -70,6 +74,22 @@ ErrorOr<BinaryContext> create_from_stream(std::ifstream& data_in, BinaryType bty
   }
 }
 
+ErrorOr<BinaryContext> create_from_path(std::string const& path, BinaryType btype, bool do_abi_discovery) {
+  ErrorOr<MappedFile> image = MappedFile::open(path);
+  if (image.is_error()) {
+    return image.err();
+  }
+
+  switch (btype) {
+    case BinaryType::kDOL:
+      return load_dol(std::move(image.val()), do_abi_discovery);
+    case BinaryType::kELF:
+      return load_elf(std::move(image.val()), do_abi_discovery);
+    default:
+      return "Invalid binary type";
+  }
+}
+
 BinaryContext create_raw(uint32_t base, uint32_t entrypoint, char const* data, size_t len) {
   BinaryContext ret;
 
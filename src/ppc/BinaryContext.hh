@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <memory>
+#include <string>
 
 #include "ppc/CodeWarriorABIConfiguration.hh"
 #include "producers/RandomAccessData.hh"
@@ -23,6 +24,8 @@ struct BinaryContext {
 };
 
 ErrorOr<BinaryContext> create_from_stream(std::ifstream& data_in, BinaryType btype, bool do_abi_discovery = true);
+// Memory maps the file at path, section data is paged in lazily instead of copied up front
+ErrorOr<BinaryContext> create_from_path(std::string const& path, BinaryType btype, bool do_abi_discovery = true);
 BinaryContext create_raw(uint32_t, uint32_t, char const*, size_t);
 template <size_t N>
 BinaryContext create_raw(uint32_t base, uint32_t entrypoint, char const (&data)[N]) {
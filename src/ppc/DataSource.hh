@@ -289,7 +289,7 @@ enum class FPSCRBit : uint32_t {
 };
 GEN_FLAG_OPERATORS(FPSCRBit)
 
-enum class InstFlags : uint32_t {
+enum class InstFlags : uint8_t {
   kNone = 0b0000000,
   kAll = 0b1111110,
   kWritesRecord = 0b000001,
@@ -0,0 +1,137 @@
+#include "ppc/InterproceduralLiveness.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "ppc/BinaryContext.hh"
+#include "ppc/ProgramDiscovery.hh"
+#include "ppc/RegisterLiveness.hh"
+#include "utl/ParallelFor.hh"
+
+namespace decomp::ppc {
+namespace {
+constexpr uint32_t kUnvisited = std::numeric_limits<uint32_t>::max();
+
+// Direct call edges between table entries, by index into FunctionTable::_routines
+std::vector<std::vector<uint32_t>> build_call_graph(FunctionTable const& table) {
+  std::vector<std::vector<uint32_t>> callees(table._routines.size());
+  for (size_t i = 0; i < table._routines.size(); i++) {
+    for (uint32_t target : table._routines[i]._graph->_direct_calls) {
+      if (Subroutine const* callee = table.find(target); callee != nullptr) {
+        callees[i].push_back(static_cast<uint32_t>(callee - table._routines.data()));
+      }
+    }
+  }
+  return callees;
+}
+
+// Iterative Tarjan, returns the component of every node. Components are numbered in the order they complete, so a
+// component's callees always have smaller numbers
+std::vector<uint32_t> find_components(std::vector<std::vector<uint32_t>> const& callees) {
+  const uint32_t num_nodes = static_cast<uint32_t>(callees.size());
+  std::vector<uint32_t> index(num_nodes, kUnvisited);
+  std::vector<uint32_t> lowlink(num_nodes);
+  std::vector<uint32_t> component(num_nodes, kUnvisited);
+  std::vector<uint32_t> scc_stack;
+  // (node, next edge to look at)
+  std::vector<std::pair<uint32_t, uint32_t>> dfs_stack;
+  uint32_t next_index = 0;
+  uint32_t next_component = 0;
+
+  for (uint32_t root = 0; root < num_nodes; root++) {
+    if (index[root] != kUnvisited) {
+      continue;
+    }
+
+    index[root] = lowlink[root] = next_index++;
+    scc_stack.push_back(root);
+    dfs_stack.emplace_back(root, 0);
+    while (!dfs_stack.empty()) {
+      auto& [node, edge] = dfs_stack.back();
+      if (edge < callees[node].size()) {
+        const uint32_t callee = callees[node][edge++];
+        if (index[callee] == kUnvisited) {
+          index[callee] = lowlink[callee] = next_index++;
+          scc_stack.push_back(callee);
+          dfs_stack.emplace_back(callee, 0);
+        } else if (component[callee] == kUnvisited) {
+          // Still on the SCC stack
+          lowlink[node] = std::min(lowlink[node], index[callee]);
+        }
+        continue;
+      }
+
+      const uint32_t done = node;
+      dfs_stack.pop_back();
+      if (!dfs_stack.empty()) {
+        const uint32_t parent = dfs_stack.back().first;
+        lowlink[parent] = std::min(lowlink[parent], lowlink[done]);
+      }
+
+      if (lowlink[done] == index[done]) {
+        uint32_t member;
+        do {
+          member = scc_stack.back();
+          scc_stack.pop_back();
+          component[member] = next_component;
+        } while (member != done);
+        next_component++;
+      }
+    }
+  }
+
+  return component;
+}
+}  // namespace
+
+void run_interprocedural_liveness(FunctionTable& table, BinaryContext const& ctx, size_t num_threads) {
+  const std::vector<std::vector<uint32_t>> callees = build_call_graph(table);
+  const std::vector<uint32_t> component = find_components(callees);
+
+  // A component's wave is one past the latest wave of anything it calls into, so everything in a wave only depends
+  // on earlier waves. Component numbers already put callees first
+  uint32_t num_components = 0;
+  for (uint32_t c : component) {
+    num_components = std::max(num_components, c + 1);
+  }
+  std::vector<std::vector<uint32_t>> members(num_components);
+  for (uint32_t i = 0; i < component.size(); i++) {
+    members[component[i]].push_back(i);
+  }
+
+  std::vector<uint32_t> component_wave(num_components, 0);
+  std::vector<std::vector<uint32_t>> waves;
+  for (uint32_t c = 0; c < num_components; c++) {
+    uint32_t wave = 0;
+    for (uint32_t member : members[c]) {
+      for (uint32_t callee : callees[member]) {
+        if (component[callee] != c) {
+          wave = std::max(wave, component_wave[component[callee]] + 1);
+        }
+      }
+    }
+    component_wave[c] = wave;
+    if (wave >= waves.size()) {
+      waves.resize(wave + 1);
+    }
+    waves[wave].insert(waves[wave].end(), members[c].begin(), members[c].end());
+  }
+
+  for (std::vector<uint32_t> const& wave : waves) {
+    parallel_for(wave.size(), num_threads, [&table, &ctx, &component, &wave](size_t i) {
+      const uint32_t caller = wave[i];
+      // Callees outside of this component finished in an earlier wave
+      auto finished_callee = [&table, &component, caller](uint32_t target) -> Subroutine const* {
+        Subroutine const* callee = table.find(target);
+        if (callee == nullptr || component[callee - table._routines.data()] == component[caller]) {
+          return nullptr;
+        }
+        return callee;
+      };
+      run_liveness_analysis(table._routines[caller], ctx, finished_callee);
+    });
+  }
+}
+}  // namespace decomp::ppc
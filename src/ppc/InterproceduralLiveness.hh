@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+namespace decomp::ppc {
+struct BinaryContext;
+struct FunctionTable;
+
+// Runs liveness over every subroutine in the table bottom up over the call graph, so callers see the params and
+// clobbers their callees actually have instead of the whole ABI contract. Strongly connected components of the call
+// graph are scheduled in waves across num_threads workers (0 picks the hardware thread count), a component only waits
+// on the components it calls into. Calls within a component (recursion) keep the ABI contract
+void run_interprocedural_liveness(FunctionTable& table, BinaryContext const& ctx, size_t num_threads = 0);
+}  // namespace decomp::ppc
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+
+#include "ppc/PpcDisasm.hh"
+#include "ppc/RegisterLiveness.hh"
+#include "ppc/SubroutineGraph.hh"
+
+namespace decomp::ppc {
+// Walks the instructions of a block, rebuilding their liveness from the compact form kept in RegisterLiveness. Steps
+// go either way and cost O(1), copies are cheap so backtracking from a position is done on a copy
+template <typename SetType>
+class LivenessCursor {
+private:
+  using RegType = typename SetType::RegType;
+
+  BasicBlock const* _block;
+  RegisterLiveness<RegType> const* _rlt;
+  size_t _index = 0;
+  // First change and call entry at or past _index
+  size_t _change_pos = 0;
+  size_t _call_pos = 0;
+  SetType _live_in;
+
+  SetType flip() const {
+    if (_change_pos < _rlt->_changes.size() && _rlt->_changes[_change_pos]._index == _index) {
+      return _rlt->_changes[_change_pos]._flip;
+    }
+    return SetType();
+  }
+
+  CallRegs<RegType> const* call_regs() const {
+    if (_call_pos < _rlt->_call_regs.size() && _rlt->_call_regs[_call_pos]._index == _index) {
+      return &_rlt->_call_regs[_call_pos];
+    }
+    return nullptr;
+  }
+
+public:
+  // Starts at the block's first instruction
+  explicit LivenessCursor(BasicBlock const& block)
+      : _block(&block), _rlt(get_liveness<SetType>(&block)), _live_in(_rlt->_block_live_in) {}
+
+  size_t index() const { return _index; }
+  bool at_end() const { return _index == _block->_instructions.size(); }
+
+  // Liveness of the instruction under the cursor, live_in is also valid at the end
+  SetType live_in() const { return _live_in; }
+  SetType live_out() const { return _live_in ^ flip(); }
+  SetType use() const {
+    PackedInst const& inst = _block->_instructions[_index];
+    if (!inst.regs()._is_call) {
+      return inst.regs().use<SetType>();
+    }
+    CallRegs<RegType> const* regs = call_regs();
+    return regs == nullptr ? SetType() : regs->_use;
+  }
+  SetType def() const {
+    PackedInst const& inst = _block->_instructions[_index];
+    if (!inst.regs()._is_call) {
+      return inst.regs().def<SetType>();
+    }
+    CallRegs<RegType> const* regs = call_regs();
+    return regs == nullptr ? SetType() : regs->_def;
+  }
+
+  void next() {
+    _live_in = live_out();
+    _change_pos += flip() ? 1 : 0;
+    _call_pos += call_regs() != nullptr ? 1 : 0;
+    _index++;
+  }
+
+  void prev() {
+    _index--;
+    if (_change_pos > 0 && _rlt->_changes[_change_pos - 1]._index == _index) {
+      _change_pos--;
+    }
+    if (_call_pos > 0 && _rlt->_call_regs[_call_pos - 1]._index == _index) {
+      _call_pos--;
+    }
+    _live_in ^= flip();
+  }
+
+  void seek(size_t index) {
+    while (_index < index) {
+      next();
+    }
+    while (_index > index) {
+      prev();
+    }
+  }
+};
+
+// One off lookup of an instruction's live_out, walks the block up to it
+template <typename SetType>
+SetType live_out_at(BasicBlock const& block, size_t index) {
+  LivenessCursor<SetType> cursor(block);
+  cursor.seek(index);
+  return cursor.live_out();
+}
+}  // namespace decomp::ppc
@@ -1,6 +1,7 @@
 #include "ppc/Perilogue.hh"
 
 #include "ppc/BinaryContext.hh"
+#include "ppc/LivenessCursor.hh"
 #include "ppc/PpcDisasm.hh"
 #include "ppc/RegisterLiveness.hh"
 #include "ppc/Subroutine.hh"
@@ -10,53 +11,54 @@
 namespace decomp::ppc {
 namespace {
 void perilogue_block_analysis(BasicBlock& block, SubroutineStack& stack, BinaryContext const& ctx) {
-  constexpr auto backtrack_calle_save = [](BasicBlock const& block, GPR reg, size_t start) {
-    size_t j;
-    for (j = start; j > 0; j--) {
-      if (!block._gpr_lifetimes->_live_out[j - 1].in_set(reg)) {
-        break;
+  // A callee save stores a register that has been live since the start of the block
+  constexpr auto backtrack_calle_save = [](LivenessCursor<GprSet> cursor, GPR reg) {
+    while (cursor.index() > 0) {
+      cursor.prev();
+      if (!cursor.live_out().in_set(reg)) {
+        return PerilogueInstructionType::kNormalInst;
       }
     }
-    if (j == 0) {
-      return PerilogueInstructionType::kCalleeGPRSave;
-    }
-
-    return PerilogueInstructionType::kNormalInst;
+    return PerilogueInstructionType::kCalleeGPRSave;
   };
 
-  for (size_t i = 0; i < block._instructions.size(); i++) {
-    MetaInst const& inst = block._instructions[i];
+  LivenessCursor<GprSet> cursor(block);
+  for (size_t i = 0; i < block._instructions.size(); i++, cursor.next()) {
+    PackedInst const& inst = block._instructions[i];
     PerilogueInstructionType itype = PerilogueInstructionType::kNormalInst;
 
-    if (inst._op == InstOperation::kStwu && inst._binst.rs() == GPR::kR1) {
+    if (inst._op == InstOperation::kStwu && inst.binst().rs() == GPR::kR1) {
       itype = PerilogueInstructionType::kFrameAllocate;
-    } else if (inst._op == InstOperation::kAddi && inst._binst.rd() == GPR::kR1 && inst._binst.ra() == GPR::kR1) {
+    } else if (inst._op == InstOperation::kAddi && inst.binst().rd() == GPR::kR1 && inst.binst().ra() == GPR::kR1) {
       itype = PerilogueInstructionType::kFrameDeallocate;
-    } else if (inst._op == InstOperation::kMfspr && inst._binst.rd() == GPR::kR0 && inst._binst.spr() == SPR::kLr) {
+    } else if (inst._op == InstOperation::kMfspr && inst.binst().rd() == GPR::kR0 && inst.binst().spr() == SPR::kLr) {
       itype = PerilogueInstructionType::kMoveLRToR0;
       // TODO: improve this this by ensuring that LR is a routine input
       // (requires liveness tracking of SPRs)
-    } else if (inst._op == InstOperation::kMtspr && inst._binst.rs() == GPR::kR0 && inst._binst.spr() == SPR::kLr) {
-      for (size_t j = i; j > 0; j--) {
-        if (!block._gpr_lifetimes->_live_out[j - 1].in_set(GPR::kR0)) {
+    } else if (inst._op == InstOperation::kMtspr && inst.binst().rs() == GPR::kR0 && inst.binst().spr() == SPR::kLr) {
+      for (LivenessCursor<GprSet> back = cursor; back.index() > 0;) {
+        back.prev();
+        if (!back.live_out().in_set(GPR::kR0)) {
           break;
         }
-        if (block._perilogue_types[j - 1] == PerilogueInstructionType::kLoadSenderLR) {
+        if (block._perilogue_types[back.index()] == PerilogueInstructionType::kLoadSenderLR) {
           itype = PerilogueInstructionType::kMoveR0toLR;
           break;
         }
       }
-    } else if (inst._op == InstOperation::kStw && inst._binst.ra() == GPR::kR1) {
-      MemRegOff store_loc = std::get<MemRegOff>(inst._writes[0]);
-      GPR store_reg = std::get<GPRSlice>(inst._reads[0])._reg;
+    } else if (inst._op == InstOperation::kStw && inst.binst().ra() == GPR::kR1) {
+      MetaInst const& full = inst.expand();
+      MemRegOff store_loc = std::get<MemRegOff>(full._writes[0]);
+      GPR store_reg = std::get<GPRSlice>(full._reads[0])._reg;
 
       if (store_reg == GPR::kR0) {
         // I really hope that LR saves can't happen across basic blocks
-        for (size_t j = i; j > 0; j--) {
-          if (!block._gpr_lifetimes->_live_out[j - 1].in_set(store_reg)) {
+        for (LivenessCursor<GprSet> back = cursor; back.index() > 0;) {
+          back.prev();
+          if (!back.live_out().in_set(store_reg)) {
             break;
           }
-          if (block._perilogue_types[j - 1] == PerilogueInstructionType::kMoveLRToR0) {
+          if (block._perilogue_types[back.index()] == PerilogueInstructionType::kMoveLRToR0) {
             itype = PerilogueInstructionType::kSaveSenderLR;
             stack.variable_for_offset(store_loc._offset)->_is_frame_storage = true;
             break;
@@ -64,23 +66,25 @@ void perilogue_block_analysis(BasicBlock& block, SubroutineStack& stack, BinaryC
         }
 
       } else if (kCalleeSavedGpr.in_set(store_reg)) {
-        itype = backtrack_calle_save(block, store_reg, i);
+        itype = backtrack_calle_save(cursor, store_reg);
 
         if (itype == PerilogueInstructionType::kCalleeGPRSave) {
           stack.variable_for_offset(store_loc._offset)->_is_frame_storage = true;
         }
       }
-    } else if (inst._op == InstOperation::kStmw && inst._binst.ra() == GPR::kR1) {
-      MemRegOff store_loc = std::get<MemRegOff>(inst._writes[0]);
+    } else if (inst._op == InstOperation::kStmw && inst.binst().ra() == GPR::kR1) {
+      MetaInst const& full = inst.expand();
+      MemRegOff store_loc = std::get<MemRegOff>(full._writes[0]);
 
-      itype = backtrack_calle_save(block, std::get<MultiReg>(inst._reads[0])._low, i);
+      itype = backtrack_calle_save(cursor, std::get<MultiReg>(full._reads[0])._low);
 
       if (itype == PerilogueInstructionType::kCalleeGPRSave) {
         stack.variable_for_offset(store_loc._offset)->_is_frame_storage = true;
       }
-    } else if (inst._op == InstOperation::kLwz && inst._binst.ra() == GPR::kR1) {
-      MemRegOff read_loc = std::get<MemRegOff>(inst._reads[0]);
-      GPR read_reg = std::get<GPRSlice>(inst._writes[0])._reg;
+    } else if (inst._op == InstOperation::kLwz && inst.binst().ra() == GPR::kR1) {
+      MetaInst const& full = inst.expand();
+      MemRegOff read_loc = std::get<MemRegOff>(full._reads[0]);
+      GPR read_reg = std::get<GPRSlice>(full._writes[0])._reg;
       if (stack.variable_for_offset(read_loc._offset)->_is_frame_storage) {
         if (read_reg == GPR::kR0) {
           itype = PerilogueInstructionType::kLoadSenderLR;
@@ -88,9 +92,10 @@ void perilogue_block_analysis(BasicBlock& block, SubroutineStack& stack, BinaryC
           itype = PerilogueInstructionType::kLoadSenderLR;
         }
       }
-    } else if (inst._op == InstOperation::kLmw && inst._binst.ra() == GPR::kR1) {
-      MemRegOff read_loc = std::get<MemRegOff>(inst._reads[0]);
-      GPR read_reg = std::get<MultiReg>(inst._writes[0])._low;
+    } else if (inst._op == InstOperation::kLmw && inst.binst().ra() == GPR::kR1) {
+      MetaInst const& full = inst.expand();
+      MemRegOff read_loc = std::get<MemRegOff>(full._reads[0]);
+      GPR read_reg = std::get<MultiReg>(full._writes[0])._low;
       if (stack.variable_for_offset(read_loc._offset)->_is_frame_storage) {
         if (read_reg == GPR::kR0) {
           itype = PerilogueInstructionType::kLoadSenderLR;
@@ -101,7 +106,7 @@ void perilogue_block_analysis(BasicBlock& block, SubroutineStack& stack, BinaryC
     } else if (inst._op == InstOperation::kB && is_abi_routine(ctx, inst.branch_target())) {
       itype = PerilogueInstructionType::kAbiRoutine;
       assert(i > 0);
-      MetaInst const& load_base_inst = block._instructions[i - 1];
+      MetaInst const& load_base_inst = block._instructions[i - 1].expand();
       if (load_base_inst._op == InstOperation::kAddi &&
           std::get<GPRSlice>(load_base_inst._writes[0])._reg == GPR::kR11 &&
           std::get<GPRSlice>(load_base_inst._reads[0])._reg == GPR::kR1) {
@@ -123,5 +128,6 @@ void run_perilogue_analysis(Subroutine& routine, BinaryContext const& ctx) {
   routine._graph->foreach_exit([&routine, &ctx](BasicBlockVertex& bbv) {
     perilogue_block_analysis(bbv.data(), *routine._stack, ctx);
   });
+  routine._products = routine._products | AnalysisProduct::kPerilogue;
 }
 }  // namespace decomp::ppc
@@ -3,9 +3,10 @@
 #include <cstdint>
 #include <vector>
 
+#include "ppc/Subroutine.hh"
+
 namespace decomp::ppc {
 struct BinaryContext;
-struct Subroutine;
 
 enum class PerilogueInstructionType : uint8_t {
   kNormalInst,
@@ -23,5 +24,8 @@ enum class PerilogueInstructionType : uint8_t {
   kFrameDeallocate,
 };
 
+constexpr PassRequirements kPeriloguePass = {"perilogue",
+  AnalysisProduct::kGraph | AnalysisProduct::kLiveness | AnalysisProduct::kStack,
+  AnalysisProduct::kPerilogue};
 void run_perilogue_analysis(Subroutine& subroutine, BinaryContext const& ctx);
 }  // namespace decomp::ppc
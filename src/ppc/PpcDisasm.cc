@@ -1,16 +1,489 @@
 #include "ppc/PpcDisasm.hh"
 
+#include <array>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <iostream>
+#include <type_traits>
+#include <variant>
 
 #include "ppc/BinInst.hh"
 #include "ppc/DataSource.hh"
+#include "utl/FlagsEnum.hh"
 #include "utl/ReservedVector.hh"
 
 namespace decomp::ppc {
 namespace {
-InstOperation op_for_psfunc(uint32_t op) {
+// Operand extraction recipes, each names one operand pulled out of the instruction word
+enum class Opnd : uint8_t {
+  kNone,
+  // GPRs
+  kRaW,
+  kRbW,
+  kRdW,
+  kRdB,
+  kRdH,
+  kRsW,
+  kRsB,
+  kRsH,
+  // rA, or literal 0 when rA is r0
+  kRaOrZero,
+  kMultiRs,
+  // FPRs
+  kFraS,
+  kFrbS,
+  kFrcS,
+  kFrdS,
+  kFrsS,
+  kFraD,
+  kFrbD,
+  kFrcD,
+  kFrdD,
+  kFrsD,
+  kFraP,
+  kFrbP,
+  kFrcP,
+  kFrdP,
+  kFrsP,
+  kFraV,
+  kFrbV,
+  kFrcV,
+  kFrdV,
+  // CR
+  kCrba,
+  kCrbb,
+  kCrbd,
+  kCrfd,
+  kBi,
+  // SPRs
+  kXer,
+  kLr,
+  kCtr,
+  // CTR, only written when BO says to decrement it
+  kCtrIfDecrement,
+  kSpr,
+  kTbr,
+  // Immediates
+  kSimm,
+  kUimm,
+  kTo,
+  kBo,
+  kBd,
+  kLi,
+  kSh,
+  kMb,
+  kMe,
+  kNb,
+  kSr,
+  kCrm,
+  kI17,
+  kI22,
+  kImm,
+  // Memory, X-form (rA + rB)
+  kMemXS1,
+  kMemXS2,
+  kMemXS4,
+  kMemXSingle,
+  kMemXDouble,
+  kMemXPacked,
+  // Memory, D-form (rA + d16)
+  kMemDS1,
+  kMemDS2,
+  kMemDS4,
+  kMemDSingle,
+  kMemDDouble,
+  // Memory, psq D-form (rA + d20)
+  kMemPsqD,
+  // Memory, string ops (rA + 0)
+  kMemS1Zero,
+  // FPSCR
+  kFpscrAll,
+  kFpscrFs,
+  kFpscrFsExceptions,
+  kFpscrFdWritable,
+  kFpscrBd,
+  kFpscrBdFx,
+  kFm,
+};
+
+enum class FlagRule : uint8_t {
+  // Leave _flags untouched
+  kKeep,
+  kRc,
+  kRcFp,
+  kRcOe,
+  kL,
+  kLk,
+  kAaLk,
+  kW,
+  kRecord,
+};
+
+template <typename Source, Opnd kKind>
+Source extract_operand(BinInst binst) {
+  // Reads and writes share the recipe list, operand kinds that can't be written never show up in a write slot
+  constexpr auto as_source = [](auto val) -> Source {
+    if constexpr (std::is_constructible_v<Source, decltype(val)>) {
+      return val;
+    } else {
+      assert(false);
+      return Source{};
+    }
+  };
+
+  switch (kKind) {
+    case Opnd::kRaW:
+      return binst.ra_w();
+    case Opnd::kRbW:
+      return binst.rb_w();
+    case Opnd::kRdW:
+      return binst.rd_w();
+    case Opnd::kRdB:
+      return binst.rd_b();
+    case Opnd::kRdH:
+      return binst.rd_h();
+    case Opnd::kRsW:
+      return binst.rs_w();
+    case Opnd::kRsB:
+      return binst.rs_b();
+    case Opnd::kRsH:
+      return binst.rs_h();
+    case Opnd::kRaOrZero:
+      if (binst.ra() != GPR::kR0) {
+        return binst.ra_w();
+      }
+      return as_source(AuxImm{0});
+    case Opnd::kMultiRs:
+      return MultiReg{binst.rs(), DataType::kS4};
+    case Opnd::kFraS:
+      return binst.fra_s();
+    case Opnd::kFrbS:
+      return binst.frb_s();
+    case Opnd::kFrcS:
+      return binst.frc_s();
+    case Opnd::kFrdS:
+      return binst.frd_s();
+    case Opnd::kFrsS:
+      return binst.frs_s();
+    case Opnd::kFraD:
+      return binst.fra_d();
+    case Opnd::kFrbD:
+      return binst.frb_d();
+    case Opnd::kFrcD:
+      return binst.frc_d();
+    case Opnd::kFrdD:
+      return binst.frd_d();
+    case Opnd::kFrsD:
+      return binst.frs_d();
+    case Opnd::kFraP:
+      return binst.fra_p();
+    case Opnd::kFrbP:
+      return binst.frb_p();
+    case Opnd::kFrcP:
+      return binst.frc_p();
+    case Opnd::kFrdP:
+      return binst.frd_p();
+    case Opnd::kFrsP:
+      return binst.frs_p();
+    case Opnd::kFraV:
+      return binst.fra_v();
+    case Opnd::kFrbV:
+      return binst.frb_v();
+    case Opnd::kFrcV:
+      return binst.frc_v();
+    case Opnd::kFrdV:
+      return binst.frd_v();
+    case Opnd::kCrba:
+      return binst.crba();
+    case Opnd::kCrbb:
+      return binst.crbb();
+    case Opnd::kCrbd:
+      return binst.crbd();
+    case Opnd::kCrfd:
+      return binst.crfd();
+    case Opnd::kBi:
+      return binst.bi();
+    case Opnd::kXer:
+      return SPR::kXer;
+    case Opnd::kLr:
+      return SPR::kLr;
+    case Opnd::kCtr:
+    case Opnd::kCtrIfDecrement:
+      return SPR::kCtr;
+    case Opnd::kSpr:
+      return binst.spr();
+    case Opnd::kTbr:
+      return binst.tbr();
+    case Opnd::kSimm:
+      return as_source(binst.simm());
+    case Opnd::kUimm:
+      return as_source(binst.uimm());
+    case Opnd::kTo:
+      return as_source(binst.to());
+    case Opnd::kBo:
+      return as_source(binst.bo());
+    case Opnd::kBd:
+      return as_source(binst.bd());
+    case Opnd::kLi:
+      return as_source(binst.li());
+    case Opnd::kSh:
+      return as_source(binst.sh());
+    case Opnd::kMb:
+      return as_source(binst.mb());
+    case Opnd::kMe:
+      return as_source(binst.me());
+    case Opnd::kNb:
+      return as_source(binst.nb());
+    case Opnd::kSr:
+      return as_source(binst.sr());
+    case Opnd::kCrm:
+      return as_source(binst.crm());
+    case Opnd::kI17:
+      return as_source(binst.i17());
+    case Opnd::kI22:
+      return as_source(binst.i22());
+    case Opnd::kImm:
+      return as_source(binst.imm());
+    case Opnd::kMemXS1:
+      return MemRegReg{binst.ra(), DataType::kS1, binst.rb()};
+    case Opnd::kMemXS2:
+      return MemRegReg{binst.ra(), DataType::kS2, binst.rb()};
+    case Opnd::kMemXS4:
+      return MemRegReg{binst.ra(), DataType::kS4, binst.rb()};
+    case Opnd::kMemXSingle:
+      return MemRegReg{binst.ra(), DataType::kSingle, binst.rb()};
+    case Opnd::kMemXDouble:
+      return MemRegReg{binst.ra(), DataType::kDouble, binst.rb()};
+    case Opnd::kMemXPacked:
+      return MemRegReg{binst.ra(), DataType::kPackedSingle, binst.rb()};
+    case Opnd::kMemDS1:
+      return MemRegOff{binst.ra(), DataType::kS1, binst.d16()};
+    case Opnd::kMemDS2:
+      return MemRegOff{binst.ra(), DataType::kS2, binst.d16()};
+    case Opnd::kMemDS4:
+      return MemRegOff{binst.ra(), DataType::kS4, binst.d16()};
+    case Opnd::kMemDSingle:
+      return MemRegOff{binst.ra(), DataType::kSingle, binst.d16()};
+    case Opnd::kMemDDouble:
+      return MemRegOff{binst.ra(), DataType::kDouble, binst.d16()};
+    case Opnd::kMemPsqD:
+      return MemRegOff{binst.ra(), DataType::kPackedSingle, binst.d20()};
+    case Opnd::kMemS1Zero:
+      return MemRegOff{binst.ra(), DataType::kS1, 0};
+    case Opnd::kFpscrAll:
+      return FPSCRBit::kAll;
+    case Opnd::kFpscrFs:
+      return binst.fpscrfs();
+    case Opnd::kFpscrFsExceptions:
+      return binst.fpscrfs() & FPSCRBit::kExceptionMask;
+    case Opnd::kFpscrFdWritable:
+      return binst.fpscrfd() & FPSCRBit::kWriteMask;
+    case Opnd::kFpscrBd:
+      return binst.fpscrbd();
+    case Opnd::kFpscrBdFx:
+      return binst.fpscrbd() | FPSCRBit::kFx;
+    case Opnd::kFm:
+      return binst.fm();
+    case Opnd::kNone:
+    default:
+      static_assert(kKind != Opnd::kNone, "Operand recipe slot left empty");
+      return Source{};
+  }
+}
+
+template <FlagRule kRule>
+constexpr InstFlags flags_for_rule(BinInst binst) {
+  switch (kRule) {
+    case FlagRule::kRc:
+      return binst.rc();
+    case FlagRule::kRcFp:
+      return binst.rc_fp();
+    case FlagRule::kRcOe:
+      return binst.rc() | binst.oe();
+    case FlagRule::kL:
+      return binst.l();
+    case FlagRule::kLk:
+      return binst.lk();
+    case FlagRule::kAaLk:
+      return binst.aa() | binst.lk();
+    case FlagRule::kW:
+      return binst.w();
+    case FlagRule::kRecord:
+      return InstFlags::kWritesRecord;
+    case FlagRule::kKeep:
+    default:
+      return InstFlags::kNone;
+  }
+}
+// Register masks straight from the encoding, kept in line with extract_operand. Working from the operand kind instead of
+// the built ReadSource/WriteSource keeps the mask updates branch free after fill is inlined
+template <Opnd kKind, bool kWrite>
+void note_operand(BinInst binst, InstRegMasks& regs) {
+  const auto gpr = [&regs](GPR reg) {
+    (kWrite ? regs._gpr_def : regs._gpr_use) |= gpr_mask(reg)._set;
+    regs._touches_r1 |= reg == GPR::kR1;
+  };
+  const auto fpr = [&regs](FPR reg) { (kWrite ? regs._fpr_def : regs._fpr_use) |= fpr_mask(reg)._set; };
+  const auto cr = [&regs](CRField field) {
+    (kWrite ? regs._cr_def : regs._cr_use) |= static_cast<uint8_t>(cr_mask(field)._set);
+  };
+  // Memory operands only read their address registers, even when stored to
+  const auto mem_off = [&regs](GPR base) {
+    regs._gpr_use |= gpr_mask(base)._set;
+    regs._touches_r1 |= base == GPR::kR1;
+  };
+  const auto mem_reg = [&regs](GPR base, GPR offset) { regs._gpr_use |= gpr_mask(base, offset)._set; };
+
+  switch (kKind) {
+    case Opnd::kRaW:
+      return gpr(binst.ra());
+    case Opnd::kRbW:
+      return gpr(binst.rb());
+    case Opnd::kRdW:
+    case Opnd::kRdB:
+    case Opnd::kRdH:
+      return gpr(binst.rd());
+    case Opnd::kRsW:
+    case Opnd::kRsB:
+    case Opnd::kRsH:
+      return gpr(binst.rs());
+    case Opnd::kRaOrZero:
+      if (binst.ra() != GPR::kR0) {
+        gpr(binst.ra());
+      }
+      return;
+    case Opnd::kMultiRs:
+      (kWrite ? regs._gpr_def : regs._gpr_use) |= gpr_range(binst.rs())._set;
+      return;
+    case Opnd::kFraS:
+    case Opnd::kFraD:
+    case Opnd::kFraP:
+    case Opnd::kFraV:
+      return fpr(binst.fra());
+    case Opnd::kFrbS:
+    case Opnd::kFrbD:
+    case Opnd::kFrbP:
+    case Opnd::kFrbV:
+      return fpr(binst.frb());
+    case Opnd::kFrcS:
+    case Opnd::kFrcD:
+    case Opnd::kFrcP:
+    case Opnd::kFrcV:
+      return fpr(binst.frc());
+    case Opnd::kFrdS:
+    case Opnd::kFrdD:
+    case Opnd::kFrdP:
+    case Opnd::kFrdV:
+      return fpr(binst.frd());
+    case Opnd::kFrsS:
+    case Opnd::kFrsD:
+    case Opnd::kFrsP:
+      return fpr(binst.frs());
+    case Opnd::kCrba:
+      return cr(binst.crba()._field);
+    case Opnd::kCrbb:
+      return cr(binst.crbb()._field);
+    case Opnd::kCrbd:
+      return cr(binst.crbd()._field);
+    case Opnd::kCrfd:
+      return cr(binst.crfd()._field);
+    case Opnd::kBi:
+      return cr(binst.bi()._field);
+    case Opnd::kMemXS1:
+    case Opnd::kMemXS2:
+    case Opnd::kMemXS4:
+    case Opnd::kMemXSingle:
+    case Opnd::kMemXDouble:
+    case Opnd::kMemXPacked:
+      return mem_reg(binst.ra(), binst.rb());
+    case Opnd::kMemDS1:
+    case Opnd::kMemDS2:
+    case Opnd::kMemDS4:
+    case Opnd::kMemDSingle:
+    case Opnd::kMemDDouble:
+    case Opnd::kMemPsqD:
+    case Opnd::kMemS1Zero:
+      return mem_off(binst.ra());
+    default:
+      // SPRs, immediates and FPSCR bits aren't tracked
+      return;
+  }
+}
+
+// Register effects that come from the flags rather than an explicit operand
+void finish_reg_masks(MetaInst& meta_out) {
+  InstRegMasks& regs = meta_out._regs;
+  if (check_flags(meta_out._flags, InstFlags::kWritesRecord)) {
+    regs._cr_def |= static_cast<uint8_t>(cr_mask(CRField::kCr0)._set);
+  }
+  if (check_flags(meta_out._flags, InstFlags::kWritesFpRecord)) {
+    regs._cr_def |= static_cast<uint8_t>(cr_mask(CRField::kCr1)._set);
+  }
+
+  regs._is_call = check_flags(meta_out._flags, InstFlags::kWritesLR) &&
+                  (meta_out._op == InstOperation::kB || meta_out._op == InstOperation::kBc ||
+                   meta_out._op == InstOperation::kBclr || meta_out._op == InstOperation::kBcctr);
+}
+
+template <Opnd... kKinds>
+struct R {};
+template <Opnd... kKinds>
+struct W {};
+
+// One instantiation per distinct operand/flag recipe, operand extraction is inlined straight-line code
+template <typename Reads, typename Writes, FlagRule kFlags>
+struct Form;
+template <Opnd... kReads, Opnd... kWrites, FlagRule kFlags>
+struct Form<R<kReads...>, W<kWrites...>, kFlags> {
+  static void fill(BinInst binst, MetaInst& meta_out) {
+    (push_read<kReads>(binst, meta_out), ...);
+    (push_write<kWrites>(binst, meta_out), ...);
+    if constexpr (kFlags != FlagRule::kKeep) {
+      meta_out._flags = flags_for_rule<kFlags>(binst);
+    }
+  }
+
+  template <Opnd kKind>
+  static void push_read(BinInst binst, MetaInst& meta_out) {
+    meta_out._reads.push_back(extract_operand<ReadSource, kKind>(binst));
+    if constexpr (kKind == Opnd::kBi) {
+      // BI is still encoded when BO says to ignore the condition, but the CR bit is never read then
+      if ((binst.bo()._val & 0b10000) != 0) {
+        return;
+      }
+    }
+    note_operand<kKind, false>(binst, meta_out._regs);
+  }
+
+  template <Opnd kKind>
+  static void push_write(BinInst binst, MetaInst& meta_out) {
+    if constexpr (kKind == Opnd::kCtrIfDecrement) {
+      if ((binst.bo()._val & 0b00100) != 0) {
+        return;
+      }
+    }
+    meta_out._writes.push_back(extract_operand<WriteSource, kKind>(binst));
+    note_operand<kKind, true>(binst, meta_out._regs);
+  }
+};
+
+using FillFn = void (*)(BinInst, MetaInst&);
+
+struct DecodeEntry {
+  InstOperation _op = InstOperation::kInvalid;
+  FillFn _fill = &Form<R<>, W<>, FlagRule::kKeep>::fill;
+  // Implicit FPSCR write appended after the explicit writes, kNone if there is none
+  FPSCRBit _fpscr = FPSCRBit::kNone;
+};
+
+template <typename Reads, typename Writes, FlagRule kFlags = FlagRule::kKeep>
+constexpr DecodeEntry inst(InstOperation op) {
+  return DecodeEntry{op, &Form<Reads, Writes, kFlags>::fill, FPSCRBit::kNone};
+}
+
+constexpr DecodeEntry kInvalidEntry = {};
+
+constexpr InstOperation op_for_psfunc(uint32_t op) {
   switch (op) {
     case 0:
       return InstOperation::kPs_cmpu0;
@@ -85,7 +558,7 @@ InstOperation op_for_psfunc(uint32_t op) {
   }
 }
 
-std::optional<FPSCRBit> fpscr_bits_for_psfunc(uint32_t op) {
+constexpr FPSCRBit fpscr_bits_for_psfunc(uint32_t op) {
   switch (op) {
     case 0:
     case 64:
@@ -130,724 +603,284 @@ std::optional<FPSCRBit> fpscr_bits_for_psfunc(uint32_t op) {
       return FPSCRBit::kFpcc | FPSCRBit::kFx | FPSCRBit::kVxsnan | FPSCRBit::kVxvc;
 
     default:
-      return std::nullopt;
+      return FPSCRBit::kNone;
   }
 }
 
-void disasm_opcode_4(BinInst binst, MetaInst& meta_out) {
-  uint32_t psfunc = binst.ext_range(21, 30);
-  bool search_again = false;
+// Paired singles, keyed on the 10 bit extended opcode. The A-form arithmetic (ps_add, ps_madd, ...) and indexed psq
+// loads/stores are keyed on the low 5/6 bits, so only their encodings with frC/W/I zero resolve to an operation
+constexpr DecodeEntry decode_opcode_4(uint32_t psfunc) {
+  using enum Opnd;
+  DecodeEntry ret;
   switch (psfunc) {
     case 40:
     case 72:
     case 136:
     case 264:
-      meta_out._reads.push_back(binst.frb_p());
-      meta_out._writes.push_back(binst.frd_p());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbP>, W<kFrdP>, FlagRule::kRcFp>(InstOperation::kInvalid);
       break;
     case 0:
     case 32:
     case 64:
     case 96:
-      meta_out._reads.push_back(binst.fra_p());
-      meta_out._reads.push_back(binst.frb_p());
-      meta_out._writes.push_back(binst.crfd());
+      ret = inst<R<kFraP, kFrbP>, W<kCrfd>>(InstOperation::kInvalid);
       break;
     case 528:
     case 560:
     case 592:
     case 624:
-      meta_out._reads.push_back(binst.fra_p());
-      meta_out._reads.push_back(binst.frb_p());
-      meta_out._writes.push_back(binst.frd_p());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFraP, kFrbP>, W<kFrdP>, FlagRule::kRcFp>(InstOperation::kInvalid);
       break;
     case 1014:
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
+      ret = inst<R<>, W<kMemXS4>>(InstOperation::kInvalid);
       break;
     default:
-      search_again = false;
       break;
   }
 
-  if (search_again) {
-    search_again = false;
-    switch (psfunc & 0b111111) {
-      case 6:
-      case 7:
-      case 38:
-      case 39:
-        meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kPackedSingle, binst.rb()});
-        meta_out._reads.push_back(binst.i22());
-        meta_out._writes.push_back(binst.frd_p());
-        meta_out._flags = binst.w();
-        break;
-      default:
-        search_again = true;
-        break;
-    }
-    psfunc &= 0b111111;
-  }
-
-  if (search_again) {
-    search_again = false;
-    switch (psfunc & 0b11111) {
-      case 18:
-      case 20:
-      case 21:
-        meta_out._reads.push_back(binst.fra_p());
-        meta_out._reads.push_back(binst.frb_p());
-        meta_out._writes.push_back(binst.frd_p());
-        meta_out._flags = binst.rc_fp();
-        break;
-      case 23:
-      case 28:
-      case 29:
-      case 30:
-      case 31:
-        meta_out._reads.push_back(binst.fra_p());
-        meta_out._reads.push_back(binst.frb_p());
-        meta_out._reads.push_back(binst.frc_p());
-        meta_out._writes.push_back(binst.frd_p());
-        meta_out._flags = binst.rc_fp();
-        break;
-      case 24:
-      case 26:
-        meta_out._reads.push_back(binst.frb_p());
-        meta_out._writes.push_back(binst.frd_p());
-        meta_out._flags = binst.rc_fp();
-        break;
-      case 25:
-        meta_out._reads.push_back(binst.fra_p());
-        meta_out._reads.push_back(binst.frc_p());
-        meta_out._writes.push_back(binst.frd_p());
-        meta_out._flags = binst.rc_fp();
-        break;
-      default:
-        search_again = true;
-        break;
-    }
-    psfunc &= 0b11111;
-  }
-
-  meta_out._op = op_for_psfunc(psfunc);
-  std::optional<FPSCRBit> bits = fpscr_bits_for_psfunc(psfunc);
-  if (bits) {
-    meta_out._writes.push_back(*bits);
-  }
+  ret._op = op_for_psfunc(psfunc);
+  ret._fpscr = fpscr_bits_for_psfunc(psfunc);
+  return ret;
 }
 
-void disasm_opcode_19(BinInst binst, MetaInst& meta_out) {
-  const uint32_t crfunc = binst.ext_range(21, 30);
-  constexpr auto fill_crbit_binop = [](BinInst binst, MetaInst& meta_out) {
-    meta_out._reads.push_back(binst.crba());
-    meta_out._reads.push_back(binst.crbb());
-    meta_out._writes.push_back(binst.crbd());
+constexpr DecodeEntry decode_opcode_19(uint32_t crfunc) {
+  using enum Opnd;
+  constexpr auto crbit_binop = [](InstOperation op) {
+    using enum Opnd;
+    return inst<R<kCrba, kCrbb>, W<kCrbd>>(op);
   };
 
   switch (crfunc) {
     case 0:
-      meta_out._op = InstOperation::kMcrf;
-      meta_out._reads.push_back(binst.crfd());
-      meta_out._writes.push_back(binst.crfd());
-      break;
+      return inst<R<kCrfd>, W<kCrfd>>(InstOperation::kMcrf);
     case 16:
-      meta_out._op = InstOperation::kBclr;
-      meta_out._reads.push_back(binst.bi());
-      meta_out._reads.push_back(SPR::kLr);
-      meta_out._reads.push_back(binst.bo());
-      if ((binst.bo()._val & 0b00100) == 0) {
-        meta_out._writes.push_back(SPR::kCtr);
-      }
-      meta_out._flags = binst.lk();
-      break;
+      return inst<R<kBi, kLr, kBo>, W<kCtrIfDecrement>, FlagRule::kLk>(InstOperation::kBclr);
     case 33:
-      meta_out._op = InstOperation::kCrnor;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCrnor);
     case 50:
-      meta_out._op = InstOperation::kRfi;
-      break;
+      return inst<R<>, W<>>(InstOperation::kRfi);
     case 129:
-      meta_out._op = InstOperation::kCrandc;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCrandc);
     case 150:
-      meta_out._op = InstOperation::kIsync;
-      break;
+      return inst<R<>, W<>>(InstOperation::kIsync);
     case 193:
-      meta_out._op = InstOperation::kCrxor;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCrxor);
     case 225:
-      meta_out._op = InstOperation::kCrnand;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCrnand);
     case 257:
-      meta_out._op = InstOperation::kCrand;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCrand);
     case 417:
-      meta_out._op = InstOperation::kCrorc;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCrorc);
     case 449:
-      meta_out._op = InstOperation::kCror;
-      fill_crbit_binop(binst, meta_out);
-      break;
+      return crbit_binop(InstOperation::kCror);
     case 528:
-      meta_out._op = InstOperation::kBcctr;
-      meta_out._reads.push_back(binst.bi());
-      meta_out._reads.push_back(SPR::kCtr);
-      meta_out._reads.push_back(binst.bo());
-      meta_out._flags = binst.lk();
-      break;
+      return inst<R<kBi, kCtr, kBo>, W<>, FlagRule::kLk>(InstOperation::kBcctr);
     default:
-      meta_out._op = InstOperation::kInvalid;
-      break;
+      return kInvalidEntry;
   }
 }
 
-void disasm_opcode_31(BinInst binst, MetaInst& meta_out) {
-  const uint32_t arith_func = binst.ext_range(21, 30);
-  bool not_found = false;
+// XO-form integer arithmetic, keyed on the 9 bit extended opcode (OE masked off)
+constexpr DecodeEntry decode_opcode_31_xo(uint32_t arith_func) {
+  using enum Opnd;
+  switch (arith_func) {
+    case 8:
+      return inst<R<kRaW, kRbW>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kSubfc);
+    case 10:
+      return inst<R<kRaW, kRbW>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kAddc);
+    case 40:
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRcOe>(InstOperation::kSubf);
+    case 104:
+      return inst<R<kRaW>, W<kRdW>, FlagRule::kRcOe>(InstOperation::kNeg);
+    case 136:
+      return inst<R<kRaW, kRbW, kXer>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kSubfe);
+    case 138:
+      return inst<R<kRaW, kRbW, kXer>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kAdde);
+    case 200:
+      return inst<R<kRaW, kXer>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kSubfze);
+    case 202:
+      return inst<R<kRaW, kXer>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kAddze);
+    case 232:
+      return inst<R<kRaW, kXer>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kSubfme);
+    case 234:
+      return inst<R<kRaW, kXer>, W<kRdW, kXer>, FlagRule::kRcOe>(InstOperation::kAddme);
+    case 235:
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRcOe>(InstOperation::kMullw);
+    case 266:
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRcOe>(InstOperation::kAdd);
+    case 459:
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRcOe>(InstOperation::kDivwu);
+    case 491:
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRcOe>(InstOperation::kDivw);
+    default:
+      return inst<R<>, W<>, FlagRule::kRcOe>(InstOperation::kInvalid);
+  }
+}
+
+constexpr DecodeEntry decode_opcode_31(uint32_t arith_func) {
+  using enum Opnd;
   switch (arith_func) {
     case 0:
-      meta_out._op = InstOperation::kCmp;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(binst.crfd());
-      meta_out._flags = binst.l();
-      break;
+      return inst<R<kRaW, kRbW, kXer>, W<kCrfd>, FlagRule::kL>(InstOperation::kCmp);
     case 4:
-      meta_out._op = InstOperation::kTw;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._reads.push_back(binst.to());
-      break;
+      return inst<R<kRaW, kRbW, kTo>, W<>>(InstOperation::kTw);
     case 11:
-      meta_out._op = InstOperation::kMulhwu;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.rd_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRc>(InstOperation::kMulhwu);
     case 19:
-      meta_out._op = InstOperation::kMfcr;
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<>, W<kRdW>>(InstOperation::kMfcr);
     case 20:
-      meta_out._op = InstOperation::kLwarx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kMemXS4>, W<kRdW>>(InstOperation::kLwarx);
     case 23:
-      meta_out._op = InstOperation::kLwzx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kMemXS4>, W<kRdW>>(InstOperation::kLwzx);
     case 24:
-      meta_out._op = InstOperation::kSlw;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kSlw);
     case 26:
-      meta_out._op = InstOperation::kCntlzw;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW>, W<kRaW>, FlagRule::kRc>(InstOperation::kCntlzw);
     case 28:
-      meta_out._op = InstOperation::kAnd;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kAnd);
     case 32:
-      meta_out._op = InstOperation::kCmpl;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(binst.crfd());
-      meta_out._flags = binst.l();
-      break;
+      return inst<R<kRaW, kRbW, kXer>, W<kCrfd>, FlagRule::kL>(InstOperation::kCmpl);
     case 54:
-      meta_out._op = InstOperation::kDcbst;
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<>, W<kMemXS4>>(InstOperation::kDcbst);
     case 60:
-      meta_out._op = InstOperation::kAndc;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kAndc);
     case 75:
-      meta_out._op = InstOperation::kMulhw;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.rd_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRaW, kRbW>, W<kRdW>, FlagRule::kRc>(InstOperation::kMulhw);
     case 83:
-      meta_out._op = InstOperation::kMfmsr;
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<>, W<kRdW>>(InstOperation::kMfmsr);
     case 86:
-      meta_out._op = InstOperation::kDcbf;
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<>, W<kMemXS4>>(InstOperation::kDcbf);
     case 87:
-      meta_out._op = InstOperation::kLbzx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS1, binst.rb()});
-      meta_out._writes.push_back(binst.rd_b());
-      break;
+      return inst<R<kMemXS1>, W<kRdB>>(InstOperation::kLbzx);
     case 119:
-      meta_out._op = InstOperation::kLbzux;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS1, binst.rb()});
-      meta_out._writes.push_back(binst.rd_b());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kMemXS1>, W<kRdB, kRaW>>(InstOperation::kLbzux);
     case 124:
-      meta_out._op = InstOperation::kNor;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kNor);
     case 144:
-      meta_out._op = InstOperation::kMtcrf;
-      meta_out._reads.push_back(binst.rs_w());
       // TODO: multiple CRFs? change this
-      meta_out._reads.push_back(binst.crm());
-      break;
+      return inst<R<kRsW, kCrm>, W<>>(InstOperation::kMtcrf);
     case 146:
-      meta_out._op = InstOperation::kMtmsr;
-      meta_out._reads.push_back(binst.rs_w());
-      break;
+      return inst<R<kRsW>, W<>>(InstOperation::kMtmsr);
     case 150:
-      meta_out._op = InstOperation::kStwcxDot;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      meta_out._flags = InstFlags::kWritesRecord;
-      break;
+      return inst<R<kRsW, kXer>, W<kMemXS4>, FlagRule::kRecord>(InstOperation::kStwcxDot);
     case 151:
-      meta_out._op = InstOperation::kStwx;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<kRsW>, W<kMemXS4>>(InstOperation::kStwx);
     case 183:
-      meta_out._op = InstOperation::kStwux;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kRsW>, W<kMemXS4, kRaW>>(InstOperation::kStwux);
     case 210:
-      meta_out._op = InstOperation::kMtsr;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.sr());
-      break;
+      return inst<R<kRsW, kSr>, W<>>(InstOperation::kMtsr);
     case 215:
-      meta_out._op = InstOperation::kStbx;
-      meta_out._reads.push_back(binst.rs_b());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS1, binst.rb()});
-      break;
+      return inst<R<kRsB>, W<kMemXS1>>(InstOperation::kStbx);
     case 242:
-      meta_out._op = InstOperation::kMtsrin;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      break;
+      return inst<R<kRsW, kRbW>, W<>>(InstOperation::kMtsrin);
     case 246:
-      meta_out._op = InstOperation::kDcbtst;
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<>, W<kMemXS4>>(InstOperation::kDcbtst);
     case 247:
-      meta_out._op = InstOperation::kStbux;
-      meta_out._reads.push_back(binst.rs_b());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS1, binst.rb()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kRsB>, W<kMemXS1, kRaW>>(InstOperation::kStbux);
     case 278:
-      meta_out._op = InstOperation::kDcbt;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<kMemXS4>, W<>>(InstOperation::kDcbt);
     case 279:
-      meta_out._op = InstOperation::kLhzx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      meta_out._writes.push_back(binst.rd_h());
-      break;
+      return inst<R<kMemXS2>, W<kRdH>>(InstOperation::kLhzx);
     case 284:
-      meta_out._op = InstOperation::kEqv;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kEqv);
     case 306:
-      meta_out._op = InstOperation::kTlbie;
-      meta_out._reads.push_back(binst.rb_w());
-      break;
+      return inst<R<kRbW>, W<>>(InstOperation::kTlbie);
     case 310:
-      meta_out._op = InstOperation::kEciwx;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kRaW, kRbW>, W<kRdW>>(InstOperation::kEciwx);
     case 311:
-      meta_out._op = InstOperation::kLhzux;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      meta_out._writes.push_back(binst.rd_h());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kMemXS2>, W<kRdH, kRaW>>(InstOperation::kLhzux);
     case 316:
-      meta_out._op = InstOperation::kXor;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kXor);
     case 339:
-      meta_out._op = InstOperation::kMfspr;
-      meta_out._reads.push_back(binst.spr());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kSpr>, W<kRdW>>(InstOperation::kMfspr);
     case 343:
-      meta_out._op = InstOperation::kLhax;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      meta_out._writes.push_back(binst.rd_h());
-      break;
+      return inst<R<kMemXS2>, W<kRdH>>(InstOperation::kLhax);
     case 371:
-      meta_out._op = InstOperation::kMftb;
-      meta_out._reads.push_back(binst.tbr());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kTbr>, W<kRdW>>(InstOperation::kMftb);
     case 375:
-      meta_out._op = InstOperation::kLhaux;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      meta_out._writes.push_back(binst.rd_h());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kMemXS2>, W<kRdH, kRaW>>(InstOperation::kLhaux);
     case 407:
-      meta_out._op = InstOperation::kSthx;
-      meta_out._reads.push_back(binst.rs_h());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      break;
+      return inst<R<kRsH>, W<kMemXS2>>(InstOperation::kSthx);
     case 412:
-      meta_out._op = InstOperation::kOrc;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kOrc);
     case 438:
-      meta_out._op = InstOperation::kEcowx;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<kRsW>, W<kMemXS4>>(InstOperation::kEcowx);
     case 439:
-      meta_out._op = InstOperation::kSthux;
-      meta_out._reads.push_back(binst.rs_h());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kRsH>, W<kMemXS2, kRaW>>(InstOperation::kSthux);
     case 444:
-      meta_out._op = InstOperation::kOr;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kOr);
     case 467:
-      meta_out._op = InstOperation::kMtspr;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(binst.spr());
-      break;
+      return inst<R<kRsW>, W<kSpr>>(InstOperation::kMtspr);
     case 470:
-      meta_out._op = InstOperation::kDcbi;
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<>, W<kMemXS4>>(InstOperation::kDcbi);
     case 476:
-      meta_out._op = InstOperation::kNand;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kNand);
     case 512:
-      meta_out._op = InstOperation::kMcrxr;
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(binst.crfd());
-      meta_out._writes.push_back(SPR::kXer);
-      break;
+      return inst<R<kXer>, W<kCrfd, kXer>>(InstOperation::kMcrxr);
     case 533:
-      meta_out._op = InstOperation::kLswx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kMemXS4>, W<kRdW>>(InstOperation::kLswx);
     case 534:
-      meta_out._op = InstOperation::kLwbrx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kMemXS4>, W<kRdW>>(InstOperation::kLwbrx);
     case 535:
-      meta_out._op = InstOperation::kLfsx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kSingle, binst.rb()});
-      meta_out._writes.push_back(binst.frd_s());
-      break;
+      return inst<R<kMemXSingle>, W<kFrdS>>(InstOperation::kLfsx);
     case 536:
-      meta_out._op = InstOperation::kSrw;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW>, FlagRule::kRc>(InstOperation::kSrw);
     case 566:
-      meta_out._op = InstOperation::kTlbsync;
-      break;
+      return inst<R<>, W<>>(InstOperation::kTlbsync);
     case 567:
-      meta_out._op = InstOperation::kLfsux;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kSingle, binst.rb()});
-      meta_out._writes.push_back(binst.frd_s());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kMemXSingle>, W<kFrdS, kRaW>>(InstOperation::kLfsux);
     case 595:
-      meta_out._op = InstOperation::kMfsr;
-      meta_out._reads.push_back(binst.sr());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kSr>, W<kRdW>>(InstOperation::kMfsr);
     case 597:
-      meta_out._op = InstOperation::kLswi;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS1, 0});
-      meta_out._reads.push_back(binst.nb());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kMemS1Zero, kNb>, W<kRdW>>(InstOperation::kLswi);
     case 598:
-      meta_out._op = InstOperation::kSync;
-      break;
+      return inst<R<>, W<>>(InstOperation::kSync);
     case 599:
-      meta_out._op = InstOperation::kLfdx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kDouble, binst.rb()});
-      meta_out._writes.push_back(binst.frd_d());
-      break;
+      return inst<R<kMemXDouble>, W<kFrdD>>(InstOperation::kLfdx);
     case 631:
-      meta_out._op = InstOperation::kLfdux;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kDouble, binst.rb()});
-      meta_out._writes.push_back(binst.frd_d());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kMemXDouble>, W<kFrdD, kRaW>>(InstOperation::kLfdux);
     case 659:
-      meta_out._op = InstOperation::kMfsrin;
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
+      return inst<R<kRbW>, W<kRdW>>(InstOperation::kMfsrin);
     case 661:
-      meta_out._op = InstOperation::kStswx;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<kRsW, kXer>, W<kMemXS4>>(InstOperation::kStswx);
     case 662:
-      meta_out._op = InstOperation::kStwbrx;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<kRsW>, W<kMemXS4>>(InstOperation::kStwbrx);
     case 663:
-      meta_out._op = InstOperation::kStfsx;
-      meta_out._reads.push_back(binst.frs_s());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kSingle, binst.rb()});
-      break;
+      return inst<R<kFrsS>, W<kMemXSingle>>(InstOperation::kStfsx);
     case 695:
-      meta_out._op = InstOperation::kStfsux;
-      meta_out._reads.push_back(binst.frs_s());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kSingle, binst.rb()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kFrsS>, W<kMemXSingle, kRaW>>(InstOperation::kStfsux);
     case 725:
-      meta_out._op = InstOperation::kStswi;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.nb());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS1, 0});
-      break;
+      return inst<R<kRsW, kNb>, W<kMemS1Zero>>(InstOperation::kStswi);
     case 727:
-      meta_out._op = InstOperation::kStfdx;
-      meta_out._reads.push_back(binst.frs_d());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kDouble, binst.rb()});
-      break;
+      return inst<R<kFrsD>, W<kMemXDouble>>(InstOperation::kStfdx);
     case 759:
-      meta_out._op = InstOperation::kStfdux;
-      meta_out._reads.push_back(binst.frs_d());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kDouble, binst.rb()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
+      return inst<R<kFrsD>, W<kMemXDouble, kRaW>>(InstOperation::kStfdux);
     case 790:
-      meta_out._op = InstOperation::kLhbrx;
-      meta_out._reads.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      meta_out._writes.push_back(binst.rd_h());
-      break;
+      return inst<R<kMemXS2>, W<kRdH>>(InstOperation::kLhbrx);
     case 792:
-      meta_out._op = InstOperation::kSraw;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._writes.push_back(SPR::kXer);
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kRbW>, W<kRaW, kXer>, FlagRule::kRc>(InstOperation::kSraw);
     case 824:
-      meta_out._op = InstOperation::kSrawi;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.sh());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._writes.push_back(SPR::kXer);
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsW, kSh>, W<kRaW, kXer>, FlagRule::kRc>(InstOperation::kSrawi);
     case 854:
-      meta_out._op = InstOperation::kEieio;
-      break;
+      return inst<R<>, W<>>(InstOperation::kEieio);
     case 918:
-      meta_out._op = InstOperation::kSthbrx;
-      meta_out._reads.push_back(binst.rs_h());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS2, binst.rb()});
-      break;
+      return inst<R<kRsH>, W<kMemXS2>>(InstOperation::kSthbrx);
     case 922:
-      meta_out._op = InstOperation::kExtsh;
-      meta_out._reads.push_back(binst.rs_h());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsH>, W<kRaW>, FlagRule::kRc>(InstOperation::kExtsh);
     case 954:
-      meta_out._op = InstOperation::kExtsb;
-      meta_out._reads.push_back(binst.rs_b());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
+      return inst<R<kRsB>, W<kRaW>, FlagRule::kRc>(InstOperation::kExtsb);
     case 982:
-      meta_out._op = InstOperation::kIcbi;
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<>, W<kMemXS4>>(InstOperation::kIcbi);
     case 983:
-      meta_out._op = InstOperation::kStfiwx;
-      meta_out._reads.push_back(binst.frs_s());
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<kFrsS>, W<kMemXS4>>(InstOperation::kStfiwx);
     case 1014:
-      meta_out._op = InstOperation::kDcbz;
-      meta_out._writes.push_back(MemRegReg{binst.ra(), DataType::kS4, binst.rb()});
-      break;
+      return inst<R<>, W<kMemXS4>>(InstOperation::kDcbz);
     default:
-      not_found = true;
-      break;
-  }
-
-  if (not_found) {
-    switch (arith_func & 0b111111111) {
-      case 8:
-        meta_out._op = InstOperation::kSubfc;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 10:
-        meta_out._op = InstOperation::kAddc;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 40:
-        meta_out._op = InstOperation::kSubf;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        break;
-      case 104:
-        meta_out._op = InstOperation::kNeg;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._writes.push_back(binst.rd_w());
-        break;
-      case 136:
-        meta_out._op = InstOperation::kSubfe;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._reads.push_back(SPR::kXer);
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 138:
-        meta_out._op = InstOperation::kAdde;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._reads.push_back(SPR::kXer);
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 200:
-        meta_out._op = InstOperation::kSubfze;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(SPR::kXer);
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 202:
-        meta_out._op = InstOperation::kAddze;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(SPR::kXer);
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 232:
-        meta_out._op = InstOperation::kSubfme;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(SPR::kXer);
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 234:
-        meta_out._op = InstOperation::kAddme;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(SPR::kXer);
-        meta_out._writes.push_back(binst.rd_w());
-        meta_out._writes.push_back(SPR::kXer);
-        break;
-      case 235:
-        meta_out._op = InstOperation::kMullw;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        break;
-      case 266:
-        meta_out._op = InstOperation::kAdd;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        break;
-      case 459:
-        meta_out._op = InstOperation::kDivwu;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        break;
-      case 491:
-        meta_out._op = InstOperation::kDivw;
-        meta_out._reads.push_back(binst.ra_w());
-        meta_out._reads.push_back(binst.rb_w());
-        meta_out._writes.push_back(binst.rd_w());
-        break;
-      default:
-        meta_out._op = InstOperation::kInvalid;
-        break;
-    }
-    meta_out._flags = binst.rc() | binst.oe();
+      return decode_opcode_31_xo(arith_func & 0b111111111);
   }
 }
 
-std::optional<FPSCRBit> fpscr_bits_for_fs_func(uint32_t func) {
+constexpr FPSCRBit fpscr_bits_for_fs_func(uint32_t func) {
   switch (func) {
     case 18:
       return FPSCRBit::kFprf | FPSCRBit::kFr | FPSCRBit::kFi | FPSCRBit::kFx | FPSCRBit::kOx | FPSCRBit::kUx |
@@ -869,82 +902,51 @@ std::optional<FPSCRBit> fpscr_bits_for_fs_func(uint32_t func) {
       return FPSCRBit::kFprf | FPSCRBit::kFr | FPSCRBit::kFi | FPSCRBit::kFx | FPSCRBit::kOx | FPSCRBit::kUx |
              FPSCRBit::kXx | FPSCRBit::kVxsnan | FPSCRBit::kVxisi | FPSCRBit::kVximz;
     default:
-      return std::nullopt;
+      return FPSCRBit::kNone;
   }
 }
 
-void disasm_opcode_59(BinInst binst, MetaInst& meta_out) {
-  const uint32_t float_single_func = binst.ext_range(26, 30);
+// Single precision A-form, keyed on the 5 bit extended opcode
+constexpr DecodeEntry decode_opcode_59(uint32_t float_single_func) {
+  using enum Opnd;
+  DecodeEntry ret = inst<R<>, W<>, FlagRule::kRcFp>(InstOperation::kInvalid);
   switch (float_single_func) {
     case 18:
-      meta_out._op = InstOperation::kFdivs;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFdivs);
       break;
     case 20:
-      meta_out._op = InstOperation::kFsubs;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFsubs);
       break;
     case 21:
-      meta_out._op = InstOperation::kFadds;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFadds);
       break;
     case 24:
-      meta_out._op = InstOperation::kFres;
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFrbS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFres);
       break;
     case 25:
-      meta_out._op = InstOperation::kFmuls;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frc_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrcS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFmuls);
       break;
     case 28:
-      meta_out._op = InstOperation::kFmsubs;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._reads.push_back(binst.frc_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS, kFrcS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFmsubs);
       break;
     case 29:
-      meta_out._op = InstOperation::kFmadds;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._reads.push_back(binst.frc_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS, kFrcS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFmadds);
       break;
     case 30:
-      meta_out._op = InstOperation::kFnmsubs;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._reads.push_back(binst.frc_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS, kFrcS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFnmsubs);
       break;
     case 31:
-      meta_out._op = InstOperation::kFnmadds;
-      meta_out._reads.push_back(binst.fra_s());
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._reads.push_back(binst.frc_s());
-      meta_out._writes.push_back(binst.frd_s());
+      ret = inst<R<kFraS, kFrbS, kFrcS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFnmadds);
       break;
     default:
-      meta_out._op = InstOperation::kInvalid;
       break;
   }
-  meta_out._flags = binst.rc_fp();
-  std::optional<FPSCRBit> bits = fpscr_bits_for_fs_func(float_single_func);
-  if (bits) {
-    meta_out._writes.push_back(*bits);
-  }
+
+  ret._fpscr = fpscr_bits_for_fs_func(float_single_func);
+  return ret;
 }
 
-std::optional<FPSCRBit> fpscr_bits_for_fd_func(uint32_t func) {
+constexpr FPSCRBit fpscr_bits_for_fd_func(uint32_t func) {
   switch (func) {
     case 0:
       return FPSCRBit::kFpcc | FPSCRBit::kVxsnan;
@@ -986,583 +988,265 @@ std::optional<FPSCRBit> fpscr_bits_for_fd_func(uint32_t func) {
       return FPSCRBit::kFpcc | FPSCRBit::kFx | FPSCRBit::kVxsnan | FPSCRBit::kVxvc;
 
     default:
-      return std::nullopt;
+      return FPSCRBit::kNone;
+  }
+}
+
+// Double precision A-form, keyed on the 5 bit extended opcode
+constexpr DecodeEntry decode_opcode_63_a(uint32_t float_double_func) {
+  using enum Opnd;
+  switch (float_double_func) {
+    case 18:
+      return inst<R<kFraD, kFrbD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFdiv);
+    case 20:
+      return inst<R<kFraD, kFrbD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFsub);
+    case 21:
+      return inst<R<kFraD, kFrbD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFadd);
+    case 23:
+      return inst<R<kFraV, kFrbV, kFrcV>, W<kFrdV>, FlagRule::kRcFp>(InstOperation::kFsel);
+    case 25:
+      return inst<R<kFraD, kFrcD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFmul);
+    case 26:
+      return inst<R<kFrbS>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFrsqrte);
+    case 28:
+      return inst<R<kFraD, kFrbD, kFrcD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFmsub);
+    case 29:
+      return inst<R<kFraD, kFrbD, kFrcD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFmadd);
+    case 30:
+      return inst<R<kFraD, kFrbD, kFrcD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFnmsub);
+    case 31:
+      return inst<R<kFraD, kFrbD, kFrcD>, W<kFrdD>, FlagRule::kRcFp>(InstOperation::kFnmadd);
+    default:
+      return inst<R<>, W<>, FlagRule::kRcFp>(InstOperation::kInvalid);
   }
 }
 
-void disasm_opcode_63(BinInst binst, MetaInst& meta_out) {
-  uint32_t float_double_func = binst.ext_range(21, 30);
-  bool not_found = false;
+constexpr DecodeEntry decode_opcode_63(uint32_t float_double_func) {
+  using enum Opnd;
+  DecodeEntry ret;
   switch (float_double_func) {
     case 0:
-      meta_out._op = InstOperation::kFcmpu;
-      meta_out._reads.push_back(binst.fra_v());
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.crfd());
+      ret = inst<R<kFraV, kFrbV>, W<kCrfd>>(InstOperation::kFcmpu);
       break;
     case 12:
-      meta_out._op = InstOperation::kFrsp;
-      meta_out._reads.push_back(binst.frb_d());
-      meta_out._writes.push_back(binst.frd_s());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbD>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFrsp);
       break;
     case 14:
-      meta_out._op = InstOperation::kFctiw;
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.frd_s());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbV>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFctiw);
       break;
     case 15:
-      meta_out._op = InstOperation::kFctiwz;
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.frd_s());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbV>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kFctiwz);
       break;
     case 32:
-      meta_out._op = InstOperation::kFcmpo;
-      meta_out._reads.push_back(binst.fra_v());
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.crfd());
+      ret = inst<R<kFraV, kFrbV>, W<kCrfd>>(InstOperation::kFcmpo);
       break;
     case 38:
-      meta_out._op = InstOperation::kMtfsb1;
-      meta_out._writes.push_back(binst.fpscrbd() | FPSCRBit::kFx);
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<>, W<kFpscrBdFx>, FlagRule::kRcFp>(InstOperation::kMtfsb1);
       break;
     case 40:
-      meta_out._op = InstOperation::kFneg;
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.frd_v());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbV>, W<kFrdV>, FlagRule::kRcFp>(InstOperation::kFneg);
       break;
-    case 64: {
-      meta_out._op = InstOperation::kMcrfs;
-      meta_out._reads.push_back(binst.fpscrfs());
-      meta_out._writes.push_back(binst.crfd());
-      meta_out._writes.push_back(binst.fpscrfs() & FPSCRBit::kExceptionMask);
+    case 64:
+      ret = inst<R<kFpscrFs>, W<kCrfd, kFpscrFsExceptions>>(InstOperation::kMcrfs);
       break;
-    }
     case 70:
-      meta_out._op = InstOperation::kMtfsb0;
-      meta_out._writes.push_back(binst.fpscrbd());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<>, W<kFpscrBd>, FlagRule::kRcFp>(InstOperation::kMtfsb0);
       break;
     case 72:
-      meta_out._op = InstOperation::kFmr;
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.frd_v());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbV>, W<kFrdV>, FlagRule::kRcFp>(InstOperation::kFmr);
       break;
     case 134:
-      meta_out._op = InstOperation::kMtfsfi;
-      meta_out._reads.push_back(binst.imm());
-      meta_out._writes.push_back(binst.fpscrfd() & FPSCRBit::kWriteMask);
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kImm>, W<kFpscrFdWritable>, FlagRule::kRcFp>(InstOperation::kMtfsfi);
       break;
     case 136:
-      meta_out._op = InstOperation::kFnabs;
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.frd_v());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbV>, W<kFrdV>, FlagRule::kRcFp>(InstOperation::kFnabs);
       break;
     case 264:
-      meta_out._op = InstOperation::kFabs;
-      meta_out._reads.push_back(binst.frb_v());
-      meta_out._writes.push_back(binst.frd_v());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbV>, W<kFrdV>, FlagRule::kRcFp>(InstOperation::kFabs);
       break;
     case 583:
-      meta_out._op = InstOperation::kMffs;
-      meta_out._reads.push_back(FPSCRBit::kAll);
-      meta_out._writes.push_back(binst.frd_s());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFpscrAll>, W<kFrdS>, FlagRule::kRcFp>(InstOperation::kMffs);
       break;
     case 711:
-      meta_out._op = InstOperation::kMtfsf;
-      meta_out._reads.push_back(binst.frb_s());
-      meta_out._writes.push_back(binst.fm());
-      meta_out._flags = binst.rc_fp();
+      ret = inst<R<kFrbS>, W<kFm>, FlagRule::kRcFp>(InstOperation::kMtfsf);
       break;
     default:
-      not_found = true;
+      float_double_func &= 0b11111;
+      ret = decode_opcode_63_a(float_double_func);
       break;
   }
 
-  if (not_found) {
-    float_double_func &= 0b11111;
-    switch (float_double_func) {
-      case 18:
-        meta_out._op = InstOperation::kFdiv;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 20:
-        meta_out._op = InstOperation::kFsub;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 21:
-        meta_out._op = InstOperation::kFadd;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 23:
-        meta_out._op = InstOperation::kFsel;
-        meta_out._reads.push_back(binst.fra_v());
-        meta_out._reads.push_back(binst.frb_v());
-        meta_out._reads.push_back(binst.frc_v());
-        meta_out._writes.push_back(binst.frd_v());
-        break;
-      case 25:
-        meta_out._op = InstOperation::kFmul;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frc_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 26:
-        meta_out._op = InstOperation::kFrsqrte;
-        meta_out._reads.push_back(binst.frb_s());
-        meta_out._writes.push_back(binst.frd_s());
-        break;
-      case 28:
-        meta_out._op = InstOperation::kFmsub;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._reads.push_back(binst.frc_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 29:
-        meta_out._op = InstOperation::kFmadd;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._reads.push_back(binst.frc_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 30:
-        meta_out._op = InstOperation::kFnmsub;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._reads.push_back(binst.frc_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      case 31:
-        meta_out._op = InstOperation::kFnmadd;
-        meta_out._reads.push_back(binst.fra_d());
-        meta_out._reads.push_back(binst.frb_d());
-        meta_out._reads.push_back(binst.frc_d());
-        meta_out._writes.push_back(binst.frd_d());
-        break;
-      default:
-        meta_out._op = InstOperation::kInvalid;
-        break;
-    }
-
-    meta_out._flags = binst.rc_fp();
-  }
-
-  std::optional<FPSCRBit> bits = fpscr_bits_for_fd_func(float_double_func);
-  if (bits) {
-    meta_out._writes.push_back(*bits);
-  }
+  ret._fpscr = fpscr_bits_for_fd_func(float_double_func);
+  return ret;
 }
-}  // namespace
-
-void disasm_single(uint32_t vaddr, uint32_t raw_inst, MetaInst& meta_out) {
-  const BinInst binst{raw_inst};
-  meta_out._binst = binst;
-  meta_out._va = vaddr;
 
-  switch (binst.opcd()) {
+constexpr DecodeEntry decode_primary(uint32_t opcd) {
+  using enum Opnd;
+  switch (opcd) {
     case 3:
-      meta_out._op = InstOperation::kTwi;
-      meta_out._reads.push_back(binst.to());
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.simm());
-      break;
-
-    case 4:
-      disasm_opcode_4(binst, meta_out);
-      break;
-
+      return inst<R<kTo, kRaW, kSimm>, W<>>(InstOperation::kTwi);
     case 7:
-      meta_out._op = InstOperation::kMulli;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.simm());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
-
+      return inst<R<kRaW, kSimm>, W<kRdW>>(InstOperation::kMulli);
     case 8:
-      meta_out._op = InstOperation::kSubfic;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.simm());
-      meta_out._writes.push_back(binst.rd_w());
-      meta_out._writes.push_back(SPR::kXer);
-      break;
-
+      return inst<R<kRaW, kSimm>, W<kRdW, kXer>>(InstOperation::kSubfic);
     case 10:
-      meta_out._op = InstOperation::kCmpli;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(binst.crfd());
-      meta_out._flags = binst.l();
-      break;
-
+      return inst<R<kRaW, kUimm, kXer>, W<kCrfd>, FlagRule::kL>(InstOperation::kCmpli);
     case 11:
-      meta_out._op = InstOperation::kCmpi;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.simm());
-      meta_out._reads.push_back(SPR::kXer);
-      meta_out._writes.push_back(binst.crfd());
-      meta_out._flags = binst.l();
-      break;
-
+      return inst<R<kRaW, kSimm, kXer>, W<kCrfd>, FlagRule::kL>(InstOperation::kCmpi);
     case 12:
-      meta_out._op = InstOperation::kAddic;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.simm());
-      meta_out._writes.push_back(binst.rd_w());
-      meta_out._writes.push_back(SPR::kXer);
-      break;
-
+      return inst<R<kRaW, kSimm>, W<kRdW, kXer>>(InstOperation::kAddic);
     case 13:
-      meta_out._op = InstOperation::kAddicDot;
-      meta_out._reads.push_back(binst.ra_w());
-      meta_out._reads.push_back(binst.simm());
-      meta_out._writes.push_back(binst.rd_w());
-      meta_out._writes.push_back(SPR::kXer);
-      meta_out._flags = InstFlags::kWritesRecord;
-      break;
-
+      return inst<R<kRaW, kSimm>, W<kRdW, kXer>, FlagRule::kRecord>(InstOperation::kAddicDot);
     case 14:
-      meta_out._op = InstOperation::kAddi;
-      if (binst.ra() != GPR::kR0) {
-        meta_out._reads.push_back(binst.ra_w());
-      } else {
-        meta_out._reads.push_back(AuxImm{0});
-      }
-      meta_out._reads.push_back(binst.simm());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
-
+      return inst<R<kRaOrZero, kSimm>, W<kRdW>>(InstOperation::kAddi);
     case 15:
-      meta_out._op = InstOperation::kAddis;
-      if (binst.ra() != GPR::kR0) {
-        meta_out._reads.push_back(binst.ra_w());
-      } else {
-        meta_out._reads.push_back(AuxImm{0});
-      }
-      meta_out._reads.push_back(binst.simm());
-      meta_out._writes.push_back(binst.rd_w());
-      break;
-
+      return inst<R<kRaOrZero, kSimm>, W<kRdW>>(InstOperation::kAddis);
     case 16:
-      meta_out._op = InstOperation::kBc;
-      meta_out._reads.push_back(binst.bi());
-      meta_out._reads.push_back(binst.bo());
-      meta_out._reads.push_back(binst.bd());
-      if ((binst.bo()._val & 0b00100) == 0) {
-        meta_out._writes.push_back(SPR::kCtr);
-      }
-      meta_out._flags = binst.aa() | binst.lk();
-      break;
-
+      return inst<R<kBi, kBo, kBd>, W<kCtrIfDecrement>, FlagRule::kAaLk>(InstOperation::kBc);
     case 17:
-      meta_out._op = InstOperation::kSc;
-      break;
-
+      return inst<R<>, W<>>(InstOperation::kSc);
     case 18:
-      meta_out._op = InstOperation::kB;
-      meta_out._reads.push_back(binst.li());
-      meta_out._flags = binst.aa() | binst.lk();
-      break;
-
-    case 19:
-      disasm_opcode_19(binst, meta_out);
-      break;
-
+      return inst<R<kLi>, W<>, FlagRule::kAaLk>(InstOperation::kB);
     case 20:
-      meta_out._op = InstOperation::kRlwimi;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.sh());
-      meta_out._reads.push_back(binst.mb());
-      meta_out._reads.push_back(binst.me());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
-
+      return inst<R<kRsW, kSh, kMb, kMe>, W<kRaW>, FlagRule::kRc>(InstOperation::kRlwimi);
     case 21:
-      meta_out._op = InstOperation::kRlwinm;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.sh());
-      meta_out._reads.push_back(binst.mb());
-      meta_out._reads.push_back(binst.me());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
-
+      return inst<R<kRsW, kSh, kMb, kMe>, W<kRaW>, FlagRule::kRc>(InstOperation::kRlwinm);
     case 23:
-      meta_out._op = InstOperation::kRlwnm;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.rb_w());
-      meta_out._reads.push_back(binst.mb());
-      meta_out._reads.push_back(binst.me());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.rc();
-      break;
-
+      return inst<R<kRsW, kRbW, kMb, kMe>, W<kRaW>, FlagRule::kRc>(InstOperation::kRlwnm);
     case 24:
-      meta_out._op = InstOperation::kOri;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsW, kUimm>, W<kRaW>>(InstOperation::kOri);
     case 25:
-      meta_out._op = InstOperation::kOris;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsW, kUimm>, W<kRaW>>(InstOperation::kOris);
     case 26:
-      meta_out._op = InstOperation::kXori;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsW, kUimm>, W<kRaW>>(InstOperation::kXori);
     case 27:
-      meta_out._op = InstOperation::kXoris;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsW, kUimm>, W<kRaW>>(InstOperation::kXoris);
     case 28:
-      meta_out._op = InstOperation::kAndiDot;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = InstFlags::kWritesRecord;
-      break;
-
+      return inst<R<kRsW, kUimm>, W<kRaW>, FlagRule::kRecord>(InstOperation::kAndiDot);
     case 29:
-      meta_out._op = InstOperation::kAndisDot;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._reads.push_back(binst.uimm());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = InstFlags::kWritesRecord;
-      break;
-
-    case 31:
-      disasm_opcode_31(binst, meta_out);
-      break;
-
+      return inst<R<kRsW, kUimm>, W<kRaW>, FlagRule::kRecord>(InstOperation::kAndisDot);
     case 32:
-      meta_out._op = InstOperation::kLwz;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS4, binst.d16()});
-      meta_out._writes.push_back(binst.rd_w());
-      break;
-
+      return inst<R<kMemDS4>, W<kRdW>>(InstOperation::kLwz);
     case 33:
-      meta_out._op = InstOperation::kLwzu;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS4, binst.d16()});
-      meta_out._writes.push_back(binst.rd_w());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kMemDS4>, W<kRdW, kRaW>>(InstOperation::kLwzu);
     case 34:
-      meta_out._op = InstOperation::kLbz;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS1, binst.d16()});
-      meta_out._writes.push_back(binst.rd_b());
-      break;
-
+      return inst<R<kMemDS1>, W<kRdB>>(InstOperation::kLbz);
     case 35:
-      meta_out._op = InstOperation::kLbzu;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS1, binst.d16()});
-      meta_out._writes.push_back(binst.rd_b());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kMemDS1>, W<kRdB, kRaW>>(InstOperation::kLbzu);
     case 36:
-      meta_out._op = InstOperation::kStw;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS4, binst.d16()});
-      break;
-
+      return inst<R<kRsW>, W<kMemDS4>>(InstOperation::kStw);
     case 37:
-      meta_out._op = InstOperation::kStwu;
-      meta_out._reads.push_back(binst.rs_w());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS4, binst.d16()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsW>, W<kMemDS4, kRaW>>(InstOperation::kStwu);
     case 38:
-      meta_out._op = InstOperation::kStb;
-      meta_out._reads.push_back(binst.rs_b());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS1, binst.d16()});
-      break;
-
+      return inst<R<kRsB>, W<kMemDS1>>(InstOperation::kStb);
     case 39:
-      meta_out._op = InstOperation::kStbu;
-      meta_out._reads.push_back(binst.rs_b());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS1, binst.d16()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsB>, W<kMemDS1, kRaW>>(InstOperation::kStbu);
     case 40:
-      meta_out._op = InstOperation::kLhz;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS2, binst.d16()});
-      meta_out._writes.push_back(binst.rd_h());
-      break;
-
+      return inst<R<kMemDS2>, W<kRdH>>(InstOperation::kLhz);
     case 41:
-      meta_out._op = InstOperation::kLhzu;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS2, binst.d16()});
-      meta_out._writes.push_back(binst.rd_h());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kMemDS2>, W<kRdH, kRaW>>(InstOperation::kLhzu);
     case 42:
-      meta_out._op = InstOperation::kLha;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS2, binst.d16()});
-      meta_out._writes.push_back(binst.rd_h());
-      break;
-
+      return inst<R<kMemDS2>, W<kRdH>>(InstOperation::kLha);
     case 43:
-      meta_out._op = InstOperation::kLhau;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS2, binst.d16()});
-      meta_out._writes.push_back(binst.rd_h());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kMemDS2>, W<kRdH, kRaW>>(InstOperation::kLhau);
     case 44:
-      meta_out._op = InstOperation::kSth;
-      meta_out._reads.push_back(binst.rs_h());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS2, binst.d16()});
-      break;
-
+      return inst<R<kRsH>, W<kMemDS2>>(InstOperation::kSth);
     case 45:
-      meta_out._op = InstOperation::kSthu;
-      meta_out._reads.push_back(binst.rs_h());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS2, binst.d16()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kRsH>, W<kMemDS2, kRaW>>(InstOperation::kSthu);
     case 46:
-      meta_out._op = InstOperation::kLmw;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kS4, binst.d16()});
-      meta_out._writes.push_back(MultiReg{binst.rs(), DataType::kS4});
-      break;
-
+      return inst<R<kMemDS4>, W<kMultiRs>>(InstOperation::kLmw);
     case 47:
-      meta_out._op = InstOperation::kStmw;
-      meta_out._reads.push_back(MultiReg{binst.rs(), DataType::kS4});
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kS4, binst.d16()});
-      break;
-
+      return inst<R<kMultiRs>, W<kMemDS4>>(InstOperation::kStmw);
     case 48:
-      meta_out._op = InstOperation::kLfs;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kSingle, binst.d16()});
-      meta_out._writes.push_back(binst.frd_s());
-      break;
-
+      return inst<R<kMemDSingle>, W<kFrdS>>(InstOperation::kLfs);
     case 49:
-      meta_out._op = InstOperation::kLfsu;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kSingle, binst.d16()});
-      meta_out._writes.push_back(binst.frd_s());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kMemDSingle>, W<kFrdS, kRaW>>(InstOperation::kLfsu);
     case 50:
-      meta_out._op = InstOperation::kLfd;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kDouble, binst.d16()});
-      meta_out._writes.push_back(binst.frd_d());
-      break;
-
+      return inst<R<kMemDDouble>, W<kFrdD>>(InstOperation::kLfd);
     case 51:
-      meta_out._op = InstOperation::kLfdu;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kDouble, binst.d16()});
-      meta_out._writes.push_back(binst.frd_d());
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kMemDDouble>, W<kFrdD, kRaW>>(InstOperation::kLfdu);
     case 52:
-      meta_out._op = InstOperation::kStfs;
-      meta_out._reads.push_back(binst.frs_s());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kSingle, binst.d16()});
-      break;
-
+      return inst<R<kFrsS>, W<kMemDSingle>>(InstOperation::kStfs);
     case 53:
-      meta_out._op = InstOperation::kStfsu;
-      meta_out._reads.push_back(binst.frs_s());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kSingle, binst.d16()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kFrsS>, W<kMemDSingle, kRaW>>(InstOperation::kStfsu);
     case 54:
-      meta_out._op = InstOperation::kStfd;
-      meta_out._reads.push_back(binst.frs_d());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kDouble, binst.d16()});
-      break;
-
+      return inst<R<kFrsD>, W<kMemDDouble>>(InstOperation::kStfd);
     case 55:
-      meta_out._op = InstOperation::kStfdu;
-      meta_out._reads.push_back(binst.frs_d());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kDouble, binst.d16()});
-      meta_out._writes.push_back(binst.ra_w());
-      break;
-
+      return inst<R<kFrsD>, W<kMemDDouble, kRaW>>(InstOperation::kStfdu);
     case 56:
-      meta_out._op = InstOperation::kPsq_l;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kPackedSingle, binst.d20()});
-      meta_out._reads.push_back(binst.i17());
-      meta_out._writes.push_back(binst.frd_p());
-      meta_out._flags = binst.w();
-      break;
-
+      return inst<R<kMemPsqD, kI17>, W<kFrdP>, FlagRule::kW>(InstOperation::kPsq_l);
     case 57:
-      meta_out._op = InstOperation::kPsq_lu;
-      meta_out._reads.push_back(MemRegOff{binst.ra(), DataType::kPackedSingle, binst.d20()});
-      meta_out._reads.push_back(binst.i17());
-      meta_out._writes.push_back(binst.frd_p());
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.w();
-      break;
+      return inst<R<kMemPsqD, kI17>, W<kFrdP, kRaW>, FlagRule::kW>(InstOperation::kPsq_lu);
+    case 60:
+      return inst<R<kFrsP, kI17>, W<kMemPsqD>, FlagRule::kW>(InstOperation::kPsq_st);
+    case 61:
+      return inst<R<kFrsP, kI17>, W<kMemPsqD, kRaW>, FlagRule::kW>(InstOperation::kPsq_stu);
+    default:
+      return kInvalidEntry;
+  }
+}
 
-    case 59:
-      disasm_opcode_59(binst, meta_out);
-      break;
+// Where each primary opcode's entries live in kDecodeTable
+// Extended opcodes sit in bits 21-30 (or 26-30 for opcode 59), so the index is _base + ((word >> 1) & _mask)
+struct DecodeKey {
+  uint16_t _base;
+  uint16_t _mask;
+};
+
+constexpr size_t kNumPrimary = 64;
+constexpr size_t kOp4Base = kNumPrimary;
+constexpr size_t kOp19Base = kOp4Base + 1024;
+constexpr size_t kOp31Base = kOp19Base + 1024;
+constexpr size_t kOp59Base = kOp31Base + 1024;
+constexpr size_t kOp63Base = kOp59Base + 32;
+constexpr size_t kDecodeTableSize = kOp63Base + 1024;
+
+constexpr std::array<DecodeKey, kNumPrimary> kDecodeKeys = [] {
+  std::array<DecodeKey, kNumPrimary> ret{};
+  for (uint16_t opcd = 0; opcd < kNumPrimary; opcd++) {
+    ret[opcd] = DecodeKey{opcd, 0};
+  }
+  ret[4] = DecodeKey{kOp4Base, 0b1111111111};
+  ret[19] = DecodeKey{kOp19Base, 0b1111111111};
+  ret[31] = DecodeKey{kOp31Base, 0b1111111111};
+  ret[59] = DecodeKey{kOp59Base, 0b11111};
+  ret[63] = DecodeKey{kOp63Base, 0b1111111111};
+  return ret;
+}();
+
+constexpr std::array<DecodeEntry, kDecodeTableSize> kDecodeTable = [] {
+  std::array<DecodeEntry, kDecodeTableSize> ret{};
+  for (uint32_t i = 0; i < kNumPrimary; i++) {
+    ret[i] = decode_primary(i);
+  }
+  for (uint32_t i = 0; i < 1024; i++) {
+    ret[kOp4Base + i] = decode_opcode_4(i);
+    ret[kOp19Base + i] = decode_opcode_19(i);
+    ret[kOp31Base + i] = decode_opcode_31(i);
+    ret[kOp63Base + i] = decode_opcode_63(i);
+  }
+  for (uint32_t i = 0; i < 32; i++) {
+    ret[kOp59Base + i] = decode_opcode_59(i);
+  }
+  return ret;
+}();
 
-    case 60:
-      meta_out._op = InstOperation::kPsq_st;
-      meta_out._reads.push_back(binst.frs_p());
-      meta_out._reads.push_back(binst.i17());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kPackedSingle, binst.d20()});
-      meta_out._flags = binst.w();
-      break;
+}  // namespace
 
-    case 61:
-      meta_out._op = InstOperation::kPsq_stu;
-      meta_out._reads.push_back(binst.frs_p());
-      meta_out._reads.push_back(binst.i17());
-      meta_out._writes.push_back(MemRegOff{binst.ra(), DataType::kPackedSingle, binst.d20()});
-      meta_out._writes.push_back(binst.ra_w());
-      meta_out._flags = binst.w();
-      break;
+void disasm_single(uint32_t vaddr, uint32_t raw_inst, MetaInst& meta_out) {
+  const BinInst binst{raw_inst};
+  meta_out._binst = binst;
+  meta_out._va = vaddr;
 
-    case 63:
-      disasm_opcode_63(binst, meta_out);
-      break;
+  const DecodeKey key = kDecodeKeys[binst.opcd()];
+  DecodeEntry const& entry = kDecodeTable[key._base + ((raw_inst >> 1) & key._mask)];
 
-    default:
-      meta_out._op = InstOperation::kInvalid;
-      break;
+  meta_out._op = entry._op;
+  entry._fill(binst, meta_out);
+  if (entry._fpscr != FPSCRBit::kNone) {
+    meta_out._writes.push_back(entry._fpscr);
   }
+  finish_reg_masks(meta_out);
 }
 
 bool MetaInst::is_blr() const {
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <type_traits>
 #include <variant>
 
 #include "ppc/BinInst.hh"
@@ -12,7 +13,7 @@
 
 namespace decomp::ppc {
 // Operation as determined by the opcode and possible function code
-enum class InstOperation {
+enum class InstOperation : uint8_t {
   kAdd,
   kAddc,
   kAdde,
@@ -237,10 +238,55 @@ enum class InstOperation {
   kDcbz_l,
   kInvalid,
 };
+static_assert(static_cast<size_t>(InstOperation::kInvalid) < 256);
 
 // BO (branch operation?) type, mapped from instruction encoding to mnemonic
 enum class BOType { kDnzf, kDzf, kF, kDnzt, kDzt, kT, kDnz, kDz, kAlways, kInvalid };
 
+// Registers touched by an instruction, filled in by the decoder so dataflow passes work on masks instead of walking
+// operands. Calls only mark _is_call, what they clobber and return is up to the calling convention
+struct InstRegMasks {
+  uint32_t _gpr_use = 0;
+  uint32_t _gpr_def = 0;
+  uint32_t _fpr_use = 0;
+  uint32_t _fpr_def = 0;
+  uint8_t _cr_use = 0;
+  uint8_t _cr_def = 0;
+  // Branch that writes LR
+  bool _is_call = false;
+  // r1 appears as a GPR operand or as the base of a displacement memory operand
+  bool _touches_r1 = false;
+
+  template <typename SetType>
+  constexpr SetType use() const {
+    if constexpr (std::is_same_v<SetType, GprSet>) {
+      return GprSet(_gpr_use);
+    } else if constexpr (std::is_same_v<SetType, FprSet>) {
+      return FprSet(_fpr_use);
+    } else if constexpr (std::is_same_v<SetType, CrSet>) {
+      return CrSet(_cr_use);
+    }
+  }
+
+  // Every register written, including read-modify-write operands
+  template <typename SetType>
+  constexpr SetType writes() const {
+    if constexpr (std::is_same_v<SetType, GprSet>) {
+      return GprSet(_gpr_def);
+    } else if constexpr (std::is_same_v<SetType, FprSet>) {
+      return FprSet(_fpr_def);
+    } else if constexpr (std::is_same_v<SetType, CrSet>) {
+      return CrSet(_cr_def);
+    }
+  }
+
+  // Registers overwritten with a new value, read-modify-write operands only count as uses
+  template <typename SetType>
+  constexpr SetType def() const {
+    return writes<SetType>() - use<SetType>();
+  }
+};
+
 struct MetaInst {
   BinInst _binst;
   uint32_t _va;
@@ -251,6 +297,7 @@ struct MetaInst {
 
   InstOperation _op = InstOperation::kInvalid;
   InstFlags _flags = InstFlags::kNone;
+  InstRegMasks _regs;
 
   template <typename T>
   T get_read_op() const {
@@ -285,6 +332,41 @@ struct MetaInst {
   }
 };
 
+// Dense form of MetaInst for long lived per-block storage
+// The decoded instruction stays with the RandomAccessData it was read from, which has to outlive the block. Only the
+// address, operation and flags are kept inline for the checks every pass makes
+struct PackedInst {
+  MetaInst const* _meta = nullptr;
+  uint32_t _va = 0;
+  InstOperation _op = InstOperation::kInvalid;
+  InstFlags _flags = InstFlags::kNone;
+
+  PackedInst() = default;
+  explicit PackedInst(MetaInst const& inst) : _meta(&inst), _va(inst._va), _op(inst._op), _flags(inst._flags) {}
+
+  MetaInst const& expand() const { return *_meta; }
+  BinInst binst() const { return _meta->_binst; }
+  InstRegMasks const& regs() const { return _meta->_regs; }
+  reserved_vector<ReadSource, 4> const& reads() const { return _meta->_reads; }
+  reserved_vector<WriteSource, 2> const& writes() const { return _meta->_writes; }
+
+  template <typename T>
+  T get_read_op() const {
+    return _meta->get_read_op<T>();
+  }
+
+  template <typename T>
+  T get_write_op() const {
+    return _meta->get_write_op<T>();
+  }
+
+  bool is_blr() const { return _meta->is_blr(); }
+
+  constexpr bool is_direct_branch() const { return _op == InstOperation::kB || _op == InstOperation::kBc; }
+  uint32_t branch_target() const { return _meta->branch_target(); }
+};
+static_assert(sizeof(PackedInst) == 16);
+
 void disasm_single(uint32_t vaddr, uint32_t raw_inst, MetaInst& meta_out);
 
 BOType bo_type_from_imm(AuxImm imm);
@@ -0,0 +1,169 @@
+#include "ppc/ProgramDiscovery.hh"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+#include "ppc/BinaryContext.hh"
+#include "utl/ParallelFor.hh"
+
+namespace decomp::ppc {
+namespace {
+// Addresses already claimed by some worker, split into independently locked shards so workers rarely contend
+class ConcurrentAddressSet {
+private:
+  static constexpr size_t kShardBits = 6;
+
+  struct alignas(64) Shard {
+    std::mutex _lock;
+    std::unordered_set<uint32_t> _set;
+  };
+  std::array<Shard, 1 << kShardBits> _shards;
+
+public:
+  // True if the address wasn't in the set yet
+  bool insert(uint32_t address) {
+    Shard& shard = _shards[((address >> 2) * 0x9e3779b1u) >> (32 - kShardBits)];
+    std::lock_guard guard(shard._lock);
+    return shard._set.insert(address).second;
+  }
+};
+
+// Shared stack of subroutines left to analyze. Discovery is over once it's empty and no worker is busy, since only
+// busy workers can add more
+class DiscoveryWorklist {
+private:
+  std::mutex _lock;
+  std::condition_variable _cv;
+  std::vector<uint32_t> _pending;
+  size_t _busy = 0;
+
+public:
+  void push(std::span<uint32_t const> addresses) {
+    if (addresses.empty()) {
+      return;
+    }
+    {
+      std::lock_guard guard(_lock);
+      _pending.insert(_pending.end(), addresses.begin(), addresses.end());
+    }
+    if (addresses.size() == 1) {
+      _cv.notify_one();
+    } else {
+      _cv.notify_all();
+    }
+  }
+
+  // Blocks until there's work, nullopt once discovery is finished. Every popped address must be retired with finish
+  std::optional<uint32_t> pop() {
+    std::unique_lock guard(_lock);
+    _cv.wait(guard, [this] { return !_pending.empty() || _busy == 0; });
+    if (_pending.empty()) {
+      return std::nullopt;
+    }
+
+    const uint32_t address = _pending.back();
+    _pending.pop_back();
+    _busy++;
+    return address;
+  }
+
+  void finish() {
+    bool done;
+    {
+      std::lock_guard guard(_lock);
+      done = --_busy == 0 && _pending.empty();
+    }
+    if (done) {
+      _cv.notify_all();
+    }
+  }
+};
+
+bool is_followable_call(BinaryContext const& ctx, uint32_t target) {
+  return (target & 3) == 0 && !ctx._ram->read_span(target, 4).empty() && !is_abi_routine(ctx, target);
+}
+
+void discovery_worker(BinaryContext const& ctx,
+  DiscoveryWorklist& worklist,
+  ConcurrentAddressSet& seen,
+  std::vector<Subroutine>& found) {
+  std::vector<uint32_t> new_targets;
+  while (std::optional<uint32_t> start = worklist.pop()) {
+    Subroutine& routine = found.emplace_back();
+    routine._start_va = *start;
+    run_graph_analysis(routine, ctx, *start);
+
+    new_targets.clear();
+    for (uint32_t target : routine._graph->_direct_calls) {
+      if (is_followable_call(ctx, target) && seen.insert(target)) {
+        new_targets.push_back(target);
+      }
+    }
+    // Push before retiring this one so the worklist never looks finished while targets are outstanding
+    worklist.push(new_targets);
+    worklist.finish();
+  }
+}
+}  // namespace
+
+Subroutine const* FunctionTable::find(uint32_t start_va) const {
+  auto it = std::lower_bound(_routines.begin(), _routines.end(), start_va, [](Subroutine const& routine, uint32_t va) {
+    return routine._start_va < va;
+  });
+  return it == _routines.end() || it->_start_va != start_va ? nullptr : &*it;
+}
+
+FunctionTable discover_functions(BinaryContext const& ctx, std::span<uint32_t const> roots, size_t num_threads) {
+  num_threads = resolve_thread_count(num_threads);
+
+  DiscoveryWorklist worklist;
+  ConcurrentAddressSet seen;
+  std::vector<uint32_t> unique_roots;
+  for (uint32_t root : roots) {
+    if (is_followable_call(ctx, root) && seen.insert(root)) {
+      unique_roots.push_back(root);
+    }
+  }
+  worklist.push(unique_roots);
+
+  // Each worker collects into its own list, the calling thread is worker 0
+  std::vector<std::vector<Subroutine>> found(num_threads);
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(num_threads - 1);
+    for (size_t i = 1; i < num_threads; i++) {
+      workers.emplace_back([&ctx, &worklist, &seen, &found, i] { discovery_worker(ctx, worklist, seen, found[i]); });
+    }
+    discovery_worker(ctx, worklist, seen, found[0]);
+  }
+
+  FunctionTable table;
+  size_t total = 0;
+  for (std::vector<Subroutine> const& worker_found : found) {
+    total += worker_found.size();
+  }
+  table._routines.reserve(total);
+  for (std::vector<Subroutine>& worker_found : found) {
+    std::move(worker_found.begin(), worker_found.end(), std::back_inserter(table._routines));
+  }
+  std::sort(table._routines.begin(), table._routines.end(), [](Subroutine const& lhs, Subroutine const& rhs) {
+    return lhs._start_va < rhs._start_va;
+  });
+  return table;
+}
+
+ErrorOr<FunctionTable> discover_program(BinaryContext const& ctx, size_t num_threads) {
+  if (!ctx._entrypoint) {
+    return "Binary has no entrypoint to start discovery from";
+  }
+
+  const uint32_t entrypoint = *ctx._entrypoint;
+  return discover_functions(ctx, std::span<uint32_t const>(&entrypoint, 1), num_threads);
+}
+}  // namespace decomp::ppc
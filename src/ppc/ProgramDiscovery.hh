@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ppc/Subroutine.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+#include "utl/Either.hh"
+
+namespace decomp::ppc {
+struct BinaryContext;
+
+// Every subroutine reachable through direct calls, ordered by start address. Each one has had graph analysis run
+struct FunctionTable {
+  std::vector<Subroutine> _routines;
+
+  Subroutine const* find(uint32_t start_va) const;
+  Subroutine* find(uint32_t start_va) {
+    return const_cast<Subroutine*>(const_cast<FunctionTable const*>(this)->find(start_va));
+  }
+};
+
+// Follows direct calls transitively from each root across num_threads workers, 0 picks the hardware thread count
+// Calls into unmapped memory and the ABI save/restore helpers are not followed
+FunctionTable discover_functions(BinaryContext const& ctx, std::span<uint32_t const> roots, size_t num_threads = 0);
+// Same as above, rooted at the binary's entrypoint
+ErrorOr<FunctionTable> discover_program(BinaryContext const& ctx, size_t num_threads = 0);
+}  // namespace decomp::ppc
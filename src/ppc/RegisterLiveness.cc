@@ -1,9 +1,13 @@
 #include "ppc/RegisterLiveness.hh"
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
 #include <iterator>
 #include <queue>
 #include <set>
+#include <span>
 #include <variant>
 
 #include "ppc/BinaryContext.hh"
@@ -13,337 +17,539 @@
 #include "ppc/SubroutineGraph.hh"
 #include "producers/RandomAccessData.hh"
 #include "utl/FlagsEnum.hh"
+#include "utl/FlowGraphSnapshot.hh"
 
 namespace decomp::ppc {
 namespace {
-template <typename SetType>
-SetType uses_for_read(ReadSource const& read) {
-  SetType uses;
-  if constexpr (std::is_same_v<SetType, GprSet>) {
-    if (std::holds_alternative<GPRSlice>(read)) {
-      uses += std::get<GPRSlice>(read)._reg;
-    } else if (std::holds_alternative<MemRegReg>(read)) {
-      uses += gpr_mask(std::get<MemRegReg>(read)._base, std::get<MemRegReg>(read)._offset);
-    } else if (std::holds_alternative<MemRegOff>(read)) {
-      uses += std::get<MemRegOff>(read)._base;
-    } else if (std::holds_alternative<MultiReg>(read)) {
-      uses += gpr_range(std::get<MultiReg>(read)._low);
-    }
-  } else if constexpr (std::is_same_v<SetType, FprSet>) {
-    if (std::holds_alternative<FPRSlice>(read)) {
-      uses += std::get<FPRSlice>(read)._reg;
-    }
-  } else if constexpr (std::is_same_v<SetType, CrSet>) {
-    if (std::holds_alternative<CrSlice>(read)) {
-      uses += std::get<CrSlice>(read)._field;
+// Every register class side by side, GPRs in the low half of _lo, FPRs in its high half and CR fields in _hi, so a
+// single set operation covers the whole register file
+struct RegFileSet {
+  uint64_t _lo = 0;
+  uint64_t _hi = 0;
+
+  constexpr RegFileSet() = default;
+  constexpr RegFileSet(GprSet gpr, FprSet fpr, CrSet cr)
+      : _lo(gpr._set | (static_cast<uint64_t>(fpr._set) << 32)), _hi(cr._set) {}
+
+  template <typename SetType>
+  constexpr SetType get() const {
+    if constexpr (std::is_same_v<SetType, GprSet>) {
+      return GprSet(static_cast<uint32_t>(_lo));
+    } else if constexpr (std::is_same_v<SetType, FprSet>) {
+      return FprSet(static_cast<uint32_t>(_lo >> 32));
+    } else if constexpr (std::is_same_v<SetType, CrSet>) {
+      return CrSet(static_cast<uint32_t>(_hi));
     }
   }
-  return uses;
-}
 
-template <typename SetType>
-SetType uses_for_write(WriteSource const& write) {
-  SetType uses;
-  if constexpr (std::is_same_v<SetType, GprSet>) {
-    if (std::holds_alternative<MemRegReg>(write)) {
-      uses += gpr_mask(std::get<MemRegReg>(write)._base, std::get<MemRegReg>(write)._offset);
-    } else if (std::holds_alternative<MemRegOff>(write)) {
-      uses += std::get<MemRegOff>(write)._base;
-    }
+  constexpr bool empty() const { return (_lo | _hi) == 0; }
+  constexpr explicit operator bool() const { return !empty(); }
+  constexpr bool operator==(RegFileSet const& rhs) const = default;
+
+  // Set union
+  constexpr RegFileSet& operator+=(RegFileSet s) {
+    _lo |= s._lo;
+    _hi |= s._hi;
+    return *this;
+  }
+  // Set difference
+  constexpr RegFileSet& operator-=(RegFileSet s) {
+    _lo &= ~s._lo;
+    _hi &= ~s._hi;
+    return *this;
   }
-  return uses;
-}
 
-template <typename SetType>
-SetType defs_for_write(WriteSource const& write) {
-  SetType defs;
-  if constexpr (std::is_same_v<SetType, GprSet>) {
-    if (std::holds_alternative<GPRSlice>(write)) {
-      defs += std::get<GPRSlice>(write)._reg;
-    } else if (std::holds_alternative<MultiReg>(write)) {
-      defs += gpr_range(std::get<MultiReg>(write)._low);
-    }
-    return defs;
-  } else if constexpr (std::is_same_v<SetType, FprSet>) {
-    if (std::holds_alternative<FPRSlice>(write)) {
-      defs += std::get<FPRSlice>(write)._reg;
-    }
-  } else if constexpr (std::is_same_v<SetType, CrSet>) {
-    if (std::holds_alternative<CrSlice>(write)) {
-      defs += std::get<CrSlice>(write)._field;
-    }
+  // Set union
+  constexpr RegFileSet operator+(RegFileSet rhs) const { return RegFileSet(*this) += rhs; }
+  // Set difference
+  constexpr RegFileSet operator-(RegFileSet rhs) const { return RegFileSet(*this) -= rhs; }
+  // Set intersection
+  constexpr RegFileSet operator&(RegFileSet rhs) const {
+    RegFileSet ret;
+    ret._lo = _lo & rhs._lo;
+    ret._hi = _hi & rhs._hi;
+    return ret;
   }
-  return defs;
+};
+
+constexpr RegFileSet kReturnSet(kReturnSetGpr, kReturnSetFpr, kReturnSetCr);
+constexpr RegFileSet kParameterSet(kParameterSetGpr, kParameterSetFpr, kParameterSetCr);
+constexpr RegFileSet kCallerSaved(kCallerSavedGpr, kCallerSavedFpr, kCallerSavedCr);
+constexpr RegFileSet kKilledByCall(kKilledByCallGpr, kKilledByCallFpr, kKilledByCallCr);
+
+RegFileSet inst_uses(InstRegMasks const& regs) {
+  return RegFileSet(regs.use<GprSet>(), regs.use<FprSet>(), regs.use<CrSet>());
 }
 
-template <typename SetType>
-SetType defs_for_flags(InstFlags flags) {
-  SetType defs;
-  if constexpr (std::is_same_v<SetType, CrSet>) {
-    if (check_flags(flags, InstFlags::kWritesRecord)) {
-      defs += CRField::kCr0;
-    }
-    if (check_flags(flags, InstFlags::kWritesFpRecord)) {
-      defs += CRField::kCr1;
-    }
+RegFileSet inst_writes(InstRegMasks const& regs) {
+  return RegFileSet(regs.writes<GprSet>(), regs.writes<FprSet>(), regs.writes<CrSet>());
+}
+
+// Calls clobber and return through the calling convention's registers, except for the ABI save/restore helpers
+bool clobbers_as_call(PackedInst const& inst, BinaryContext const& ctx) {
+  return inst.regs()._is_call && (inst._op != InstOperation::kB || !is_abi_routine(ctx, inst.branch_target()));
+}
+
+// Register effects of a call as seen by the caller
+struct CallEffects {
+  // Registers the callee reads, defines with a meaningful value, and leaves with an unknown value
+  RegFileSet _use;
+  RegFileSet _def;
+  RegFileSet _kill;
+  // Registers that have to be treated as read when clearing unused sections
+  RegFileSet _maybe_use;
+};
+
+CallEffects call_effects(PackedInst const& inst, CalleeLookup const& callees) {
+  Subroutine const* callee = nullptr;
+  if (callees && inst._op == InstOperation::kB) {
+    callee = callees(inst.branch_target());
   }
-  return defs;
+
+  // Everything the ABI lets a callee touch, reading none of it but maybe any parameter. Once callers read the summary
+  // built from this, an unknown callee has to count as reading every parameter or forwarded arguments go missing
+  if (callee == nullptr) {
+    return {callees ? kParameterSet : RegFileSet(), kReturnSet, kKilledByCall, kParameterSet};
+  }
+
+  const RegFileSet clobbers(callee->_gpr_clobber, callee->_fpr_clobber, callee->_cr_clobber);
+  const RegFileSet params(callee->_gpr_param, callee->_fpr_param, CrSet());
+  return {params, clobbers & kReturnSet, clobbers - kReturnSet, params};
 }
 
-template <typename SetType>
-void eval_liveness_local(BasicBlock& block, BinaryContext const& ctx) {
-  auto rlt = get_liveness<SetType>(&block);
+// Liveness of one instruction across the register file
+struct InstLiveness {
+  RegFileSet _def;
+  RegFileSet _use;
+  RegFileSet _live_in;
+  RegFileSet _live_out;
+};
+
+// Summary of one block across the register file, mirroring RegisterLiveness
+struct BlockLiveness {
+  // Range of the block's instructions in LivenessState::_insts
+  size_t _first_inst = 0;
+  size_t _num_insts = 0;
+
+  RegFileSet _input;
+  RegFileSet _output;
+  RegFileSet _overwrite;
+  RegFileSet _routine_inputs;
+  RegFileSet _guess_out;
+  RegFileSet _propagated;
+  // Passthrough registers that backpropagation found a use for, live across the whole block
+  RegFileSet _passthrough_used;
+};
+
+// Working set of one liveness run, compressed into the per class RegisterLiveness structs once it's done
+struct LivenessState {
+  // Indexed by vertex, pseudo vertices are left empty
+  std::vector<BlockLiveness> _blocks;
+  // Instructions of every block back to back
+  std::vector<InstLiveness> _insts;
+
+  BlockLiveness& block(BasicBlockVertex const& bbv) { return _blocks[bbv._idx]; }
+  BlockLiveness& block(int idx) { return _blocks[idx]; }
+  std::span<InstLiveness> insts(BlockLiveness const& bl) { return {_insts.data() + bl._first_inst, bl._num_insts}; }
+};
+
+LivenessState make_state(SubroutineGraph& graph) {
+  LivenessState state;
+  state._blocks.resize(graph.size());
+  size_t num_insts = 0;
+  graph.foreach_real([&state, &num_insts](BasicBlockVertex const& bbv) {
+    BlockLiveness& bl = state.block(bbv);
+    bl._first_inst = num_insts;
+    bl._num_insts = bbv.data()._instructions.size();
+    num_insts += bl._num_insts;
+  });
+  state._insts.resize(num_insts);
+  return state;
+}
 
-  SetType inputs;
-  SetType outputs;
-  SetType def_mask;
+void eval_liveness_local(BasicBlock const& block,
+  BlockLiveness& bl,
+  std::span<InstLiveness> insts,
+  BinaryContext const& ctx,
+  CalleeLookup const& callees) {
+  RegFileSet inputs;
+  RegFileSet outputs;
+  RegFileSet def_mask;
+  RegFileSet live_out;
 
   for (size_t i = 0; i < block._instructions.size(); i++) {
-    MetaInst const& inst = block._instructions[i];
+    PackedInst const& inst = block._instructions[i];
 
     // Naming convention:
     // live_in: Registers live coming into this instruction
     // use: Register set accessed by this instruction
     // def: Register set modified by this instruction
     // kill: Register set killed with an unknown value by this instruction
-    SetType live_in;
-    SetType use;
-    SetType def;
-    SetType kill;
-
-    // Pre-fill live_in with previous instruction's live_out set
-    if (!rlt->_live_out.empty()) {
-      live_in = rlt->_live_out.back();
-    }
+    RegFileSet use;
+    RegFileSet def;
+    RegFileSet kill;
 
-    // TODO: floating point, control fields
     // Function calls => kill caller saves
-    if (check_flags(inst._flags, InstFlags::kWritesLR)) {
-      if (inst._op == InstOperation::kB && !is_abi_routine(ctx, inst.branch_target())) {
-        kill = std::get<SetType>(kRegSets._killed_by_caller);
-        def = std::get<SetType>(kRegSets._return_set);
-      } else if (inst._op == InstOperation::kBclr || inst._op == InstOperation::kBc ||
-                 inst._op == InstOperation::kBcctr) {
-        kill = std::get<SetType>(kRegSets._killed_by_caller);
-        def = std::get<SetType>(kRegSets._return_set);
+    if (inst.regs()._is_call) {
+      if (clobbers_as_call(inst, ctx)) {
+        const CallEffects effects = call_effects(inst, callees);
+        use = effects._use;
+        def = effects._def;
+        kill = effects._kill;
       }
     } else {
-      for (ReadSource const& read : inst._reads) {
-        use += uses_for_read<SetType>(read);
-      }
-      for (WriteSource const& write : inst._writes) {
-        use += uses_for_write<SetType>(write);
-        def += defs_for_write<SetType>(write);
-      }
-      def += defs_for_flags<SetType>(inst._flags);
-      // Any updating write does not count as a define
-      def -= use;
+      use = inst_uses(inst.regs());
+      def = inst_writes(inst.regs()) - use;
     }
 
-    def_mask += kill + def;
+    // Uses happen before defs and kills, which only matters for calls into summarized subroutines since everything
+    // else never uses what it defines or kills
     inputs += use - def_mask;
-    outputs = (outputs - kill + def + use);
-
-    rlt->_def.push_back(def);
-    rlt->_use.push_back(use);
-
-    rlt->_live_in.push_back(live_in);
-    rlt->_live_out.push_back(live_in + use + def - kill);
+    def_mask += kill + def;
+    outputs = (outputs + use - kill + def);
+
+    // Each instruction starts out with the previous instruction's live_out set
+    insts[i]._def = def;
+    insts[i]._use = use;
+    insts[i]._live_in = live_out;
+    live_out = live_out + use + def - kill;
+    insts[i]._live_out = live_out;
   }
 
-  rlt->_input = inputs;
-  rlt->_guess_out = outputs;
-  rlt->_overwrite = def_mask;
+  bl._input = inputs;
+  bl._guess_out = outputs;
+  bl._overwrite = def_mask;
 
-  SetType input_mask = inputs;
-  for (size_t i = 0; input_mask && i < block._instructions.size(); i++) {
-    rlt->_live_in[i] += input_mask;
-    input_mask -= rlt->_use[i];
-    rlt->_live_out[i] += input_mask;
+  RegFileSet input_mask = inputs;
+  for (size_t i = 0; input_mask && i < insts.size(); i++) {
+    insts[i]._live_in += input_mask;
+    input_mask -= insts[i]._use;
+    insts[i]._live_out += input_mask;
   }
 }
 
-template <typename SetType>
-bool backpropagate_outputs(SubroutineGraph& graph, BasicBlockVertex& bbv) {
-  auto rlt = get_liveness<SetType>(&bbv.data());
-
-  SetType outedge_inputs;
-  graph.foreach_real_outedge(
-    [&outedge_inputs](BasicBlockVertex& bbv) { outedge_inputs += get_liveness<SetType>(&bbv.data())->_input; }, &bbv);
-  if (graph.is_exit_vertex(&bbv)) {
-    outedge_inputs += std::get<SetType>(kRegSets._return_set);
+bool backpropagate_outputs(FlowGraphSnapshot const& shape, LivenessState& state, int idx) {
+  BlockLiveness& bl = state.block(idx);
+
+  RegFileSet outedge_inputs;
+  for (EdgeData const& ed : shape.successors(idx)) {
+    if (shape.is_real(ed._target)) {
+      outedge_inputs += state.block(ed._target)._input;
+    }
+  }
+  if (shape.is_exit(idx)) {
+    outedge_inputs += kReturnSet;
   }
 
-  SetType used_out = outedge_inputs & rlt->_guess_out;
+  RegFileSet used_out = outedge_inputs & bl._guess_out;
   if (used_out) {
-    rlt->_guess_out -= used_out;
-    rlt->_output += used_out;
+    bl._guess_out -= used_out;
+    bl._output += used_out;
   }
 
-  SetType used_pt = outedge_inputs & rlt->_propagated;
+  // The instructions only pick up the used passthrough registers once every block is settled, see
+  // clear_unused_sections
+  RegFileSet used_pt = outedge_inputs & bl._propagated;
   if (used_pt) {
-    rlt->_propagated -= used_pt;
-    rlt->_output += used_pt;
-    rlt->_input += used_pt;
-    for (size_t i = 0; i < bbv.data()._instructions.size(); i++) {
-      rlt->_live_in[i] += used_pt;
-      rlt->_live_out[i] += used_pt;
-    }
+    bl._propagated -= used_pt;
+    bl._output += used_pt;
+    bl._input += used_pt;
+    bl._passthrough_used += used_pt;
     return true;
   }
 
   return false;
 }
 
-template <typename SetType>
-bool propagate_guesses(SubroutineGraph& graph, BasicBlockVertex& bbv) {
-  auto rlt = get_liveness<SetType>(&bbv.data());
+bool propagate_guesses(FlowGraphSnapshot const& shape, LivenessState& state, int idx) {
+  BlockLiveness& bl = state.block(idx);
 
-  SetType passthrough_inputs;
-  graph.foreach_real_inedge(
-    [&passthrough_inputs](BasicBlockVertex& bbv) {
-      passthrough_inputs +=
-        get_liveness<SetType>(&bbv.data())->_guess_out + get_liveness<SetType>(&bbv.data())->_propagated;
-    },
-    &bbv);
+  RegFileSet passthrough_inputs;
+  for (EdgeData const& ed : shape.predecessors(idx)) {
+    if (shape.is_real(ed._target)) {
+      passthrough_inputs += state.block(ed._target)._guess_out + state.block(ed._target)._propagated;
+    }
+  }
 
   // Additional inputs should only include new (passthrough) registers
-  passthrough_inputs -= rlt->_overwrite + rlt->_input;
+  passthrough_inputs -= bl._overwrite + bl._input;
 
   // There was nothing new to propagate here
-  if (passthrough_inputs == rlt->_propagated) {
+  if (passthrough_inputs == bl._propagated) {
     return false;
   }
 
-  rlt->_propagated = passthrough_inputs;
+  bl._propagated = passthrough_inputs;
   return true;
 }
 
-template <typename SetType>
-void clear_unused_sections(BasicBlock& block, BinaryContext const& ctx) {
-  auto rlt = get_liveness<SetType>(&block);
+// Reachable blocks in reverse postorder, with each vertex's position in that order
+struct BlockOrder {
+  static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+  std::vector<int> _rpo;
+  std::vector<uint32_t> _position;
+};
+
+BlockOrder order_blocks(FlowGraphSnapshot const& shape) {
+  BlockOrder order;
+  for (int idx : shape.rpo()) {
+    if (shape.is_real(idx)) {
+      order._rpo.push_back(idx);
+    }
+  }
+
+  order._position.resize(shape.size(), BlockOrder::kUnreachable);
+  for (size_t i = 0; i < order._rpo.size(); i++) {
+    order._position[order._rpo[i]] = static_cast<uint32_t>(i);
+  }
+  return order;
+}
+
+// Blocks waiting for another evaluation, lowest rank first so a block has usually seen all of its updated neighbors
+// by the time it comes up
+class BlockWorklist {
+private:
+  std::vector<bool> _queued;
+  std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> _heap;
+
+public:
+  // Starts out with every rank queued
+  explicit BlockWorklist(size_t count) : _queued(count, true) {
+    for (size_t i = 0; i < count; i++) {
+      _heap.push(static_cast<uint32_t>(i));
+    }
+  }
+
+  void push(uint32_t rank) {
+    if (!_queued[rank]) {
+      _queued[rank] = true;
+      _heap.push(rank);
+    }
+  }
+
+  bool pop(uint32_t& rank) {
+    if (_heap.empty()) {
+      return false;
+    }
+    rank = _heap.top();
+    _heap.pop();
+    _queued[rank] = false;
+    return true;
+  }
+};
+
+// Evaluates blocks until transfer reports no more changes, requeuing the successors (Forward) or predecessors of a block
+// whenever its sets change. Forward problems go in reverse postorder, backward ones in postorder. Returns the number of
+// transfer calls
+template <bool Forward, typename Transfer>
+size_t worklist_to_fixpoint(FlowGraphSnapshot const& shape, BlockOrder const& order, Transfer&& transfer) {
+  const size_t count = order._rpo.size();
+  auto block_at = [&order, count](uint32_t rank) { return order._rpo[Forward ? rank : count - 1 - rank]; };
+
+  BlockWorklist worklist(count);
+  size_t visits = 0;
+  for (uint32_t rank; worklist.pop(rank); visits++) {
+    const int idx = block_at(rank);
+    if (!transfer(idx)) {
+      continue;
+    }
+
+    for (EdgeData const& ed : shape.edges<Forward>(idx)) {
+      // Pseudo vertices and blocks only reachable through dead code are left alone, as a sweep from the root never
+      // sees them either
+      const uint32_t position = order._position[ed._target];
+      if (position != BlockOrder::kUnreachable) {
+        worklist.push(Forward ? position : static_cast<uint32_t>(count - 1 - position));
+      }
+    }
+  }
+  return visits;
+}
+
+// Reference strategy: full sweeps in the same order as the worklist until one of them changes nothing
+template <bool Forward, typename Transfer>
+size_t sweep_to_fixpoint(BlockOrder const& order, Transfer&& transfer) {
+  const size_t count = order._rpo.size();
+  size_t visits = 0;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t i = 0; i < count; i++) {
+      changed |= transfer(order._rpo[Forward ? i : count - 1 - i]);
+    }
+    visits += count;
+  }
+  return visits;
+}
+
+void solve_cross_block(FlowGraphSnapshot const& shape,
+  LivenessState& state,
+  BlockOrder const& order,
+  LivenessSolver solver,
+  LivenessStats& stats) {
+  auto propagate = [&shape, &state](int idx) { return propagate_guesses(shape, state, idx); };
+  auto backpropagate = [&shape, &state](int idx) { return backpropagate_outputs(shape, state, idx); };
+
+  // Cycle 2: Propagate liveness guesses to outputs and from inputs until there are no more changes
+  // Cycle 3: Backpropagate liveness guesses from outputs and to inputs until there are no more changes
+  if (solver == LivenessSolver::kWorklist) {
+    stats._propagate_visits += worklist_to_fixpoint<true>(shape, order, propagate);
+    stats._backpropagate_visits += worklist_to_fixpoint<false>(shape, order, backpropagate);
+  } else {
+    stats._propagate_visits += sweep_to_fixpoint<true>(order, propagate);
+    stats._backpropagate_visits += sweep_to_fixpoint<false>(order, backpropagate);
+  }
+}
 
+void clear_unused_sections(BasicBlock const& block,
+  BlockLiveness const& bl,
+  std::span<InstLiveness> insts,
+  BinaryContext const& ctx,
+  CalleeLookup const& callees) {
   // Sweep through the block to clear out liveness for unused sections, E.G.
   // D=Def U=Use .=Neither
   // .....D.............U.........U............D......U.....
   //                              |____________|
   //                              unused section
-  SetType unused_mask = rlt->_guess_out;
-  for (size_t i = block._instructions.size(); i > 0; i--) {
-    MetaInst const& inst = block._instructions[i - 1];
-    rlt->_live_out[i - 1] -= unused_mask;
-
-    SetType possible_call_uses;
-    if (check_flags(inst._flags, InstFlags::kWritesLR)) {
-      if (inst._op == InstOperation::kB && !is_abi_routine(ctx, inst.branch_target())) {
-        possible_call_uses = std::get<SetType>(kRegSets._parameter_set);
-      } else if (inst._op == InstOperation::kBclr || inst._op == InstOperation::kBc ||
-                 inst._op == InstOperation::kBcctr) {
-        possible_call_uses = std::get<SetType>(kRegSets._parameter_set);
-      }
+  // Passthrough registers backpropagation found a use for are added on the way
+  RegFileSet unused_mask = bl._guess_out;
+  for (size_t i = insts.size(); i > 0; i--) {
+    InstLiveness& il = insts[i - 1];
+    il._live_out = il._live_out + bl._passthrough_used - unused_mask;
+
+    RegFileSet possible_call_uses;
+    if (clobbers_as_call(block._instructions[i - 1], ctx)) {
+      possible_call_uses = call_effects(block._instructions[i - 1], callees)._maybe_use;
+    }
+    unused_mask = unused_mask + il._def - il._use - possible_call_uses;
+    il._live_in = il._live_in + bl._passthrough_used - unused_mask;
+  }
+}
+
+void find_routine_params(FlowGraphSnapshot const& shape, LivenessState& state, int idx) {
+  RegFileSet provided;
+  for (EdgeData const& ed : shape.predecessors(idx)) {
+    if (shape.is_real(ed._target)) {
+      provided += state.block(ed._target)._output;
     }
-    unused_mask = unused_mask + rlt->_def[i - 1] - rlt->_use[i - 1] - possible_call_uses;
-    rlt->_live_in[i - 1] -= unused_mask;
   }
+
+  BlockLiveness& bl = state.block(idx);
+  bl._routine_inputs += (bl._input - provided) & kParameterSet;
+}
+
+// Only caller saved registers can be clobbered, the rest are assumed to be restored before returning
+RegFileSet find_routine_clobbers(BasicBlock const& block, BlockLiveness const& bl) {
+  // The overwrite set has everything calls leave behind, but read-modify-write operands only count as uses there
+  RegFileSet written = bl._overwrite;
+  for (PackedInst const& inst : block._instructions) {
+    written += inst_writes(inst.regs());
+  }
+  return written & kCallerSaved;
 }
 
 template <typename SetType>
-void find_routine_params(SubroutineGraph& graph, BasicBlockVertex& bbv) {
-  SetType expected = get_liveness<SetType>(&bbv.data())->_input;
-  SetType provided;
-  graph.foreach_real_inedge(
-    [&provided](BasicBlockVertex& bbv) { provided += get_liveness<SetType>(&bbv.data())->_output; }, &bbv);
-
-  get_liveness<SetType>(&bbv.data())->_routine_inputs +=
-    (expected - provided) & std::get<SetType>(kRegSets._parameter_set);
+std::unique_ptr<RegisterLiveness<typename SetType::RegType>> split_class(BasicBlock const& block,
+  BlockLiveness const& bl,
+  std::span<InstLiveness const> insts) {
+  using RegType = typename SetType::RegType;
+  auto rlt = std::make_unique<RegisterLiveness<RegType>>();
+  if (!insts.empty()) {
+    rlt->_block_live_in = insts.front()._live_in.get<SetType>();
+  }
+
+  auto flip_at = [&insts](size_t i) { return insts[i]._live_in.get<SetType>() ^ insts[i]._live_out.get<SetType>(); };
+  size_t num_changes = 0;
+  for (size_t i = 0; i < insts.size(); i++) {
+    num_changes += flip_at(i) ? 1 : 0;
+  }
+  rlt->_changes.reserve(num_changes);
+
+  for (size_t i = 0; i < insts.size(); i++) {
+    // The cursor relies on liveness carrying over unchanged between neighboring instructions
+    assert(i == 0 || insts[i]._live_in == insts[i - 1]._live_out);
+    if (const SetType flip = flip_at(i)) {
+      rlt->_changes.push_back({static_cast<uint32_t>(i), flip});
+    }
+
+    const SetType def = insts[i]._def.get<SetType>();
+    const SetType use = insts[i]._use.get<SetType>();
+    if (block._instructions[i].regs()._is_call && (def || use)) {
+      rlt->_call_regs.push_back({static_cast<uint32_t>(i), def, use});
+    }
+  }
+
+  rlt->_input = bl._input.get<SetType>();
+  rlt->_output = bl._output.get<SetType>();
+  rlt->_overwrite = bl._overwrite.get<SetType>();
+  rlt->_routine_inputs = bl._routine_inputs.get<SetType>();
+  rlt->_guess_out = bl._guess_out.get<SetType>();
+  rlt->_propagated = bl._propagated.get<SetType>();
+  return rlt;
 }
 }  // namespace
 
-// TODO(optimize): Optionally skip FPR liveness analysis:
-//  on initial disasm of the subroutine, have a marker if it has any FP instructions
-//  if none, skip FP analysis and either fill _fpr_lifetimes with nothing or leave it null
-void run_liveness_analysis(Subroutine& routine, BinaryContext const& ctx) {
-  struct IterState {
-    bool gpr_changed = false, gpr_done = false;
-    bool fpr_changed = false, fpr_done = false;
-    bool cr_changed = false, cr_done = false;
-    void iterate() {
-      gpr_done = !gpr_changed;
-      fpr_done = !fpr_changed;
-      cr_done = !cr_changed;
-      gpr_changed = false;
-      fpr_changed = false;
-      cr_changed = false;
-    }
-    bool done() const { return gpr_done && fpr_done && cr_done; }
-  };
+void run_liveness_analysis(Subroutine& routine,
+  BinaryContext const& ctx,
+  CalleeLookup const& callees,
+  LivenessSolver solver,
+  LivenessStats* stats) {
+  SubroutineGraph& graph = *routine._graph;
+  FlowGraphSnapshot const& shape = graph._shape;
+  // Every cycle works on GPRs, FPRs and CR fields at once, the per class results are compressed out at the end
+  LivenessState state = make_state(graph);
 
   // Cycle 1: Evaluate liveness within a block, ignoring neighbors
-  routine._graph->foreach_real([&ctx](BasicBlockVertex& bbv) {
-    bbv.data()._gpr_lifetimes = std::make_unique<GprLiveness>();
-    bbv.data()._fpr_lifetimes = std::make_unique<FprLiveness>();
-    bbv.data()._cr_lifetimes = std::make_unique<CrLiveness>();
-    eval_liveness_local<GprSet>(bbv.data(), ctx);
-    eval_liveness_local<FprSet>(bbv.data(), ctx);
-    eval_liveness_local<CrSet>(bbv.data(), ctx);
+  graph.foreach_real([&state, &ctx, &callees](BasicBlockVertex& bbv) {
+    BlockLiveness& bl = state.block(bbv);
+    eval_liveness_local(bbv.data(), bl, state.insts(bl), ctx, callees);
   });
 
-  // Cycle 2: Propagate GPR/FPR liveness guesses to outputs and from inputs iteratively until there are no more changes
-  for (IterState iter_state; !iter_state.done(); iter_state.iterate()) {
-    routine._graph->preorder_fwd(
-      [&iter_state, &routine](BasicBlockVertex& bbv) {
-        if (!bbv.is_real()) {
-          return;
-        }
-
-        if (!iter_state.gpr_done) {
-          iter_state.gpr_changed |= propagate_guesses<GprSet>(*routine._graph, bbv);
-        }
-        if (!iter_state.fpr_done) {
-          iter_state.fpr_changed |= propagate_guesses<FprSet>(*routine._graph, bbv);
-        }
-        if (!iter_state.cr_done) {
-          iter_state.cr_changed |= propagate_guesses<CrSet>(*routine._graph, bbv);
-        }
-      },
-      routine._graph->root());
-  }
-
-  // Cycle 3: Backpropagate GPR/FPR liveness guesses from outputs and to inputs into
-  for (IterState iter_state; !iter_state.done(); iter_state.iterate()) {
-    routine._graph->postorder_fwd(
-      [&iter_state, &routine](BasicBlockVertex& bbv) {
-        if (!bbv.is_real()) {
-          return;
-        }
-
-        if (!iter_state.gpr_done) {
-          iter_state.gpr_changed |= backpropagate_outputs<GprSet>(*routine._graph, bbv);
-        }
-        if (!iter_state.fpr_done) {
-          iter_state.fpr_changed |= backpropagate_outputs<FprSet>(*routine._graph, bbv);
-        }
-        if (!iter_state.cr_done) {
-          iter_state.cr_changed |= backpropagate_outputs<CrSet>(*routine._graph, bbv);
-        }
-      },
-      routine._graph->root());
-  }
+  // Cycles 2 and 3 only walk blocks reachable from the root
+  const BlockOrder order = order_blocks(shape);
+  LivenessStats local_stats;
+  LivenessStats& run_stats = stats != nullptr ? *stats : local_stats;
+  solve_cross_block(shape, state, order, solver, run_stats);
 
   // Cycle 4: Clear out regions where a register is effectively dead (see comment in clear_unused_sections)
-  routine._graph->foreach_real([&ctx](BasicBlockVertex& bbv) {
-    clear_unused_sections<GprSet>(bbv.data(), ctx);
-    clear_unused_sections<FprSet>(bbv.data(), ctx);
-    clear_unused_sections<CrSet>(bbv.data(), ctx);
+  graph.foreach_real([&state, &ctx, &callees](BasicBlockVertex& bbv) {
+    BlockLiveness const& bl = state.block(bbv);
+    clear_unused_sections(bbv.data(), bl, state.insts(bl), ctx, callees);
   });
 
-  // Cycle 5: Collect register-bound routine parameters into Subroutine::_gpr_param and Subroutine::_fpr_param
-  routine._graph->foreach_real([&routine](BasicBlockVertex& bbv) {
-    find_routine_params<GprSet>(*routine._graph, bbv);
-    find_routine_params<FprSet>(*routine._graph, bbv);
-    routine._gpr_param += bbv.data()._gpr_lifetimes->_routine_inputs;
-    routine._fpr_param += bbv.data()._fpr_lifetimes->_routine_inputs;
-    // TODO: Check if CR parameters are some kind of standard
+  // Cycle 5: Collect register-bound routine parameters into Subroutine::_gpr_param and Subroutine::_fpr_param, and
+  // clobbered registers into Subroutine::_gpr_clobber, _fpr_clobber and _cr_clobber
+  // TODO: Check if CR parameters are some kind of standard
+  RegFileSet params;
+  RegFileSet clobbers;
+  graph.foreach_real([&shape, &state, &params, &clobbers](BasicBlockVertex& bbv) {
+    find_routine_params(shape, state, bbv._idx);
+    params += state.block(bbv)._routine_inputs;
+    clobbers += find_routine_clobbers(bbv.data(), state.block(bbv));
+  });
+  routine._gpr_param += params.get<GprSet>();
+  routine._fpr_param += params.get<FprSet>();
+  routine._gpr_clobber += clobbers.get<GprSet>();
+  routine._fpr_clobber += clobbers.get<FprSet>();
+  routine._cr_clobber += clobbers.get<CrSet>();
+
+  // Liveness only ever comes from reads and writes, so a class none of the instructions touch has nothing to keep
+  RegFileSet touched;
+  for (InstLiveness const& il : state._insts) {
+    touched += il._def + il._use;
+  }
+  const bool keep_fpr = !touched.get<FprSet>().empty();
+  const bool keep_cr = !touched.get<CrSet>().empty();
+  run_stats._skipped_fpr += keep_fpr ? 0 : 1;
+  run_stats._skipped_cr += keep_cr ? 0 : 1;
+
+  graph.foreach_real([&state, keep_fpr, keep_cr](BasicBlockVertex& bbv) {
+    BlockLiveness const& bl = state.block(bbv);
+    std::span<InstLiveness const> insts = state.insts(bl);
+    bbv.data()._gpr_lifetimes = split_class<GprSet>(bbv.data(), bl, insts);
+    bbv.data()._fpr_lifetimes = keep_fpr ? split_class<FprSet>(bbv.data(), bl, insts) : nullptr;
+    bbv.data()._cr_lifetimes = keep_cr ? split_class<CrSet>(bbv.data(), bl, insts) : nullptr;
   });
+  routine._products = routine._products | AnalysisProduct::kLiveness;
 }
 }  // namespace decomp::ppc
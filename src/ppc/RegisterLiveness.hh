@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <optional>
 #include <variant>
 #include <vector>
@@ -70,14 +71,29 @@ constexpr struct {
   std::tuple<GprSet, FprSet, CrSet> _killed_by_caller = {kKilledByCallGpr, kKilledByCallFpr, kKilledByCallCr};
 } kRegSets;
 
+// Registers that go live or dead across one instruction
+template <typename RegType>
+struct LivenessChange {
+  uint32_t _index;
+  RegSet<RegType> _flip;
+};
+
+// Registers a call reads and defines, which come from the callee's summary rather than the instruction itself
+template <typename RegType>
+struct CallRegs {
+  uint32_t _index;
+  RegSet<RegType> _def;
+  RegSet<RegType> _use;
+};
+
 // Generic liveness tracker
 template <typename RegType>
 struct RegisterLiveness {
-  // Per-instruction register liveness
-  std::vector<RegSet<RegType>> _def;
-  std::vector<RegSet<RegType>> _use;
-  std::vector<RegSet<RegType>> _live_in;
-  std::vector<RegSet<RegType>> _live_out;
+  // Per-instruction register liveness, stored as the set live into the block's first instruction and the changes
+  // after it (each instruction's live_out is the next one's live_in). Use LivenessCursor to read it back
+  RegSet<RegType> _block_live_in;
+  std::vector<LivenessChange<RegType>> _changes;
+  std::vector<CallRegs<RegType>> _call_regs;
 
   // Liveness summary for whole block
   RegSet<RegType> _input;
@@ -94,5 +110,31 @@ using GprLiveness = RegisterLiveness<GPR>;
 using FprLiveness = RegisterLiveness<FPR>;
 using CrLiveness = RegisterLiveness<CRField>;
 
-void run_liveness_analysis(Subroutine& routine, BinaryContext const& ctx);
+// Resolves a direct call target to a subroutine with final params and clobbers, calls that resolve to nullptr (or all
+// calls, without a lookup) are assumed to follow the ABI contract
+using CalleeLookup = std::function<Subroutine const*(uint32_t)>;
+
+// How the cross block cycles reach their fixpoint, both give the same liveness
+enum class LivenessSolver : uint8_t {
+  // Revisits only the neighbors of blocks whose sets changed
+  kWorklist,
+  // Sweeps over every block until a sweep changes nothing
+  kFullSweep,
+};
+
+// Block evaluations made by the cross block cycles, and subroutines that got no FPR or CR liveness because nothing in
+// them reads or writes that class
+struct LivenessStats {
+  size_t _propagate_visits = 0;
+  size_t _backpropagate_visits = 0;
+  size_t _skipped_fpr = 0;
+  size_t _skipped_cr = 0;
+};
+
+constexpr PassRequirements kLivenessPass = {"liveness", AnalysisProduct::kGraph, AnalysisProduct::kLiveness};
+void run_liveness_analysis(Subroutine& routine,
+  BinaryContext const& ctx,
+  CalleeLookup const& callees = {},
+  LivenessSolver solver = LivenessSolver::kWorklist,
+  LivenessStats* stats = nullptr);
 }  // namespace decomp::ppc
@@ -3,12 +3,37 @@
 #include <cstdint>
 #include <memory>
 
-#include "ppc/RegSet.hh"
+#include "ppc/DataSource.hh"
+#include "utl/FlagsEnum.hh"
 
 namespace decomp::ppc {
 class SubroutineGraph;
 class SubroutineStack;
 
+// Results the analysis passes leave on a Subroutine. The IR is kept next to the Subroutine rather than in it, so kIr
+// never shows up in _products
+enum class AnalysisProduct : uint8_t {
+  kNone = 0,
+  kAll = 0b11111,
+
+  kGraph = 1u << 0,
+  kLiveness = 1u << 1,
+  kStack = 1u << 2,
+  kPerilogue = 1u << 3,
+  kIr = 1u << 4,
+
+  // Everything up to IR translation, which doesn't cover the whole instruction set yet
+  kMachineLevel = kGraph | kLiveness | kStack | kPerilogue,
+};
+GEN_FLAG_OPERATORS(AnalysisProduct)
+
+// What an analysis pass needs to have run before it and what it leaves behind
+struct PassRequirements {
+  char const* _name;
+  AnalysisProduct _consumes;
+  AnalysisProduct _produces;
+};
+
 // Encapsulation of all data pertaining to a subroutine
 struct Subroutine {
   uint32_t _start_va;
@@ -16,5 +41,11 @@ struct Subroutine {
   std::unique_ptr<SubroutineStack> _stack;
   GprSet _gpr_param;
   FprSet _fpr_param;
+  // Caller saved registers that may hold a different value once this subroutine returns
+  GprSet _gpr_clobber;
+  FprSet _fpr_clobber;
+  CrSet _cr_clobber;
+  // Passes that have already run on this subroutine
+  AnalysisProduct _products = AnalysisProduct::kNone;
 };
 }  // namespace decomp::ppc
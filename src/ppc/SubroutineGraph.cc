@@ -1,6 +1,8 @@
 #include "ppc/SubroutineGraph.hh"
 
 #include <algorithm>
+#include <iterator>
+#include <map>
 #include <stack>
 #include <tuple>
 
@@ -11,23 +13,34 @@ namespace {
 ////////////////////////////////
 // Graph construction helpers //
 ////////////////////////////////
-BasicBlockVertex* at_block_head(SubroutineGraph* graph, uint32_t address) {
-  return graph->find_real([address](BasicBlockVertex& vert) { return address == vert.data()._block_start; });
+// Blocks discovered so far keyed by start address. Blocks never overlap, so the only block that can contain an address
+// is the last one starting at or before it. Vertices move as the graph grows, so blocks are kept by index
+using BlockIndex = std::map<uint32_t, int>;
+constexpr int kNoBlock = SubroutineGraph::kInvalidVertexId;
+
+int at_block_head(BlockIndex const& index, uint32_t address) {
+  auto it = index.find(address);
+  return it == index.end() ? kNoBlock : it->second;
 }
 
-BasicBlockVertex* contained_in_block(SubroutineGraph* graph, uint32_t address) {
-  return graph->find_real([address](BasicBlockVertex& vert) {
-    return address > vert.data()._block_start && address < vert.data()._block_end;
-  });
+int contained_in_block(BlockIndex const& index, SubroutineGraph const& graph, uint32_t address) {
+  auto it = index.upper_bound(address);
+  if (it == index.begin()) {
+    return kNoBlock;
+  }
+
+  BasicBlock const& candidate = graph.vertex(std::prev(it)->second)->data();
+  return address > candidate._block_start && address < candidate._block_end ? std::prev(it)->second : kNoBlock;
 }
 
-BasicBlockVertex* split_blocks(BasicBlockVertex* original_block, uint32_t address, SubroutineGraph& graph) {
+int split_blocks(int original_block, uint32_t address, SubroutineGraph& graph) {
   // Original block is on top
-  int new_block = graph.insert_after(
-    original_block, BasicBlock(address, original_block->data()._block_end), BlockTransfer::kFallthrough);
-  original_block->data()._block_end = address;
+  int new_block = graph.insert_after(graph.vertex(original_block),
+    BasicBlock(address, graph.vertex(original_block)->data()._block_end),
+    BlockTransfer::kFallthrough);
+  graph.vertex(original_block)->data()._block_end = address;
 
-  return graph.vertex(new_block);
+  return new_block;
 }
 }  // namespace
 
@@ -35,51 +48,60 @@ void run_graph_analysis(Subroutine& routine, BinaryContext const& ctx, uint32_t
   RandomAccessData const& ram = *ctx._ram;
 
   std::unique_ptr<SubroutineGraph> graph = std::make_unique<SubroutineGraph>();
-  BasicBlockVertex* start = graph->vertex(graph->emplace_vertex(subroutine_start, subroutine_start + 4));
+  const int start = graph->emplace_vertex(subroutine_start, subroutine_start + 4);
 
-  graph->emplace_link(graph->root(), start, BlockTransfer::kFallthrough);
+  graph->emplace_link(graph->root()->_idx, start, BlockTransfer::kFallthrough);
 
-  std::vector<BasicBlockVertex*> known_blocks;
-  std::vector<BasicBlockVertex*> block_stack;
+  std::vector<int> block_stack;
+  BlockIndex block_index;
+  block_index.emplace(subroutine_start, start);
 
-  auto handle_branch =
-    [&block_stack, &graph](
-      BasicBlockVertex* cur_block, uint32_t target_addr, uint32_t inst_addr, BlockTransfer branch_type) {
-      if (BasicBlockVertex* known_block = at_block_head(graph.get(), target_addr); known_block != nullptr) {
-        // If we're branching into the start of another block, just link us.
-        graph->emplace_link(cur_block, known_block, branch_type);
-        return;
-      }
-
-      BasicBlockVertex* next_block = nullptr;
-      if (BasicBlockVertex* known_block = contained_in_block(graph.get(), target_addr); known_block != nullptr) {
-        next_block = split_blocks(known_block, target_addr, *graph);
-      } else {
-        next_block = graph->vertex(graph->emplace_vertex(target_addr, target_addr + 4));
+  // Returns the block holding the branch afterwards, which moves to the lower half if the branch splits its own block
+  auto handle_branch = [&block_stack, &block_index, &graph](
+                         int cur_block, uint32_t target_addr, uint32_t inst_addr, BlockTransfer branch_type) -> int {
+    if (int known_block = at_block_head(block_index, target_addr); known_block != kNoBlock) {
+      // If we're branching into the start of another block, just link us.
+      graph->emplace_link(cur_block, known_block, branch_type);
+      return cur_block;
+    }
 
-        block_stack.push_back(next_block);
+    int next_block = kNoBlock;
+    if (int known_block = contained_in_block(block_index, *graph, target_addr); known_block != kNoBlock) {
+      next_block = split_blocks(known_block, target_addr, *graph);
+      if (known_block == cur_block) {
+        cur_block = next_block;
       }
+    } else {
+      next_block = graph->emplace_vertex(target_addr, target_addr + 4);
 
-      graph->emplace_link(cur_block, next_block, branch_type);
-      cur_block->data()._block_end = inst_addr + 0x4;
-    };
+      block_stack.push_back(next_block);
+    }
+    block_index.emplace(target_addr, next_block);
+
+    graph->emplace_link(cur_block, next_block, branch_type);
+    graph->vertex(cur_block)->data()._block_end = inst_addr + 0x4;
+    return cur_block;
+  };
 
   block_stack.push_back(start);
 
   // Build initial graph
   while (!block_stack.empty()) {
-    BasicBlockVertex* this_block = block_stack.back();
+    int this_block = block_stack.back();
     block_stack.pop_back();
 
-    for (uint32_t inst_address = this_block->data()._block_start;; inst_address += 0x4) {
+    // New blocks only show up at the branch that ends this scan, so the next known block can be looked up once
+    const uint32_t block_start = graph->vertex(this_block)->data()._block_start;
+    auto next_known = block_index.upper_bound(block_start);
+
+    for (uint32_t inst_address = block_start;; inst_address += 0x4) {
       // Extend the current block
-      this_block->data()._block_end = inst_address + 0x4;
+      graph->vertex(this_block)->data()._block_end = inst_address + 0x4;
 
       // Check if we're falling through to an already known block
-      if (BasicBlockVertex* fallthrough_block = at_block_head(graph.get(), inst_address);
-          fallthrough_block != nullptr && fallthrough_block != this_block) {
-        graph->emplace_link(this_block, fallthrough_block, BlockTransfer::kFallthrough);
-        this_block->data()._block_end = inst_address;
+      if (next_known != block_index.end() && next_known->first == inst_address) {
+        graph->emplace_link(this_block, next_known->second, BlockTransfer::kFallthrough);
+        graph->vertex(this_block)->data()._block_end = inst_address;
         break;
       }
 
@@ -104,7 +126,7 @@ void run_graph_analysis(Subroutine& routine, BinaryContext const& ctx, uint32_t
           const uint32_t target_off = static_cast<uint32_t>(std::get<RelBranch>(inst._reads[0])._rel_32);
           const uint32_t target_addr = absolute ? target_off : inst_address + target_off;
 
-          handle_branch(this_block, target_addr, inst_address, BlockTransfer::kUnconditional);
+          this_block = handle_branch(this_block, target_addr, inst_address, BlockTransfer::kUnconditional);
 
           break;
         }
@@ -115,8 +137,8 @@ void run_graph_analysis(Subroutine& routine, BinaryContext const& ctx, uint32_t
           const uint32_t target_addr = absolute ? target_off : inst_address + target_off;
           const uint32_t next_addr = inst_address + 0x4;
 
-          handle_branch(this_block, target_addr, inst_address, BlockTransfer::kConditionTrue);
-          handle_branch(this_block, next_addr, inst_address, BlockTransfer::kConditionFalse);
+          this_block = handle_branch(this_block, target_addr, inst_address, BlockTransfer::kConditionTrue);
+          this_block = handle_branch(this_block, next_addr, inst_address, BlockTransfer::kConditionFalse);
 
           break;
         }
@@ -132,20 +154,27 @@ void run_graph_analysis(Subroutine& routine, BinaryContext const& ctx, uint32_t
     }
   }
 
-  // Fill in instructions and interval tree
+  // Fill in instructions
   graph->foreach_real([&graph, &ram](BasicBlockVertex& bbv) {
-    for (uint32_t addr = bbv.data()._block_start; addr < bbv.data()._block_end; addr += 4) {
-      bbv.data()._instructions.emplace_back(ram.read_instruction(addr));
-    }
-
-    graph->_nodes_by_range.try_emplace(bbv.data()._block_start, bbv.data()._block_end, bbv._idx);
+    bbv.data()._instructions =
+      ram.read_packed_instructions(bbv.data()._block_start, (bbv.data()._block_end - bbv.data()._block_start) / 4);
 
     if (bbv._out.empty()) {
       graph->emplace_link(&bbv, graph->terminal(), BlockTransfer::kUnconditional);
     }
   });
 
+  // The block index is already in address order, so the interval tree can be built in one go
+  std::vector<dinterval_tree<int, uint32_t>::sorted_entry> ranges;
+  ranges.reserve(block_index.size());
+  for (auto [block_start, idx] : block_index) {
+    ranges.push_back({block_start, graph->vertex(idx)->data()._block_end, idx});
+  }
+  graph->_nodes_by_range = dinterval_tree<int, uint32_t>::from_sorted(std::move(ranges));
+  graph->_shape = FlowGraphSnapshot(*graph);
+
   routine._graph = std::move(graph);
+  routine._products = routine._products | AnalysisProduct::kGraph;
 }
 
 }  // namespace decomp::ppc
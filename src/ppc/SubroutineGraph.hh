@@ -10,6 +10,7 @@
 #include "ppc/RegisterLiveness.hh"
 #include "producers/RandomAccessData.hh"
 #include "utl/FlowGraph.hh"
+#include "utl/FlowGraphSnapshot.hh"
 #include "utl/IntervalTree.hh"
 
 namespace decomp::ppc {
@@ -21,8 +22,9 @@ struct BasicBlock {
   // Exclusive end address
   uint32_t _block_end;
 
-  std::vector<MetaInst> _instructions;
+  std::vector<PackedInst> _instructions;
 
+  // FPR and CR liveness stay null when nothing in the subroutine reads or writes that register class
   std::unique_ptr<GprLiveness> _gpr_lifetimes;
   std::unique_ptr<FprLiveness> _fpr_lifetimes;
   std::unique_ptr<CrLiveness> _cr_lifetimes;
@@ -34,6 +36,8 @@ class SubroutineGraph : public FlowGraph<BasicBlock> {
 public:
   dinterval_tree<int, uint32_t> _nodes_by_range;
   std::vector<uint32_t> _direct_calls;
+  // Taken once run_graph_analysis is done, the shape doesn't change after that
+  FlowGraphSnapshot _shape;
 
   BasicBlock const* block_by_vaddr(uint32_t vaddr) const {
     auto result = _nodes_by_range.query(vaddr, vaddr + 4);
@@ -66,5 +70,6 @@ constexpr RegisterLiveness<typename SetType::RegType>* get_liveness(BasicBlock*
   }
 }
 
+constexpr PassRequirements kGraphPass = {"graph", AnalysisProduct::kNone, AnalysisProduct::kGraph};
 void run_graph_analysis(Subroutine& routine, BinaryContext const& ctx, uint32_t subroutine_start);
 }  // namespace decomp::ppc
@@ -40,7 +40,12 @@ bool SubroutineStack::in_param_region(int16_t offset) const { return offset > _s
 
 void SubroutineStack::analyze_block(BasicBlock const& block) {
   enum SPReferenceType { Write, Read, Reference, SpModify };
-  for (MetaInst const& inst : block._instructions) {
+  for (PackedInst const& packed : block._instructions) {
+    if (!packed.regs()._touches_r1) {
+      continue;
+    }
+
+    MetaInst const& inst = packed.expand();
     // There can't be more than 3 references to a register in a single instruction
     reserved_vector<SPReferenceType, 3> all_sp_refs;
 
@@ -170,8 +175,19 @@ StackVariable* SubroutineStack::variable_for_offset(int16_t offset) {
   return const_cast<StackVariable*>(const_cast<SubroutineStack const*>(this)->variable_for_offset(offset));
 }
 
+bool references_stack(Subroutine const& routine) {
+  bool found = false;
+  routine._graph->foreach_real([&found](BasicBlockVertex const& bbv) {
+    found = found || std::any_of(bbv.data()._instructions.begin(),
+                       bbv.data()._instructions.end(),
+                       [](PackedInst const& inst) { return inst.regs()._touches_r1; });
+  });
+  return found;
+}
+
 void run_stack_analysis(Subroutine& routine) {
   routine._stack = std::make_unique<SubroutineStack>();
   routine._stack->analyze(*routine._graph);
+  routine._products = routine._products | AnalysisProduct::kStack;
 }
 }  // namespace decomp::ppc
@@ -4,11 +4,11 @@
 #include <vector>
 
 #include "ppc/DataSource.hh"
+#include "ppc/Subroutine.hh"
 
 namespace decomp::ppc {
 struct BasicBlock;
 struct MetaInst;
-struct Subroutine;
 class SubroutineGraph;
 
 enum class TypeSet : uint8_t {
@@ -77,5 +77,8 @@ public:
   std::vector<StackVariable> const& param_list() const { return _stack_params; }
 };
 
+constexpr PassRequirements kStackPass = {"stack", AnalysisProduct::kGraph, AnalysisProduct::kStack};
+// Stack analysis only looks at instructions touching r1, without any it finds an empty stack
+bool references_stack(Subroutine const& routine);
 void run_stack_analysis(Subroutine& routine);
 }  // namespace decomp::ppc
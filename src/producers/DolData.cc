@@ -5,23 +5,23 @@
 
 namespace decomp {
 namespace {
-template <typename T>
-struct byteswap_prim {
-  byteswap_prim(T& val) : _val(val) {}
-  T& _val;
-};
-
-template <typename T>
-std::istream& operator>>(std::istream& in, byteswap_prim<T> prim) {
-  char* internal = reinterpret_cast<char*>(&prim._val);
-  in.read(internal, sizeof(T));
-
-  for (size_t i = 0; i < (sizeof(T) / 2); i++) {
-    std::swap(internal[i], internal[sizeof(T) - i - 1]);
-  }
-
-  return in;
+constexpr uint32_t read_be32(uint8_t const* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
 }
+
+// Header layout in words
+constexpr size_t kTextOffsIdx = 0;
+constexpr size_t kDataOffsIdx = kTextOffsIdx + DolData::kNumTextSections;
+constexpr size_t kTextVasIdx = kDataOffsIdx + DolData::kNumDataSections;
+constexpr size_t kDataVasIdx = kTextVasIdx + DolData::kNumTextSections;
+constexpr size_t kTextSizesIdx = kDataVasIdx + DolData::kNumDataSections;
+constexpr size_t kDataSizesIdx = kTextSizesIdx + DolData::kNumTextSections;
+constexpr size_t kBssVaIdx = kDataSizesIdx + DolData::kNumDataSections;
+constexpr size_t kBssSizeIdx = kBssVaIdx + 1;
+constexpr size_t kEntrypointIdx = kBssSizeIdx + 1;
+static_assert(kEntrypointIdx * 4 == 0xe0);
+
 constexpr uint32_t kGcMinVa = 0x80000000;
 constexpr uint32_t kGcMaxVa = 0x81800000;
 constexpr uint32_t kRamSize = 0x1800000;
@@ -31,7 +31,7 @@ bool DolData::sanity_check_header(size_t file_size) {
   size_t net_section_sizes = 0;
 
   for (DolSection const& tsect : _text_sections) {
-    if (static_cast<size_t>(tsect._file_off) >= file_size) {
+    if (static_cast<size_t>(tsect._file_off) + static_cast<size_t>(tsect._size) > file_size) {
       return false;
     }
     if (tsect._vaddr < kGcMinVa || tsect._vaddr >= kGcMaxVa) {
@@ -41,7 +41,7 @@ bool DolData::sanity_check_header(size_t file_size) {
   }
 
   for (DolSection const& dsect : _data_sections) {
-    if (static_cast<size_t>(dsect._file_off) >= file_size) {
+    if (static_cast<size_t>(dsect._file_off) + static_cast<size_t>(dsect._size) > file_size) {
       return false;
     }
     if (dsect._vaddr < kGcMinVa || dsect._vaddr >= kGcMaxVa) {
@@ -58,49 +58,44 @@ bool DolData::sanity_check_header(size_t file_size) {
   return net_section_sizes < kRamSize;
 }
 
-bool DolData::load_from(std::istream& source) {
-  std::array<uint32_t, kNumTextSections> text_offs, text_vas, text_sizes;
-  std::array<uint32_t, kNumDataSections> data_offs, data_vas, data_sizes;
-  uint32_t bss_va, bss_size;
-  for (size_t i = 0; i < kNumTextSections; i++) {
-    source >> byteswap_prim(text_offs[i]);
-  }
-  for (size_t i = 0; i < kNumDataSections; i++) {
-    source >> byteswap_prim(data_offs[i]);
-  }
-  for (size_t i = 0; i < kNumTextSections; i++) {
-    source >> byteswap_prim(text_vas[i]);
-  }
-  for (size_t i = 0; i < kNumDataSections; i++) {
-    source >> byteswap_prim(data_vas[i]);
-  }
-  for (size_t i = 0; i < kNumTextSections; i++) {
-    source >> byteswap_prim(text_sizes[i]);
-  }
-  for (size_t i = 0; i < kNumDataSections; i++) {
-    source >> byteswap_prim(data_sizes[i]);
-  }
-  source >> byteswap_prim(bss_va);
-  source >> byteswap_prim(bss_size);
+bool DolData::parse_header(uint8_t const* header, size_t file_size) {
+  const auto field = [header](size_t idx) { return read_be32(header + idx * 4); };
 
   for (size_t i = 0; i < kNumTextSections; i++) {
-    if (text_offs[i] == 0 && text_vas[i] == 0 && text_sizes[i] == 0) {
+    const uint32_t off = field(kTextOffsIdx + i);
+    const uint32_t va = field(kTextVasIdx + i);
+    const uint32_t size = field(kTextSizesIdx + i);
+    if (off == 0 && va == 0 && size == 0) {
       continue;
     }
-    _text_sections.emplace_back(text_offs[i], text_vas[i], text_sizes[i]);
+    _text_sections.emplace_back(off, va, size);
   }
   for (size_t i = 0; i < kNumDataSections; i++) {
-    if (data_offs[i] == 0 && data_vas[i] == 0 && data_sizes[i] == 0) {
+    const uint32_t off = field(kDataOffsIdx + i);
+    const uint32_t va = field(kDataVasIdx + i);
+    const uint32_t size = field(kDataSizesIdx + i);
+    if (off == 0 && va == 0 && size == 0) {
       continue;
     }
-    _data_sections.emplace_back(data_offs[i], data_vas[i], data_sizes[i]);
+    _data_sections.emplace_back(off, va, size);
+  }
+  _bss_section._vaddr = field(kBssVaIdx);
+  _bss_section._size = field(kBssSizeIdx);
+  _entrypoint = field(kEntrypointIdx);
+
+  return sanity_check_header(file_size);
+}
+
+bool DolData::load_from(std::istream& source) {
+  std::array<uint8_t, kHeaderSize> header;
+  source.read(reinterpret_cast<char*>(header.data()), header.size());
+  if (!source) {
+    return false;
   }
-  _bss_section._vaddr = bss_va;
-  _bss_section._size = bss_size;
 
   source.seekg(0, std::ios::end);
   size_t file_size = source.tellg();
-  if (!sanity_check_header(file_size)) {
+  if (!parse_header(header.data(), file_size)) {
     return false;
   }
 
@@ -120,8 +115,24 @@ bool DolData::load_from(std::istream& source) {
     add_section(dsect._vaddr, std::move(raw_readout));
   }
 
-  source.seekg(0xe0, std::ios::beg);
-  source >> byteswap_prim(_entrypoint);
+  return true;
+}
+
+bool DolData::load_from(MappedFile&& image) {
+  if (image.size() < kHeaderSize || !parse_header(image.data(), image.size())) {
+    return false;
+  }
+
+  _image = std::make_unique<MappedFile>(std::move(image));
+
+  // Sections reference the mapping directly, nothing is read until an analysis touches it
+  for (DolSection const& tsect : _text_sections) {
+    add_mapped_section(tsect._vaddr, _image->view(tsect._file_off, tsect._size));
+  }
+
+  for (DolSection const& dsect : _data_sections) {
+    add_mapped_section(dsect._vaddr, _image->view(dsect._file_off, dsect._size));
+  }
 
   return true;
 }
@@ -3,6 +3,7 @@
 #include <array>
 
 #include "producers/SectionedData.hh"
+#include "utl/MappedFile.hh"
 #include "utl/ReservedVector.hh"
 
 namespace decomp {
@@ -20,12 +21,16 @@ private:
   uint32_t _entrypoint;
 
   bool sanity_check_header(size_t file_size);
+  bool parse_header(uint8_t const* header, size_t file_size);
 
 public:
   static inline constexpr size_t kNumTextSections = 7;
   static inline constexpr size_t kNumDataSections = 11;
+  static inline constexpr size_t kHeaderSize = 0x100;
 
   bool load_from(std::istream& source);
+  // Sections point straight into the mapped image, which is owned by this object from then on
+  bool load_from(MappedFile&& image);
 
   reserved_vector<DolSection, 7> const& text_section_headers() const { return _text_sections; }
   reserved_vector<DolSection, 11> const& data_section_headers() const { return _data_sections; }
@@ -15,13 +15,18 @@ T byteswap(T val) {
   }
   return out;
 }
-}  // namespace
 
-bool ElfData::load_from(std::istream& source) {
+// Walks the PROGBITS sections of a big endian PPC ELF, shared by the stream and mapped loaders
+// read_at(off, dst, len) copies raw file bytes, on_section(shdr) is called per loadable section. Either returns false
+// when the file doesn't hold the bytes asked for
+template <typename ReadAt, typename OnSection>
+bool walk_elf(ReadAt&& read_at, OnSection&& on_section, uint32_t& entrypoint) {
   Elf32_Ehdr hdr;
   memset(&hdr, 0, sizeof(Elf32_Ehdr));
 
-  source.read(reinterpret_cast<char*>(&hdr), sizeof(Elf32_Ehdr));
+  if (!read_at(0, &hdr, sizeof(Elf32_Ehdr))) {
+    return false;
+  }
   if (hdr.e_ident[EI_MAG0] != ELFMAG0 || hdr.e_ident[EI_MAG1] != ELFMAG1 || hdr.e_ident[EI_MAG2] != ELFMAG2 ||
       hdr.e_ident[EI_MAG3] != ELFMAG3) {
     return false;
@@ -39,13 +44,13 @@ bool ElfData::load_from(std::istream& source) {
     return false;
   }
 
-  source.seekg(hdr.e_shoff);
-
   for (Elf32_Half i = 0; i < hdr.e_shnum; i++) {
     Elf32_Shdr shdr;
     memset(&shdr, 0, sizeof(Elf32_Shdr));
 
-    source.read(reinterpret_cast<char*>(&shdr), sizeof(Elf32_Shdr));
+    if (!read_at(hdr.e_shoff + i * sizeof(Elf32_Shdr), &shdr, sizeof(Elf32_Shdr))) {
+      return false;
+    }
 
     shdr.sh_type = byteswap(shdr.sh_type);
     shdr.sh_addr = byteswap(shdr.sh_addr);
@@ -53,25 +58,68 @@ bool ElfData::load_from(std::istream& source) {
     shdr.sh_offset = byteswap(shdr.sh_offset);
     shdr.sh_flags = byteswap(shdr.sh_flags);
 
-    if (shdr.sh_type == SHT_PROGBITS && shdr.sh_addr != 0) {
-      auto save_pos = source.tellg();
-      std::vector<uint8_t> sect_data;
-      sect_data.resize(shdr.sh_size);
-      source.seekg(shdr.sh_offset);
-      source.read(reinterpret_cast<char*>(sect_data.data()), sect_data.size());
-      add_section(shdr.sh_addr, std::move(sect_data));
-
-      if (shdr.sh_flags & SHF_EXECINSTR) {
-        _text_sections.emplace_back(shdr.sh_offset, shdr.sh_addr, shdr.sh_size);
-      } else if (shdr.sh_flags & SHF_ALLOC) {
-        _data_sections.emplace_back(shdr.sh_offset, shdr.sh_addr, shdr.sh_size);
-      }
-      source.seekg(save_pos);
+    if (shdr.sh_type == SHT_PROGBITS && shdr.sh_addr != 0 && !on_section(shdr)) {
+      return false;
     }
   }
 
-  _entrypoint = hdr.e_entry;
+  entrypoint = hdr.e_entry;
 
   return true;
 }
+}  // namespace
+
+void ElfData::record_section(uint32_t flags, ElfSection const& sect) {
+  if (flags & SHF_EXECINSTR) {
+    _text_sections.push_back(sect);
+  } else if (flags & SHF_ALLOC) {
+    _data_sections.push_back(sect);
+  }
+}
+
+bool ElfData::load_from(std::istream& source) {
+  const auto read_at = [&source](size_t off, void* dst, size_t len) {
+    source.seekg(off);
+    source.read(reinterpret_cast<char*>(dst), len);
+    return static_cast<bool>(source);
+  };
+  const auto on_section = [this, &source](Elf32_Shdr const& shdr) {
+    std::vector<uint8_t> sect_data;
+    sect_data.resize(shdr.sh_size);
+    source.seekg(shdr.sh_offset);
+    source.read(reinterpret_cast<char*>(sect_data.data()), sect_data.size());
+    if (!source) {
+      return false;
+    }
+    add_section(shdr.sh_addr, std::move(sect_data));
+    record_section(shdr.sh_flags, ElfSection(shdr.sh_offset, shdr.sh_addr, shdr.sh_size));
+    return true;
+  };
+
+  return walk_elf(read_at, on_section, _entrypoint);
+}
+
+bool ElfData::load_from(MappedFile&& image) {
+  _image = std::make_unique<MappedFile>(std::move(image));
+
+  const auto read_at = [this](size_t off, void* dst, size_t len) {
+    std::span<uint8_t const> src = _image->view(off, len);
+    if (src.size() != len) {
+      return false;
+    }
+    memcpy(dst, src.data(), len);
+    return true;
+  };
+  const auto on_section = [this](Elf32_Shdr const& shdr) {
+    std::span<uint8_t const> sect_data = _image->view(shdr.sh_offset, shdr.sh_size);
+    if (sect_data.size() != shdr.sh_size) {
+      return false;
+    }
+    add_mapped_section(shdr.sh_addr, sect_data);
+    record_section(shdr.sh_flags, ElfSection(shdr.sh_offset, shdr.sh_addr, shdr.sh_size));
+    return true;
+  };
+
+  return walk_elf(read_at, on_section, _entrypoint);
+}
 }  // namespace decomp
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "producers/SectionedData.hh"
+#include "utl/MappedFile.hh"
 
 namespace decomp {
 struct ElfSection {
@@ -15,8 +16,12 @@ private:
   std::vector<ElfSection> _data_sections;
   uint32_t _entrypoint;
 
+  void record_section(uint32_t flags, ElfSection const& sect);
+
 public:
   bool load_from(std::istream& source);
+  // Sections point straight into the mapped image, which is owned by this object from then on
+  bool load_from(MappedFile&& image);
 
   std::vector<ElfSection> const& text_section_headers() const { return _text_sections; }
   std::vector<ElfSection> const& data_section_headers() const { return _data_sections; }
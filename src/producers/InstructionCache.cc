@@ -0,0 +1,61 @@
+#include "producers/InstructionCache.hh"
+
+namespace decomp {
+InstructionCache::InstructionCache(uint32_t base, std::span<uint8_t const> raw)
+    : _base(base),
+      _raw(raw),
+      _num_insts(raw.size() / 4),
+      _chunks(std::make_unique<std::atomic<Chunk*>[]>((_num_insts + kChunkSize - 1) >> kChunkBits)) {}
+
+InstructionCache::~InstructionCache() {
+  const size_t num_chunks = (_num_insts + kChunkSize - 1) >> kChunkBits;
+  for (size_t i = 0; i < num_chunks; i++) {
+    delete _chunks[i].load(std::memory_order_relaxed);
+  }
+}
+
+InstructionCache::Chunk& InstructionCache::chunk_for(size_t chunk_idx) const {
+  std::atomic<Chunk*>& slot = _chunks[chunk_idx];
+  Chunk* chunk = slot.load(std::memory_order_acquire);
+  if (chunk != nullptr) {
+    return *chunk;
+  }
+
+  // Racing allocators both build a chunk, the loser throws theirs away
+  Chunk* fresh = new Chunk;
+  if (slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+    return *fresh;
+  }
+  delete fresh;
+  return *chunk;
+}
+
+ppc::MetaInst const& InstructionCache::get(uint32_t vaddr) const {
+  const size_t idx = (vaddr - _base) / 4;
+  Chunk& chunk = chunk_for(idx >> kChunkBits);
+  const size_t slot_idx = idx & (kChunkSize - 1);
+  std::atomic<uint8_t>& state = chunk._state[slot_idx];
+  ppc::MetaInst& inst = chunk._insts[slot_idx];
+
+  uint8_t cur = state.load(std::memory_order_acquire);
+  if (cur == kReady) {
+    return inst;
+  }
+
+  if (cur == kEmpty && state.compare_exchange_strong(cur, kDecoding, std::memory_order_acquire)) {
+    uint8_t const* raw = _raw.data() + idx * 4;
+    const uint32_t word = (static_cast<uint32_t>(raw[0]) << 24) | (static_cast<uint32_t>(raw[1]) << 16) |
+                          (static_cast<uint32_t>(raw[2]) << 8) | static_cast<uint32_t>(raw[3]);
+    ppc::disasm_single(vaddr, word, inst);
+    state.store(kReady, std::memory_order_release);
+    state.notify_all();
+    return inst;
+  }
+
+  // Another thread is decoding this slot
+  while ((cur = state.load(std::memory_order_acquire)) != kReady) {
+    state.wait(cur, std::memory_order_acquire);
+  }
+  return inst;
+}
+}  // namespace decomp
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+#include "ppc/PpcDisasm.hh"
+
+namespace decomp {
+// Lazily decoded instructions for one section, indexed by (vaddr - base) / 4
+// Storage is allocated in chunks on first touch, and each word is decoded at most once even when several threads
+// ask for it at the same time
+class InstructionCache {
+private:
+  static constexpr size_t kChunkBits = 10;
+  static constexpr size_t kChunkSize = 1 << kChunkBits;
+
+  enum SlotState : uint8_t {
+    kEmpty,
+    kDecoding,
+    kReady,
+  };
+
+  struct Chunk {
+    std::array<ppc::MetaInst, kChunkSize> _insts;
+    std::array<std::atomic<uint8_t>, kChunkSize> _state{};
+  };
+
+  uint32_t _base;
+  std::span<uint8_t const> _raw;
+  size_t _num_insts;
+  std::unique_ptr<std::atomic<Chunk*>[]> _chunks;
+
+  Chunk& chunk_for(size_t chunk_idx) const;
+
+public:
+  InstructionCache(uint32_t base, std::span<uint8_t const> raw);
+  InstructionCache(InstructionCache const&) = delete;
+  InstructionCache& operator=(InstructionCache const&) = delete;
+  ~InstructionCache();
+
+  constexpr bool contains(uint32_t vaddr) const {
+    return vaddr >= _base && (vaddr - _base) / 4 < _num_insts && (vaddr & 3) == 0;
+  }
+
+  // vaddr must be contained in this section
+  ppc::MetaInst const& get(uint32_t vaddr) const;
+};
+}  // namespace decomp
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cstdint>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
 
 #include "ppc/PpcDisasm.hh"
 
@@ -18,10 +22,100 @@ public:
   virtual double read_double(uint32_t vaddr) const = 0;
 
   ppc::MetaInst read_instruction(uint32_t vaddr) const {
+    if (ppc::MetaInst const* cached = cached_instruction(vaddr); cached != nullptr) {
+      return *cached;
+    }
+
     ppc::MetaInst ret;
     disasm_single(vaddr, read_word(vaddr), ret);
     return ret;
   }
+
+  // Bulk reads, these translate the range once rather than once per element
+
+  // Raw bytes backing [vaddr, vaddr + len), empty if the range isn't contiguous in memory
+  std::span<uint8_t const> read_span(uint32_t vaddr, uint32_t len) const { return contiguous_range(vaddr, len); }
+
+  // Reads out.size() big endian words starting at vaddr, unmapped words read as 0 like read_word
+  void read_words(uint32_t vaddr, std::span<uint32_t> out) const {
+    std::span<uint8_t const> raw = contiguous_range(vaddr, static_cast<uint32_t>(out.size() * 4));
+    if (raw.empty()) {
+      for (size_t i = 0; i < out.size(); i++) {
+        out[i] = read_word(vaddr + static_cast<uint32_t>(i * 4));
+      }
+      return;
+    }
+
+    for (size_t i = 0; i < out.size(); i++) {
+      out[i] = (static_cast<uint32_t>(raw[i * 4]) << 24) | (static_cast<uint32_t>(raw[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(raw[i * 4 + 2]) << 8) | static_cast<uint32_t>(raw[i * 4 + 3]);
+    }
+  }
+
+  std::vector<ppc::MetaInst> read_instructions(uint32_t vaddr, size_t count) const {
+    std::vector<ppc::MetaInst> ret(count);
+    visit_instructions(vaddr, count, [&ret](size_t i, ppc::MetaInst const& inst) { ret[i] = inst; });
+    return ret;
+  }
+
+  // Packed instructions point at decoded instructions owned by this object, they stay valid for as long as it does
+  std::vector<ppc::PackedInst> read_packed_instructions(uint32_t vaddr, size_t count) const {
+    std::vector<ppc::PackedInst> ret(count);
+    size_t i = 0;
+    for (; i < count; i++) {
+      ppc::MetaInst const* cached = cached_instruction(vaddr + static_cast<uint32_t>(i * 4));
+      if (cached == nullptr) {
+        break;
+      }
+      ret[i] = ppc::PackedInst(*cached);
+    }
+    for (; i < count; i++) {
+      ret[i] = ppc::PackedInst(uncached_instruction(vaddr + static_cast<uint32_t>(i * 4)));
+    }
+    return ret;
+  }
+
+protected:
+  // Backing memory for a whole range, implementations without contiguous storage can leave this empty and bulk
+  // reads fall back to the per-element getters
+  virtual std::span<uint8_t const> contiguous_range(uint32_t, uint32_t) const { return {}; }
+  // Previously decoded instruction at vaddr, implementations without a decode cache return nullptr
+  virtual ppc::MetaInst const* cached_instruction(uint32_t) const { return nullptr; }
+
+private:
+  // Words no cache covers are decoded once here, so packed instructions have something to point at
+  mutable std::mutex _uncached_lock;
+  mutable std::unordered_map<uint32_t, ppc::MetaInst> _uncached;
+
+  ppc::MetaInst const& uncached_instruction(uint32_t vaddr) const {
+    std::lock_guard lock(_uncached_lock);
+    auto [it, inserted] = _uncached.try_emplace(vaddr);
+    if (inserted) {
+      disasm_single(vaddr, read_word(vaddr), it->second);
+    }
+    return it->second;
+  }
+
+  template <typename Fn>
+  void visit_instructions(uint32_t vaddr, size_t count, Fn&& fn) const {
+    size_t i = 0;
+    for (; i < count; i++) {
+      ppc::MetaInst const* cached = cached_instruction(vaddr + static_cast<uint32_t>(i * 4));
+      if (cached == nullptr) {
+        break;
+      }
+      fn(i, *cached);
+    }
+
+    // Decode whatever isn't backed by a cache
+    std::vector<uint32_t> words(count - i);
+    read_words(vaddr + static_cast<uint32_t>(i * 4), words);
+    for (size_t j = 0; j < words.size(); j++) {
+      ppc::MetaInst decoded;
+      disasm_single(vaddr + static_cast<uint32_t>((i + j) * 4), words[j], decoded);
+      fn(i + j, decoded);
+    }
+  }
 };
 
 }  // namespace decomp
@@ -1,9 +1,24 @@
 #include "producers/SectionedData.hh"
 
 #include <algorithm>
+#include <bit>
+#include <optional>
+#include <type_traits>
 
 namespace decomp {
 namespace {
+// Big endian load, compiles down to a single load + byteswap
+template <typename T>
+T load_be(uint8_t const* src) {
+  using U = std::conditional_t<sizeof(T) == 8, uint64_t, std::conditional_t<sizeof(T) == 4, uint32_t,
+                                                           std::conditional_t<sizeof(T) == 2, uint16_t, uint8_t>>>;
+  U ret = 0;
+  for (size_t i = 0; i < sizeof(T); i++) {
+    ret = static_cast<U>((ret << 8) | src[i]);
+  }
+  return std::bit_cast<T>(ret);
+}
+
 template <typename T>
 std::optional<T> read_generic(dinterval_tree<Section> const& regions, uint32_t address) {
   Section const* sect = regions.query(address, address + sizeof(T));
@@ -14,75 +29,129 @@ std::optional<T> read_generic(dinterval_tree<Section> const& regions, uint32_t a
     return std::nullopt;
   }
 
-  T ret;
-  uint8_t* t_write = reinterpret_cast<uint8_t*>(&ret) + sizeof(T);
-
-  for (size_t i = 0; i < sizeof(T); i++) {
-    *--t_write = sect->_data[i + (address - sect->_base)];
-  }
-
-  return ret;
+  return load_be<T>(sect->_data.data() + (address - sect->_base));
 }
 }  // namespace
 
 bool SectionedData::add_section(uint32_t base, std::string_view data) {
-  return _regions.try_emplace(base, base + data.length(), base, std::vector<uint8_t>(data.begin(), data.end()));
+  return on_section_added(
+    _regions.try_emplace(base, base + data.length(), base, std::vector<uint8_t>(data.begin(), data.end())), base);
 }
 
 bool SectionedData::add_section(uint32_t base, std::vector<uint8_t>&& data) {
-  return _regions.try_emplace(base, base + data.size(), base, std::move(data));
+  return on_section_added(_regions.try_emplace(base, base + data.size(), base, std::move(data)), base);
 }
 
 bool SectionedData::add_section(uint32_t base, std::vector<uint8_t> const& data) {
-  return _regions.try_emplace(base, base + data.size(), base, std::vector<uint8_t>(data));
+  return on_section_added(_regions.try_emplace(base, base + data.size(), base, std::vector<uint8_t>(data)), base);
 }
 
-uint8_t SectionedData::read_byte(uint32_t vaddr) const {
-  auto opt = read_generic<uint8_t>(_regions, vaddr);
-  if (!opt) {
-    return 0;
-  }
-  return *opt;
+bool SectionedData::add_mapped_section(uint32_t base, std::span<uint8_t const> data) {
+  return on_section_added(_regions.try_emplace(base, base + data.size(), base, data), base);
 }
 
-uint16_t SectionedData::read_half(uint32_t vaddr) const {
-  auto opt = read_generic<uint16_t>(_regions, vaddr);
-  if (!opt) {
-    return 0;
+bool SectionedData::on_section_added(bool added, uint32_t base) {
+  if (!added) {
+    return false;
+  }
+
+  // Nodes are heap allocated by the tree, so this pointer stays valid
+  Section const* sect = _regions.query(base, base + 1);
+  if (sect != nullptr) {
+    _sections.push_back(sect);
+    rebuild_page_table();
   }
-  return *opt;
+  return true;
 }
 
-uint32_t SectionedData::read_word(uint32_t vaddr) const {
-  auto opt = read_generic<uint32_t>(_regions, vaddr);
-  if (!opt) {
-    return 0;
+void SectionedData::rebuild_page_table() {
+  _page_table.clear();
+  if (_sections.empty()) {
+    return;
+  }
+
+  uint64_t lo = UINT64_MAX, hi = 0;
+  for (Section const* sect : _sections) {
+    lo = std::min(lo, static_cast<uint64_t>(sect->left()));
+    hi = std::max(hi, static_cast<uint64_t>(sect->_base) + sect->_data.size());
+  }
+
+  const uint64_t first_page = lo >> kPageBits;
+  const uint64_t last_page = (hi - 1) >> kPageBits;
+  if (last_page - first_page + 1 > kMaxPages) {
+    return;
+  }
+
+  _page_table_base = static_cast<uint32_t>(first_page << kPageBits);
+  _page_table.resize(last_page - first_page + 1);
+  for (Section const* sect : _sections) {
+    const uint32_t sect_hi = sect->right();
+    for (uint64_t page = sect->left() >> kPageBits; page <= ((sect_hi - 1) >> kPageBits); page++) {
+      PageEntry& entry = _page_table[page - first_page];
+      if (entry._host == nullptr) {
+        entry = PageEntry{sect->_data.data(), sect->_decoded.get(), sect->left(), sect_hi};
+      }
+    }
   }
-  return *opt;
 }
 
-uint64_t SectionedData::read_long(uint32_t vaddr) const {
-  auto opt = read_generic<uint64_t>(_regions, vaddr);
-  if (!opt) {
-    return 0;
+template <typename T>
+T SectionedData::read_translated(uint32_t vaddr) const {
+  // Addresses below the table base wrap around to a huge index and miss
+  const size_t idx = (vaddr - _page_table_base) >> kPageBits;
+  if (idx < _page_table.size()) {
+    PageEntry const& entry = _page_table[idx];
+    if (vaddr >= entry._lo && static_cast<uint64_t>(vaddr) + sizeof(T) <= entry._hi) {
+      return load_be<T>(entry._host + (vaddr - entry._lo));
+    }
   }
-  return *opt;
+
+  return read_generic<T>(_regions, vaddr).value_or(T{});
 }
 
-float SectionedData::read_float(uint32_t vaddr) const {
-  auto opt = read_generic<float>(_regions, vaddr);
-  if (!opt) {
-    return 0.f;
+uint8_t SectionedData::read_byte(uint32_t vaddr) const { return read_translated<uint8_t>(vaddr); }
+
+uint16_t SectionedData::read_half(uint32_t vaddr) const { return read_translated<uint16_t>(vaddr); }
+
+uint32_t SectionedData::read_word(uint32_t vaddr) const { return read_translated<uint32_t>(vaddr); }
+
+uint64_t SectionedData::read_long(uint32_t vaddr) const { return read_translated<uint64_t>(vaddr); }
+
+float SectionedData::read_float(uint32_t vaddr) const { return read_translated<float>(vaddr); }
+
+double SectionedData::read_double(uint32_t vaddr) const { return read_translated<double>(vaddr); }
+
+std::span<uint8_t const> SectionedData::contiguous_range(uint32_t vaddr, uint32_t len) const {
+  const uint64_t range_end = static_cast<uint64_t>(vaddr) + len;
+  const size_t idx = (vaddr - _page_table_base) >> kPageBits;
+  if (idx < _page_table.size()) {
+    PageEntry const& entry = _page_table[idx];
+    if (vaddr >= entry._lo && range_end <= entry._hi) {
+      return {entry._host + (vaddr - entry._lo), len};
+    }
   }
-  return *opt;
+
+  Section const* sect = _regions.query(vaddr, vaddr + 1);
+  if (sect == nullptr || range_end > sect->right()) {
+    return {};
+  }
+  return sect->_data.subspan(vaddr - sect->_base, len);
 }
 
-double SectionedData::read_double(uint32_t vaddr) const {
-  auto opt = read_generic<double>(_regions, vaddr);
-  if (!opt) {
-    return 0.;
+ppc::MetaInst const* SectionedData::cached_instruction(uint32_t vaddr) const {
+  const size_t idx = (vaddr - _page_table_base) >> kPageBits;
+  if (idx < _page_table.size()) {
+    InstructionCache const* decoded = _page_table[idx]._decoded;
+    if (decoded != nullptr && decoded->contains(vaddr)) {
+      return &decoded->get(vaddr);
+    }
+  }
+
+  Section const* sect = _regions.query(vaddr, vaddr + 4);
+  if (sect == nullptr || !sect->_decoded->contains(vaddr)) {
+    return nullptr;
   }
-  return *opt;
+  return &sect->_decoded->get(vaddr);
 }
 
 Section const* SectionedData::section_for_vaddr(uint32_t vaddr) const { return _regions.query(vaddr, vaddr + 1); }
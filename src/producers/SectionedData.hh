@@ -1,17 +1,32 @@
 #pragma once
 
+#include <memory>
+#include <span>
 #include <string_view>
 #include <vector>
 
+#include "producers/InstructionCache.hh"
 #include "producers/RandomAccessData.hh"
 #include "utl/IntervalTree.hh"
+#include "utl/MappedFile.hh"
 
 namespace decomp {
 struct Section {
-  Section(uint32_t base, std::vector<uint8_t>&& data) : _base(base), _data(std::move(data)) {}
+  Section(uint32_t base, std::vector<uint8_t>&& data)
+      : _base(base), _owned(std::move(data)), _data(_owned), _decoded(std::make_unique<InstructionCache>(base, _data)) {}
+  // Non-owning section, the referenced bytes must outlive the section
+  Section(uint32_t base, std::span<uint8_t const> data)
+      : _base(base), _data(data), _decoded(std::make_unique<InstructionCache>(base, _data)) {}
+  // _data may point into _owned, copying would leave it dangling
+  Section(Section const&) = delete;
+  Section(Section&&) = default;
 
   uint32_t _base;
-  std::vector<uint8_t> _data;
+  // Backing storage for sections that were copied in, empty for sections referencing external memory
+  std::vector<uint8_t> _owned;
+  std::span<uint8_t const> _data;
+  // Decoded on demand, only chunks that are actually read as code get allocated
+  std::unique_ptr<InstructionCache> _decoded;
 
   constexpr uint32_t left() const { return _base; }
   uint32_t right() const { return _base + static_cast<uint32_t>(_data.size()); }
@@ -25,12 +40,39 @@ struct Section {
 
 class SectionedData : public RandomAccessData {
 private:
+  // Flat translation table, one entry per page between the lowest and highest section
+  // Each entry caches the host memory of one section touching that page; pages shared by two sections only
+  // resolve the first one, reads that miss fall back to _regions
+  struct PageEntry {
+    uint8_t const* _host = nullptr;
+    InstructionCache const* _decoded = nullptr;
+    uint32_t _lo = 0, _hi = 0;
+  };
+  static constexpr uint32_t kPageBits = 12;
+  // Past this many pages the address space is too sparse for a flat table (256MiB of VA)
+  static constexpr size_t kMaxPages = 1 << 16;
+
   dinterval_tree<Section> _regions;
+  std::vector<Section const*> _sections;
+  std::vector<PageEntry> _page_table;
+  uint32_t _page_table_base = 0;
+
+  bool on_section_added(bool added, uint32_t base);
+  void rebuild_page_table();
+
+  template <typename T>
+  T read_translated(uint32_t vaddr) const;
+
+protected:
+  // File image that mapped sections point into, kept alive for the lifetime of this object
+  std::unique_ptr<MappedFile> _image;
 
 public:
   bool add_section(uint32_t base, std::string_view data);
   bool add_section(uint32_t base, std::vector<uint8_t>&& data);
   bool add_section(uint32_t base, std::vector<uint8_t> const& data);
+  // Add a section without copying, the referenced bytes must outlive this object
+  bool add_mapped_section(uint32_t base, std::span<uint8_t const> data);
 
   virtual ~SectionedData() {}
 
@@ -42,6 +84,10 @@ public:
   double read_double(uint32_t vaddr) const override;
 
   Section const* section_for_vaddr(uint32_t vaddr) const;
+
+protected:
+  std::span<uint8_t const> contiguous_range(uint32_t vaddr, uint32_t len) const override;
+  ppc::MetaInst const* cached_instruction(uint32_t vaddr) const override;
 };
 
 }  // namespace decomp
@@ -0,0 +1,345 @@
+#include "utl/DominatorTree.hh"
+
+#include <algorithm>
+#include <utility>
+
+#include "utl/FlowGraphSnapshot.hh"
+
+namespace decomp {
+DominatorTree::DominatorTree(std::vector<int> idom, bool post)
+    : _idom(std::move(idom)),
+      _children(_idom.size()),
+      _post(post),
+      _stamp(_idom.size(), 0),
+      _dfs_num(_idom.size(), -1) {
+  for (int v = 0; v < static_cast<int>(_idom.size()); v++) {
+    if (_idom[v] == v) {
+      _root = v;
+    } else if (_idom[v] != -1) {
+      _children[_idom[v]].push_back(v);
+    }
+  }
+  reindex();
+}
+
+DominatorTree DominatorTree::dominators(FlowGraphBase const& graph) {
+  return DominatorTree(graph.compute_dom_tree(), false);
+}
+
+DominatorTree DominatorTree::postdominators(FlowGraphBase const& graph) {
+  return DominatorTree(graph.compute_pdom_tree(), true);
+}
+
+void DominatorTree::grow(size_t size) {
+  if (size <= _idom.size()) {
+    return;
+  }
+  _idom.resize(size, -1);
+  _children.resize(size);
+  _stamp.resize(size, 0);
+  _dfs_num.resize(size, -1);
+  _indexed = false;
+}
+
+uint32_t DominatorTree::next_epoch() {
+  if (++_epoch == 0) {
+    std::fill(_stamp.begin(), _stamp.end(), 0);
+    _epoch = 1;
+  }
+  return _epoch;
+}
+
+void DominatorTree::set_idom(int v, int idom) {
+  if (_idom[v] != -1 && _idom[v] != v) {
+    std::vector<int>& siblings = _children[_idom[v]];
+    siblings.erase(std::find(siblings.begin(), siblings.end(), v));
+  }
+  _idom[v] = idom;
+  if (idom != -1) {
+    _children[idom].push_back(v);
+  }
+}
+
+int DominatorTree::nearest_common_dominator(int a, int b) {
+  const uint32_t epoch = next_epoch();
+  for (int v = a;; v = _idom[v]) {
+    _stamp[v] = epoch;
+    if (v == _root) {
+      break;
+    }
+  }
+  for (; _stamp[b] != epoch; b = _idom[b])
+    ;
+  return b;
+}
+
+void DominatorTree::reindex() {
+  const size_t n = _idom.size();
+  _pre.assign(n, -1);
+  _last.assign(n, -1);
+  _depth.assign(n, 0);
+  _indexed = true;
+  if (_root == -1) {
+    return;
+  }
+
+  // Number the tree in preorder, a vertex's subtree ends once it's popped off the path
+  int counter = 0;
+  std::vector<std::pair<int, uint32_t>> path;
+  _pre[_root] = counter++;
+  path.emplace_back(_root, 0);
+  while (!path.empty()) {
+    auto& [vert, next_child] = path.back();
+    if (next_child == _children[vert].size()) {
+      _last[vert] = counter - 1;
+      path.pop_back();
+      continue;
+    }
+
+    const int child = _children[vert][next_child++];
+    _pre[child] = counter++;
+    _depth[child] = _depth[vert] + 1;
+    path.emplace_back(child, 0);
+  }
+}
+
+void DominatorTree::rebuild_below(FlowGraphBase const& graph, int top, std::span<int const> extra) {
+  // Everything that may move, the subtree under top and whatever the update made reachable
+  const uint32_t epoch = next_epoch();
+  std::vector<int> region{top};
+  _stamp[top] = epoch;
+  for (size_t i = 0; i < region.size(); i++) {
+    for (int child : _children[region[i]]) {
+      _stamp[child] = epoch;
+      region.push_back(child);
+    }
+  }
+  for (int v : extra) {
+    _stamp[v] = epoch;
+    region.push_back(v);
+  }
+
+  // Nothing outside the region can reach into it without going through top, so Semi-NCA over the region alone gives
+  // the same idoms as over the whole graph
+  std::vector<int> vert{top};
+  std::vector<int> parent{0};
+  std::vector<std::pair<int, uint32_t>> path;
+  _dfs_num[top] = 0;
+  path.emplace_back(top, 0);
+  while (!path.empty()) {
+    auto& [v, next_edge] = path.back();
+    EdgeList const& out = succs(graph, v);
+    if (next_edge == out.size()) {
+      path.pop_back();
+      continue;
+    }
+    const int target = out[next_edge++]._target;
+    if (_stamp[target] == epoch && _dfs_num[target] == -1) {
+      _dfs_num[target] = static_cast<int>(vert.size());
+      parent.push_back(_dfs_num[v]);
+      vert.push_back(target);
+      path.emplace_back(target, 0);
+    }
+  }
+  const int nreached = static_cast<int>(vert.size());
+
+  std::vector<int> semi(nreached);
+  std::iota(semi.begin(), semi.end(), 0);
+  detail::EvalForest forest(nreached, semi);
+  for (int w = nreached - 1; w > 0; w--) {
+    for (EdgeData const& ed : preds(graph, vert[w])) {
+      // Skip predecessors outside the region or unreachable from top
+      const int v = _stamp[ed._target] == epoch ? _dfs_num[ed._target] : -1;
+      if (v != -1) {
+        semi[w] = std::min(semi[w], semi[forest.eval(v)]);
+      }
+    }
+    forest.link(parent[w], w);
+  }
+  std::vector<int> idom(parent);
+  for (int w = 1; w < nreached; w++) {
+    while (idom[w] > semi[w]) {
+      idom[w] = idom[idom[w]];
+    }
+  }
+
+  // Top keeps its place, everything under it is relinked and whatever the DFS missed drops out of the tree
+  for (int v : region) {
+    _children[v].clear();
+    _dfs_num[v] = -1;
+    if (v != top) {
+      _idom[v] = -1;
+    }
+  }
+  for (int w = 1; w < nreached; w++) {
+    _idom[vert[w]] = vert[idom[w]];
+    _children[vert[idom[w]]].push_back(vert[w]);
+  }
+  _indexed = false;
+}
+
+void DominatorTree::insert_edge(FlowGraphBase const& graph, int from, int to) {
+  grow(graph.size());
+  if (_post) {
+    std::swap(from, to);
+  }
+  if (!contains(from)) {
+    // Still unreachable
+    return;
+  }
+  if (contains(to)) {
+    const int ncd = nearest_common_dominator(from, to);
+    if (ncd == to || ncd == _idom[to]) {
+      return;
+    }
+    rebuild_below(graph, ncd, {});
+    return;
+  }
+
+  // The edge opens up a part of the graph that was unreachable, it and every vertex it leads back into hang below
+  // the nearest common dominator of all of them
+  std::vector<int> opened{to};
+  std::vector<int> entered;
+  const uint32_t epoch = next_epoch();
+  _stamp[to] = epoch;
+  for (size_t i = 0; i < opened.size(); i++) {
+    for (EdgeData const& ed : succs(graph, opened[i])) {
+      if (contains(ed._target)) {
+        entered.push_back(ed._target);
+      } else if (_stamp[ed._target] != epoch) {
+        _stamp[ed._target] = epoch;
+        opened.push_back(ed._target);
+      }
+    }
+  }
+  int top = from;
+  for (int v : entered) {
+    top = nearest_common_dominator(top, v);
+  }
+  rebuild_below(graph, top, opened);
+}
+
+void DominatorTree::delete_edge(FlowGraphBase const& graph, int from, int to) {
+  grow(graph.size());
+  if (_post) {
+    std::swap(from, to);
+  }
+  if (!contains(from) || !contains(to)) {
+    return;
+  }
+  const int ncd = nearest_common_dominator(from, to);
+  if (ncd == to) {
+    // Every path over the edge already went through to
+    return;
+  }
+
+  // To stays reachable when something other than from got there first, or when it's left with a predecessor it
+  // doesn't dominate. Then only the subtree under ncd can change
+  bool reachable = from != _idom[to];
+  for (size_t i = 0; !reachable && i < preds(graph, to).size(); i++) {
+    const int pred = preds(graph, to)[i]._target;
+    reachable = contains(pred) && nearest_common_dominator(to, pred) != to;
+  }
+  if (reachable) {
+    rebuild_below(graph, ncd, {});
+    return;
+  }
+
+  // Otherwise to and everything it dominates drop out, and the vertices they used to lead into can lose paths. Those
+  // and everything they reach hang below the nearest common dominator of the lot
+  std::vector<int> lost{to};
+  for (size_t i = 0; i < lost.size(); i++) {
+    lost.insert(lost.end(), _children[lost[i]].begin(), _children[lost[i]].end());
+  }
+  const uint32_t epoch = next_epoch();
+  for (int v : lost) {
+    _stamp[v] = epoch;
+  }
+  std::vector<int> entered;
+  for (int v : lost) {
+    for (EdgeData const& ed : succs(graph, v)) {
+      if (contains(ed._target) && _stamp[ed._target] != epoch) {
+        entered.push_back(ed._target);
+      }
+    }
+  }
+  int top = from;
+  for (int v : entered) {
+    top = nearest_common_dominator(top, v);
+  }
+  rebuild_below(graph, top, {});
+}
+
+void DominatorTree::collapse(std::span<int const> members, int header, int repl) {
+  grow(repl + 1);
+  const uint32_t epoch = next_epoch();
+  for (int m : members) {
+    _stamp[m] = epoch;
+  }
+  const auto is_member = [this, epoch](int v) { return _stamp[v] == epoch; };
+
+  if (!contains(header)) {
+    // The header reaches every member, none of them can be in the tree either
+    return;
+  }
+
+  // Dominance between vertices outside the region doesn't change, and repl takes the place of the header. Anything
+  // hanging off a member moves up to the nearest of those ancestors
+  const auto lift = [this, &is_member, header, repl](int v) {
+    for (; v != header && is_member(v); v = _idom[v])
+      ;
+    return v == header ? repl : v;
+  };
+  // Collapsing a region headed by the root makes repl the new root, the root being its own idom
+  const bool at_root = header == _root;
+  int repl_idom = repl;
+  if (!at_root) {
+    repl_idom = _idom[header];
+    for (; is_member(repl_idom); repl_idom = _idom[repl_idom])
+      ;
+  }
+
+  std::vector<std::pair<int, int>> moved;
+  for (int m : members) {
+    if (!contains(m)) {
+      continue;
+    }
+    for (int child : _children[m]) {
+      if (!is_member(child)) {
+        moved.emplace_back(child, lift(m));
+      }
+    }
+  }
+  for (int m : members) {
+    if (!contains(m)) {
+      continue;
+    }
+    if (!is_member(_idom[m])) {
+      std::vector<int>& siblings = _children[_idom[m]];
+      siblings.erase(std::find(siblings.begin(), siblings.end(), m));
+    }
+    _children[m].clear();
+    _idom[m] = -1;
+  }
+
+  _idom[repl] = repl_idom;
+  if (at_root) {
+    _root = repl;
+  } else {
+    _children[repl_idom].push_back(repl);
+  }
+  for (auto [child, idom] : moved) {
+    _idom[child] = idom;
+    _children[idom].push_back(child);
+  }
+  _indexed = false;
+}
+
+bool DominatorTree::matches(FlowGraphBase const& graph) const {
+  std::vector<int> expected = _post ? graph.compute_pdom_tree() : graph.compute_dom_tree();
+  expected.resize(std::max(expected.size(), _idom.size()), -1);
+  std::vector<int> actual = _idom;
+  actual.resize(expected.size(), -1);
+  return expected == actual;
+}
+}  // namespace decomp
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "utl/FlowGraph.hh"
+
+namespace decomp {
+namespace detail {
+// Link-eval forest over DFS numbers, eval(v) gives the vertex with the smallest semidominator on the forest path
+// above v. Paths are compressed as they're walked so a run of evals costs O(m log n)
+class EvalForest {
+private:
+  std::vector<int> _ancestor;
+  std::vector<int> _label;
+  std::vector<int> const& _semi;
+  std::vector<int> _path;
+
+  void compress(int v) {
+    while (_ancestor[_ancestor[v]] != -1) {
+      _path.push_back(v);
+      v = _ancestor[v];
+    }
+    // Nearest the forest root first so every label pulled down is already final
+    while (!_path.empty()) {
+      const int u = _path.back();
+      _path.pop_back();
+      const int a = _ancestor[u];
+      if (_semi[_label[a]] < _semi[_label[u]]) {
+        _label[u] = _label[a];
+      }
+      _ancestor[u] = _ancestor[a];
+    }
+  }
+
+public:
+  EvalForest(size_t len, std::vector<int> const& semi) : _ancestor(len, -1), _label(len), _semi(semi) {
+    std::iota(_label.begin(), _label.end(), 0);
+  }
+
+  void link(int parent, int v) { _ancestor[v] = parent; }
+
+  int eval(int v) {
+    if (_ancestor[v] == -1) {
+      return v;
+    }
+    compress(v);
+    return _label[v];
+  }
+};
+}  // namespace detail
+
+// Dominator (or post-dominator) tree of a FlowGraph. While indexed, every vertex has a preorder interval over the tree
+// so dominance is a range check. Updates keep the tree exact as the graph changes but drop the index, queries walk
+// idoms until reindex() is called
+class DominatorTree {
+private:
+  std::vector<int> _idom;
+  std::vector<std::vector<int>> _children;
+  // Preorder number of each vertex, and the last preorder number inside its subtree. -1 when not in the tree
+  std::vector<int> _pre;
+  std::vector<int> _last;
+  std::vector<int> _depth;
+  bool _indexed = false;
+  int _root = -1;
+  // Post-dominator trees walk the graph backwards from the terminal
+  bool _post = false;
+  // Scratch space for updates, a vertex is marked when its stamp matches _epoch
+  std::vector<uint32_t> _stamp;
+  uint32_t _epoch = 0;
+  // DFS numbers during rebuild_below, -1 everywhere outside of it
+  std::vector<int> _dfs_num;
+
+  void grow(size_t size);
+  uint32_t next_epoch();
+  EdgeList const& succs(FlowGraphBase const& graph, int v) const {
+    return _post ? graph.vertex(v)->_in : graph.vertex(v)->_out;
+  }
+  EdgeList const& preds(FlowGraphBase const& graph, int v) const {
+    return _post ? graph.vertex(v)->_out : graph.vertex(v)->_in;
+  }
+  void set_idom(int v, int idom);
+  int nearest_common_dominator(int a, int b);
+  // Recomputes idoms for the subtree under top plus the extra vertices, which is all that can change for an edge
+  // update whose endpoints are both under top
+  void rebuild_below(FlowGraphBase const& graph, int top, std::span<int const> extra);
+
+public:
+  DominatorTree() = default;
+  // Takes idoms as returned by compute_dom_tree/compute_pdom_tree, the root is its own idom and vertices outside the
+  // tree are -1
+  explicit DominatorTree(std::vector<int> idom, bool post = false);
+  static DominatorTree dominators(FlowGraphBase const& graph);
+  static DominatorTree postdominators(FlowGraphBase const& graph);
+
+  size_t size() const { return _idom.size(); }
+  int root() const { return _root; }
+  bool is_post() const { return _post; }
+  bool contains(int v) const { return static_cast<size_t>(v) < _idom.size() && _idom[v] != -1; }
+  int idom(int v) const { return _idom[v]; }
+  std::vector<int> const& idoms() const { return _idom; }
+  std::span<int const> children(int v) const { return _children[v]; }
+
+  bool indexed() const { return _indexed; }
+  void reindex();
+  // Only valid while indexed
+  int depth(int v) const { return _depth[v]; }
+
+  // n dom m, vertices outside the tree dominate nothing and are dominated by nothing
+  bool dominates(int n, int m) const {
+    if (_indexed) {
+      return _pre[n] != -1 && _pre[n] <= _pre[m] && _pre[m] <= _last[n];
+    }
+    if (!contains(n) || !contains(m)) {
+      return false;
+    }
+    for (; m != n && _idom[m] != m; m = _idom[m])
+      ;
+    return m == n;
+  }
+  bool strictly_dominates(int n, int m) const { return n != m && dominates(n, m); }
+
+  // Call after the edge has been linked in the graph
+  void insert_edge(FlowGraphBase const& graph, int from, int to);
+  // Call after the edge has been removed from the graph
+  void delete_edge(FlowGraphBase const& graph, int from, int to);
+  // Call after members have been replaced in the graph by repl, which takes over the in-edges of header from outside
+  // the region and the out-edges of every member leaving it. The region has to be single entry through header, and
+  // header has to reach every member without leaving it, which holds for every region the structurizer collapses
+  void collapse(std::span<int const> members, int header, int repl);
+
+  // Full recompute to check updates against
+  bool matches(FlowGraphBase const& graph) const;
+};
+}  // namespace decomp
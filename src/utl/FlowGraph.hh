@@ -1,10 +1,12 @@
 #pragma once
 
 #include <algorithm>
+#include <cassert>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
-#include <memory>
 #include <optional>
+#include <span>
 #include <type_traits>
 #include <utility>
 #include <variant>
@@ -34,6 +36,10 @@ constexpr bool inverse_condition(BlockTransfer bt0, BlockTransfer bt1) {
          (bt0 == BlockTransfer::kConditionFalse && bt1 == BlockTransfer::kConditionTrue);
 }
 
+constexpr BlockTransfer invert_condition(BlockTransfer bt) {
+  return bt == BlockTransfer::kConditionTrue ? BlockTransfer::kConditionFalse : BlockTransfer::kConditionTrue;
+}
+
 struct EdgeData {
   EdgeData() : _target(-1), _tr(BlockTransfer::kUnconditional) {}
   EdgeData(int target, BlockTransfer tr) : _target(target), _tr(tr) {}
@@ -44,13 +50,118 @@ struct EdgeData {
   constexpr bool operator!=(EdgeData const& rhs) const { return !(*this == rhs); }
 };
 
+// Edge list keeping up to kInlineEdges edges in place, which covers nearly every block. Only switch-like fan-out spills
+// to the heap
+class EdgeList {
+private:
+  static constexpr uint32_t kInlineEdges = 2;
+
+  EdgeData* _data;
+  uint32_t _size = 0;
+  uint32_t _capacity = kInlineEdges;
+  EdgeData _inline[kInlineEdges];
+
+  bool spilled() const { return _data != _inline; }
+
+  void release() {
+    if (spilled()) {
+      delete[] _data;
+    }
+  }
+
+  void grow(uint32_t capacity) {
+    EdgeData* data = new EdgeData[capacity];
+    std::copy(begin(), end(), data);
+    release();
+    _data = data;
+    _capacity = capacity;
+  }
+
+public:
+  using iterator = EdgeData*;
+  using const_iterator = EdgeData const*;
+
+  EdgeList() : _data(_inline) {}
+  EdgeList(EdgeList const& rhs) : EdgeList() { *this = rhs; }
+  EdgeList(EdgeList&& rhs) noexcept : EdgeList() { *this = std::move(rhs); }
+  ~EdgeList() { release(); }
+
+  EdgeList& operator=(EdgeList const& rhs) {
+    if (this != &rhs) {
+      if (rhs._size > _capacity) {
+        _size = 0;
+        grow(rhs._size);
+      }
+      std::copy(rhs.begin(), rhs.end(), _data);
+      _size = rhs._size;
+    }
+    return *this;
+  }
+  EdgeList& operator=(EdgeList&& rhs) noexcept {
+    if (this == &rhs) {
+      return *this;
+    }
+    if (rhs.spilled()) {
+      // Take over the heap buffer
+      release();
+      _data = rhs._data;
+      _capacity = rhs._capacity;
+      rhs._data = rhs._inline;
+      rhs._capacity = kInlineEdges;
+    } else {
+      std::copy(rhs.begin(), rhs.end(), _data);
+    }
+    _size = rhs._size;
+    rhs._size = 0;
+    return *this;
+  }
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  iterator begin() { return _data; }
+  iterator end() { return _data + _size; }
+  const_iterator begin() const { return _data; }
+  const_iterator end() const { return _data + _size; }
+
+  EdgeData& operator[](size_t i) { return _data[i]; }
+  EdgeData const& operator[](size_t i) const { return _data[i]; }
+  EdgeData& front() { return _data[0]; }
+  EdgeData const& front() const { return _data[0]; }
+  EdgeData& back() { return _data[_size - 1]; }
+  EdgeData const& back() const { return _data[_size - 1]; }
+
+  template <typename... Args>
+  EdgeData& emplace_back(Args&&... args) {
+    // Build the edge first, the arguments may point into this list
+    const EdgeData edge(std::forward<Args>(args)...);
+    if (_size == _capacity) {
+      // The capacity is never 0, but GCC can't tell and warns about the copy into a zero sized buffer
+      grow(std::max(2 * _capacity, kInlineEdges));
+    }
+    _data[_size] = edge;
+    return _data[_size++];
+  }
+  void push_back(EdgeData const& edge) { emplace_back(edge); }
+
+  iterator erase(const_iterator it) {
+    iterator pos = _data + (it - _data);
+    std::copy(pos + 1, end(), pos);
+    _size--;
+    return pos;
+  }
+  void clear() { _size = 0; }
+
+  bool operator==(EdgeList const& rhs) const { return std::equal(begin(), end(), rhs.begin(), rhs.end()); }
+  bool operator!=(EdgeList const& rhs) const { return !(*this == rhs); }
+};
+
 struct FlowVertexBase {
   FlowVertexBase(int idx) : _idx(idx) {}
-  virtual ~FlowVertexBase() {}
 
   int _idx = -1;
-  std::vector<EdgeData> _out;
-  std::vector<EdgeData> _in;
+  EdgeList _out;
+  EdgeList _in;
   bool _detached = false;
 
   bool single_succ() const { return _out.size() == 1; }
@@ -60,42 +171,68 @@ struct FlowVertexBase {
   bool icbs() const { return _out.size() == 2 && inverse_condition(_out[0]._tr, _out[1]._tr); }
 };
 
+// Edges entering and leaving a region being collapsed. Callers collapsing many regions keep one around so the lists
+// are reused rather than allocated per region
+struct RegionLinks {
+  std::vector<EdgeData> _in;
+  std::vector<EdgeData> _out;
+};
+
+// Vertices are stored by value in the derived FlowGraph, so adding vertices invalidates pointers and references to
+// them. Hold on to vertex indices across emplace_vertex, substitute_pair and insert_after
 class FlowGraphBase {
 private:
-  std::vector<std::unique_ptr<FlowVertexBase>> _vtx;
+  // Base subobject of the first vertex in the derived graph's storage, the rest follow every _vtx_stride bytes
+  std::byte* _vtx_data = nullptr;
+  size_t _vtx_stride = 0;
+  size_t _num_vtx = 0;
   int _root_id;
   int _terminal_id;
 
-  template <bool PreDominator>
-  std::vector<int> lengauer_tarjan();
-
 protected:
   // Disallow creation of untemplated FlowGraphBase type externally
   FlowGraphBase() : _root_id(kInvalidVertexId), _terminal_id(kInvalidVertexId) {}
-  void add_existing_vertex(FlowVertexBase* v) { _vtx.emplace_back(v); }
+  void set_vertex_storage(FlowVertexBase* first, size_t stride, size_t count) {
+    _vtx_data = reinterpret_cast<std::byte*>(first);
+    _vtx_stride = stride;
+    _num_vtx = count;
+  }
   void set_root(int id) { _root_id = id; }
   void set_terminal(int id) { _terminal_id = id; }
-  void substitute_pair_existing(std::pair<int, int> vsub, FlowVertexBase* v);
+  // Moves the links of both vertices in vsub over to the already added vertex new_idx
+  void substitute_pair_links(std::pair<int, int> vsub, int new_idx);
+  // Moves the links entering and leaving the region over to the already added vertex new_idx
+  void substitute_region_links(std::span<int const> members, int new_idx, RegionLinks& links);
 
 public:
   inline static constexpr int kInvalidVertexId = -1;
 
-  size_t size() const { return _vtx.size(); }
+  size_t size() const { return _num_vtx; }
 
-  FlowVertexBase* root() { return _vtx[_root_id].get(); }
-  FlowVertexBase const* root() const { return _vtx[_root_id].get(); }
+  FlowVertexBase* root() { return vertex(_root_id); }
+  FlowVertexBase const* root() const { return vertex(_root_id); }
 
-  FlowVertexBase* terminal() { return _vtx[_terminal_id].get(); }
-  FlowVertexBase const* terminal() const { return _vtx[_terminal_id].get(); }
+  FlowVertexBase* terminal() { return vertex(_terminal_id); }
+  FlowVertexBase const* terminal() const { return vertex(_terminal_id); }
 
-  FlowVertexBase* vertex(int idx) { return _vtx[idx].get(); }
-  FlowVertexBase const* vertex(int idx) const { return _vtx[idx].get(); }
+  FlowVertexBase* vertex(int idx) {
+    assert(idx >= 0 && static_cast<size_t>(idx) < _num_vtx);
+    return reinterpret_cast<FlowVertexBase*>(_vtx_data + idx * _vtx_stride);
+  }
+  FlowVertexBase const* vertex(int idx) const {
+    assert(idx >= 0 && static_cast<size_t>(idx) < _num_vtx);
+    return reinterpret_cast<FlowVertexBase const*>(_vtx_data + idx * _vtx_stride);
+  }
 
-  std::vector<int> compute_dom_tree();
-  std::vector<int> compute_pdom_tree();
+  // Both go through a FlowGraphSnapshot, take one directly when the graph is walked more than once. Wrap the result in
+  // a DominatorTree for dominance queries
+  std::vector<int> compute_dom_tree() const;
+  std::vector<int> compute_pdom_tree() const;
 
   // Removes all links of a node, but does not deallocate it
   void detach(FlowVertexBase* v);
+  // Removes one link between the two vertices
+  void remove_link(int from_idx, int to_idx);
 
   void emplace_link(FlowVertexBase* from, FlowVertexBase* to, BlockTransfer tr) {
     from->_out.emplace_back(to->_idx, tr);
@@ -197,7 +334,9 @@ struct FlowVertex : public FlowVertexBase {
   FlowVertex(int idx)
       : FlowVertexBase(idx), _d(std::in_place_type<PseudoVertexType>, PseudoVertexType::kUninitialized) {}
   FlowVertex(int idx, PseudoVertexType vtype) : FlowVertexBase(idx), _d(std::in_place_type<PseudoVertexType>, vtype) {}
-  virtual ~FlowVertex() {}
+  template <typename... VDArgs>
+  FlowVertex(int idx, std::in_place_type_t<VertexData> tag, VDArgs&&... args)
+      : FlowVertexBase(idx), _d(tag, std::forward<VDArgs>(args)...) {}
   VertexData& data() { return std::get<VertexData>(_d); }
   VertexData const& data() const { return std::get<VertexData>(_d); }
   PseudoVertexType pseudo() const { return std::get<PseudoVertexType>(_d); }
@@ -222,6 +361,25 @@ class FlowGraph : public FlowGraphBase {
 public:
   using Vertex = FlowVertex<VertexData>;
 
+private:
+  std::vector<Vertex> _vertices;
+
+  void sync_storage() {
+    set_vertex_storage(_vertices.empty() ? nullptr : static_cast<FlowVertexBase*>(_vertices.data()),
+      sizeof(Vertex),
+      _vertices.size());
+  }
+
+  template <typename... Args>
+  int add_vertex(Args&&... args) {
+    const int idx = static_cast<int>(_vertices.size());
+    _vertices.emplace_back(idx, std::forward<Args>(args)...);
+    sync_storage();
+    return idx;
+  }
+
+public:
+
   class iterator {
     FlowGraph* _owner;
     int _idx;
@@ -278,6 +436,19 @@ public:
     set_root(emplace_pseudovertex(PseudoVertexType::kGraphPreheader));
     set_terminal(emplace_pseudovertex(PseudoVertexType::kGraphPostExit));
   }
+  FlowGraph(FlowGraph const&) = delete;
+  FlowGraph(FlowGraph&& rhs) noexcept : FlowGraphBase(rhs), _vertices(std::move(rhs._vertices)) {
+    sync_storage();
+    rhs.sync_storage();
+  }
+  FlowGraph& operator=(FlowGraph const&) = delete;
+  FlowGraph& operator=(FlowGraph&& rhs) noexcept {
+    FlowGraphBase::operator=(rhs);
+    _vertices = std::move(rhs._vertices);
+    sync_storage();
+    rhs.sync_storage();
+    return *this;
+  }
 
   iterator begin() { return iterator(this, 0); }
   iterator end() { return iterator(this, size()); }
@@ -290,8 +461,8 @@ public:
   Vertex* terminal() { return static_cast<Vertex*>(FlowGraphBase::terminal()); }
   Vertex const* terminal() const { return static_cast<Vertex const*>(FlowGraphBase::terminal()); }
 
-  Vertex* vertex(int idx) { return static_cast<Vertex*>(FlowGraphBase::vertex(idx)); }
-  Vertex const* vertex(int idx) const { return static_cast<Vertex const*>(FlowGraphBase::vertex(idx)); }
+  Vertex* vertex(int idx) { return &_vertices[idx]; }
+  Vertex const* vertex(int idx) const { return &_vertices[idx]; }
 
   Vertex const* entrypoint() const { return root()->_out.size() > 0 ? vertex(root()->_out[0]._target) : nullptr; }
   Vertex* entrypoint() { return root()->_out.size() > 0 ? vertex(root()->_out[0]._target) : nullptr; }
@@ -362,39 +533,53 @@ public:
   template <typename... VDArgs>
     requires std::constructible_from<VertexData, VDArgs...>
   int emplace_vertex(VDArgs&&... args) {
-    Vertex* newv = new Vertex(size());
-    newv->_d.template emplace<VertexData>(std::forward<VDArgs>(args)...);
-    add_existing_vertex(newv);
-    return newv->_idx;
+    return add_vertex(std::in_place_type<VertexData>, std::forward<VDArgs>(args)...);
   }
 
-  int emplace_pseudovertex(PseudoVertexType pt) {
-    Vertex* newv = new Vertex(size(), pt);
-    add_existing_vertex(newv);
-    return newv->_idx;
-  }
+  int emplace_pseudovertex(PseudoVertexType pt) { return add_vertex(pt); }
 
   template <typename... VDArgs>
     requires std::constructible_from<VertexData, VDArgs...>
   int substitute_pair(std::pair<int, int> vsub, VDArgs&&... args) {
-    Vertex* newv = new Vertex(size());
-    newv->_d.template emplace<VertexData>(std::forward<VDArgs>(args)...);
-    substitute_pair_existing(vsub, newv);
-    return newv->_idx;
+    const int new_idx = emplace_vertex(std::forward<VDArgs>(args)...);
+    substitute_pair_links(vsub, new_idx);
+    return new_idx;
+  }
+
+  // Collapses a single entry region into a new vertex, members.front() being the region's header. The new vertex takes
+  // the header's links from outside, edges back to the header become a self loop, and the links leaving the region
+  // are merged per target. Targets reached from more than one member are entered unconditionally
+  template <typename... VDArgs>
+    requires std::constructible_from<VertexData, VDArgs...>
+  int substitute_region(std::span<int const> members, VDArgs&&... args) {
+    RegionLinks links;
+    return substitute_region(members, links, std::forward<VDArgs>(args)...);
+  }
+
+  // Same as above, reusing links for the edge lists so collapsing one region after another doesn't allocate
+  template <typename... VDArgs>
+    requires std::constructible_from<VertexData, VDArgs...>
+  int substitute_region(std::span<int const> members, RegionLinks& links, VDArgs&&... args) {
+    const int new_idx = emplace_vertex(std::forward<VDArgs>(args)...);
+    substitute_region_links(members, new_idx, links);
+    return new_idx;
   }
 
   // Insert a new node between `before` and all of its outgoing links
   int insert_after(Vertex* before, VertexData&& vdata, BlockTransfer tr) {
+    const int before_idx = before->_idx;
     const int new_idx = emplace_vertex(std::move(vdata));
+    // Adding the vertex may have moved `before`
+    before = vertex(before_idx);
     Vertex* newv = vertex(new_idx);
     newv->_out = std::move(before->_out);
 
     // Fixup input links
     for (auto [target, ttr] : newv->_out) {
       Vertex* fixupv = vertex(target);
-      auto edge = std::find(fixupv->_in.begin(), fixupv->_in.end(), EdgeData(before->_idx, ttr));
+      auto edge = std::find(fixupv->_in.begin(), fixupv->_in.end(), EdgeData(before_idx, ttr));
       assert(edge != fixupv->_in.end());
-      edge->_target = newv->_idx;
+      edge->_target = new_idx;
     }
 
     emplace_link(before, newv, tr);
@@ -403,7 +588,7 @@ public:
 
   // Insert a new node between `before_idx` and all of its outgoing links
   int insert_after(int before_idx, VertexData const& vdata, BlockTransfer tr) {
-    return insert_after(vertex(before_idx), vdata, tr);
+    return insert_after(vertex(before_idx), VertexData(vdata), tr);
   }
 
   template <typename Visitor>
@@ -699,11 +884,22 @@ public:
   template <typename RhsVertexData, typename Generator>
     requires std::invocable<Generator, FlowVertex<RhsVertexData> const&, Vertex&>
   void copy_shape_generator(FlowGraph<RhsVertexData> const* from, Generator&& generator) {
+    // The source's root and terminal map onto this graph's own, everything else gets a fresh vertex
+    std::vector<int> backref(from->size(), kInvalidVertexId);
     for (FlowVertex<RhsVertexData> const& rhsv : *from) {
-      Vertex* v = vertex(emplace_pseudovertex(PseudoVertexType::kUninitialized));
-      v->_out = rhsv._out;
-      v->_in = rhsv._out;
-      generator(rhsv, *v);
+      if (rhsv._idx == from->root()->_idx) {
+        backref[rhsv._idx] = root()->_idx;
+      } else if (rhsv._idx == from->terminal()->_idx) {
+        backref[rhsv._idx] = terminal()->_idx;
+      } else {
+        backref[rhsv._idx] = emplace_pseudovertex(PseudoVertexType::kUninitialized);
+        generator(rhsv, *vertex(backref[rhsv._idx]));
+      }
+    }
+    for (FlowVertex<RhsVertexData> const& rhsv : *from) {
+      for (auto [target, tr] : rhsv._out) {
+        emplace_link(backref[rhsv._idx], backref[target], tr);
+      }
     }
   }
 
@@ -748,7 +944,4 @@ public:
     }
   }
 };
-
-// Checks for a given dominator tree: n dom m
-bool dominates(std::vector<int> dom_tree, int n, int m);
 }  // namespace decomp
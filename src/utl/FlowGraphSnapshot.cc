@@ -0,0 +1,158 @@
+#include "utl/FlowGraphSnapshot.hh"
+
+#include <algorithm>
+#include <numeric>
+
+#include "utl/DominatorTree.hh"
+#include "utl/LoopForest.hh"
+
+namespace decomp {
+FlowGraphSnapshot::FlowGraphSnapshot(FlowGraphBase const& graph)
+    : _root_id(graph.root()->_idx), _terminal_id(graph.terminal()->_idx) {
+  const size_t n = graph.size();
+  _succ_offsets.reserve(n + 1);
+  _pred_offsets.reserve(n + 1);
+  _flags.resize(n, SnapshotVertexFlags::kReal);
+
+  size_t num_succ = 0;
+  size_t num_pred = 0;
+  for (size_t i = 0; i < n; i++) {
+    num_succ += graph.vertex(i)->_out.size();
+    num_pred += graph.vertex(i)->_in.size();
+  }
+  _succ.reserve(num_succ);
+  _pred.reserve(num_pred);
+
+  for (size_t i = 0; i < n; i++) {
+    FlowVertexBase const* v = graph.vertex(i);
+    _succ_offsets.push_back(static_cast<uint32_t>(_succ.size()));
+    _succ.insert(_succ.end(), v->_out.begin(), v->_out.end());
+    _pred_offsets.push_back(static_cast<uint32_t>(_pred.size()));
+    _pred.insert(_pred.end(), v->_in.begin(), v->_in.end());
+    if (v->_detached) {
+      _flags[i] = _flags[i] | SnapshotVertexFlags::kDetached;
+    }
+  }
+  _succ_offsets.push_back(static_cast<uint32_t>(_succ.size()));
+  _pred_offsets.push_back(static_cast<uint32_t>(_pred.size()));
+
+  _flags[_root_id] = SnapshotVertexFlags::kPreheader;
+  _flags[_terminal_id] = SnapshotVertexFlags::kPostExit;
+  compute_orders();
+}
+
+void FlowGraphSnapshot::compute_orders() {
+  // Iterative DFS keeping the next edge to look at for every vertex on the path
+  std::vector<bool> visited(size());
+  std::vector<std::pair<int, uint32_t>> path;
+  _postorder.reserve(size());
+  path.emplace_back(_root_id, _succ_offsets[_root_id]);
+  visited[_root_id] = true;
+  while (!path.empty()) {
+    auto& [vert, next_edge] = path.back();
+    if (next_edge == _succ_offsets[vert + 1]) {
+      _postorder.push_back(vert);
+      path.pop_back();
+      continue;
+    }
+
+    const int target = _succ[next_edge++]._target;
+    if (!visited[target]) {
+      visited[target] = true;
+      path.emplace_back(target, _succ_offsets[target]);
+    }
+  }
+  _rpo.assign(_postorder.rbegin(), _postorder.rend());
+}
+
+namespace {
+// Depth first numbering of everything reachable from a start vertex, indexed by DFS number
+struct DfsTree {
+  std::vector<int> _vert;
+  std::vector<int> _parent;
+  // Graph vertex to DFS number, -1 when unreachable
+  std::vector<int> _num;
+};
+
+template <bool Forward>
+DfsTree number_vertices(FlowGraphSnapshot const& shape, int start) {
+  DfsTree tree;
+  tree._vert.reserve(shape.size());
+  tree._parent.reserve(shape.size());
+  tree._num.assign(shape.size(), -1);
+
+  std::vector<std::pair<int, uint32_t>> path;
+  tree._num[start] = 0;
+  tree._vert.push_back(start);
+  tree._parent.push_back(0);
+  path.emplace_back(start, 0);
+  while (!path.empty()) {
+    auto& [vert, next_edge] = path.back();
+    std::span<EdgeData const> out = shape.edges<Forward>(vert);
+    if (next_edge == out.size()) {
+      path.pop_back();
+      continue;
+    }
+
+    const int target = out[next_edge++]._target;
+    if (tree._num[target] == -1) {
+      tree._num[target] = static_cast<int>(tree._vert.size());
+      tree._parent.push_back(tree._num[vert]);
+      tree._vert.push_back(target);
+      path.emplace_back(target, 0);
+    }
+  }
+  return tree;
+}
+}  // namespace
+
+std::vector<int> FlowGraphSnapshot::compute_dom_tree() const { return semi_nca<true>(); }
+
+std::vector<int> FlowGraphSnapshot::compute_pdom_tree() const { return semi_nca<false>(); }
+
+LoopForest const& FlowGraphSnapshot::loops() const {
+  std::call_once(_loops->_once, [this] { _loops->_forest = std::make_shared<LoopForest const>(*this); });
+  return *_loops->_forest;
+}
+
+// Semi-NCA: semidominators the same way as Lengauer-Tarjan, then each idom is the nearest common ancestor of the
+// DFS parent and the semidominator, found by climbing the partially built dominator tree. The climb is quadratic in
+// theory but short on anything shaped like a CFG, and it beats Lengauer-Tarjan's bucket pass in flowgraph_bench
+template <bool PreDominator>
+std::vector<int> FlowGraphSnapshot::semi_nca() const {
+  const int start = PreDominator ? _root_id : _terminal_id;
+  const DfsTree tree = number_vertices<PreDominator>(*this, start);
+  const int nreached = static_cast<int>(tree._vert.size());
+
+  // Everything below works on DFS numbers
+  std::vector<int> semi(nreached);
+  std::iota(semi.begin(), semi.end(), 0);
+  detail::EvalForest forest(nreached, semi);
+  for (int w = nreached - 1; w > 0; w--) {
+    for (EdgeData const& ed : edges<!PreDominator>(tree._vert[w])) {
+      const int v = tree._num[ed._target];
+      // Skip unreachable predecessors
+      if (v != -1) {
+        semi[w] = std::min(semi[w], semi[forest.eval(v)]);
+      }
+    }
+    forest.link(tree._parent[w], w);
+  }
+
+  // Ancestors are final by the time a vertex is reached in preorder
+  std::vector<int> idom(tree._parent);
+  for (int w = 1; w < nreached; w++) {
+    while (idom[w] > semi[w]) {
+      idom[w] = idom[idom[w]];
+    }
+  }
+
+  // Vertices the DFS never reached are left at -1
+  std::vector<int> result(size(), -1);
+  for (int w = 0; w < nreached; w++) {
+    result[tree._vert[w]] = tree._vert[idom[w]];
+  }
+  return result;
+}
+
+}  // namespace decomp
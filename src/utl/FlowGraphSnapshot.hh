@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "utl/FlagsEnum.hh"
+#include "utl/FlowGraph.hh"
+
+namespace decomp {
+class LoopForest;
+
+enum class SnapshotVertexFlags : uint8_t {
+  kNone = 0,
+  kAll = 0b1111,
+
+  kReal = 1u << 0,
+  kDetached = 1u << 1,
+  kPreheader = 1u << 2,
+  kPostExit = 1u << 3,
+};
+GEN_FLAG_OPERATORS(SnapshotVertexFlags)
+
+// Read-only copy of a FlowGraph's shape in compressed sparse row form, for analyses that walk a finished graph many
+// times. The successors of v are _succ[_succ_offsets[v], _succ_offsets[v + 1]), in the same order as v->_out, and
+// predecessors follow the same layout. Vertex indices match the graph the snapshot was taken from
+class FlowGraphSnapshot {
+private:
+  std::vector<uint32_t> _succ_offsets;
+  std::vector<EdgeData> _succ;
+  std::vector<uint32_t> _pred_offsets;
+  std::vector<EdgeData> _pred;
+  std::vector<SnapshotVertexFlags> _flags;
+  // Vertices reachable from the root, real or not
+  std::vector<int> _postorder;
+  std::vector<int> _rpo;
+  int _root_id = FlowGraphBase::kInvalidVertexId;
+  int _terminal_id = FlowGraphBase::kInvalidVertexId;
+  // Built on first use by whichever thread asks first, nothing under it ever changes. Copies of a snapshot have the
+  // same shape, so they share it
+  struct LoopCache {
+    std::once_flag _once;
+    std::shared_ptr<LoopForest const> _forest;
+  };
+  std::shared_ptr<LoopCache> _loops = std::make_shared<LoopCache>();
+
+  template <bool PreDominator>
+  std::vector<int> semi_nca() const;
+
+  void compute_orders();
+
+public:
+  FlowGraphSnapshot() = default;
+  // Shape only, every vertex other than the root and terminal is taken to be real
+  explicit FlowGraphSnapshot(FlowGraphBase const& graph);
+  template <typename VertexData>
+  explicit FlowGraphSnapshot(FlowGraph<VertexData> const& graph)
+      : FlowGraphSnapshot(static_cast<FlowGraphBase const&>(graph)) {
+    for (size_t i = 0; i < graph.size(); i++) {
+      if (graph.vertex(i)->is_pseudo()) {
+        _flags[i] = _flags[i] & ~SnapshotVertexFlags::kReal;
+      }
+    }
+  }
+
+  size_t size() const { return _flags.size(); }
+  bool empty() const { return _flags.empty(); }
+  int root() const { return _root_id; }
+  int terminal() const { return _terminal_id; }
+
+  std::span<EdgeData const> successors(int v) const {
+    return {_succ.data() + _succ_offsets[v], _succ.data() + _succ_offsets[v + 1]};
+  }
+  std::span<EdgeData const> predecessors(int v) const {
+    return {_pred.data() + _pred_offsets[v], _pred.data() + _pred_offsets[v + 1]};
+  }
+  template <bool Forward>
+  std::span<EdgeData const> edges(int v) const {
+    return Forward ? successors(v) : predecessors(v);
+  }
+
+  SnapshotVertexFlags flags(int v) const { return _flags[v]; }
+  // Matches FlowGraph::foreach_real, detached vertices don't count
+  bool is_real(int v) const {
+    return (_flags[v] & (SnapshotVertexFlags::kReal | SnapshotVertexFlags::kDetached)) == SnapshotVertexFlags::kReal;
+  }
+  // Matches FlowGraph::is_exit_vertex
+  bool is_exit(int v) const {
+    std::span<EdgeData const> succ = successors(v);
+    return is_real(v) && succ.size() == 1 && succ[0]._target == _terminal_id;
+  }
+
+  // Depth first postorder from the root following successors in edge order, and its reverse
+  std::span<int const> postorder() const { return _postorder; }
+  std::span<int const> rpo() const { return _rpo; }
+
+  // Immediate dominators indexed by vertex, the start is its own idom and anything it can't reach is -1
+  std::vector<int> compute_dom_tree() const;
+  std::vector<int> compute_pdom_tree() const;
+  LoopForest const& loops() const;
+
+  template <typename Visitor>
+    requires std::invocable<Visitor, int>
+  void foreach_real(Visitor&& visitor) const {
+    for (size_t i = 0; i < size(); i++) {
+      if (is_real(i)) {
+        visitor(static_cast<int>(i));
+      }
+    }
+  }
+
+  // Same visiting order as FlowGraph::preorder
+  template <bool Forward, typename Visitor>
+    requires std::invocable<Visitor, int>
+  void preorder(Visitor&& visitor, int start) const {
+    std::vector<bool> visited(size());
+    std::vector<int> process_stack;
+    process_stack.push_back(start);
+
+    while (!process_stack.empty()) {
+      const int vert = process_stack.back();
+      process_stack.pop_back();
+
+      if (visited[vert]) {
+        continue;
+      }
+      visited[vert] = true;
+
+      visitor(vert);
+
+      for (EdgeData const& ed : edges<Forward>(vert)) {
+        if (!visited[ed._target]) {
+          process_stack.push_back(ed._target);
+        }
+      }
+    }
+  }
+
+  // Same visiting order as FlowGraph::preorder_pathacc
+  template <bool Forward, typename R, typename Visitor>
+    requires invocable_r<R, Visitor, int, R>
+  void preorder_pathacc(Visitor&& visitor, int start, R init) const {
+    std::vector<bool> visited(size());
+    std::vector<std::pair<int, R>> process_stack;
+    process_stack.emplace_back(start, init);
+
+    while (!process_stack.empty()) {
+      auto [vert, acc] = process_stack.back();
+      process_stack.pop_back();
+
+      if (visited[vert]) {
+        continue;
+      }
+      visited[vert] = true;
+
+      R feedforward = visitor(vert, acc);
+
+      for (EdgeData const& ed : edges<Forward>(vert)) {
+        if (!visited[ed._target]) {
+          process_stack.emplace_back(ed._target, feedforward);
+        }
+      }
+    }
+  }
+};
+}  // namespace decomp
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -189,6 +191,22 @@ class dinterval_tree {
     return const_cast<T*>(const_cast<dinterval_tree const*>(this)->query_min_node(low, high));
   }
 
+  // Balanced subtree over nodes[first, last), which are already in order
+  static interval_node* build_balanced(std::vector<interval_node*> const& nodes, size_t first, size_t last,
+    interval_node* parent) {
+    if (first == last) {
+      return nullptr;
+    }
+
+    const size_t mid = first + (last - first) / 2;
+    interval_node* node = nodes[mid];
+    node->_parent = parent;
+    node->_lp = build_balanced(nodes, first, mid, node);
+    node->_rp = build_balanced(nodes, mid + 1, last, node);
+    node->fix_cached_values();
+    return node;
+  }
+
 private:
   interval_node* _root = nullptr;
 
@@ -305,6 +323,30 @@ public:
     return true;
   }
 
+  struct sorted_entry {
+    IvType _lo, _hi;
+    T _val;
+  };
+
+  // Builds a tree from intervals sorted by lower bound that don't overlap, in linear time instead of one AVL insert
+  // per interval
+  static dinterval_tree from_sorted(std::vector<sorted_entry>&& entries) {
+    std::vector<interval_node*> nodes;
+    nodes.reserve(entries.size());
+    for (sorted_entry& entry : entries) {
+      assert(nodes.empty() || nodes.back()->_hi <= entry._lo);
+      nodes.push_back(new interval_node(entry._lo, entry._hi, std::move(entry._val), nullptr));
+      if (nodes.size() > 1) {
+        nodes[nodes.size() - 2]->_next = nodes.back();
+        nodes.back()->_prev = nodes[nodes.size() - 2];
+      }
+    }
+
+    dinterval_tree ret;
+    ret._root = build_balanced(nodes, 0, nodes.size(), nullptr);
+    return ret;
+  }
+
   dinterval_tree() : _root(nullptr) {}
 
   dinterval_tree(dinterval_tree const&) = delete;
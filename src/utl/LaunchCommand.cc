@@ -228,6 +228,7 @@ std::optional<std::string> CommandParamList::parse_argv(char** argv) {
         if (fail_reason) {
           return fmt::format("Failed to parse option '{}', Reason: {}", desc->_opt, *fail_reason);
         }
+        parse_mode = Header;
         break;
       }
 
@@ -245,6 +246,7 @@ std::optional<std::string> CommandParamList::parse_argv(char** argv) {
         if (fail_reason) {
           return fmt::format("Failed to parse option '{}', Reason: {}", desc->_shortopt, *fail_reason);
         }
+        parse_mode = Header;
         break;
       }
     }
@@ -0,0 +1,253 @@
+#include "utl/LoopForest.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+#include "utl/FlowGraphSnapshot.hh"
+
+namespace decomp {
+namespace {
+// Union-find over preorder numbers, a set is named by the header everything in it has been folded into
+class HeaderSets {
+private:
+  std::vector<int> _parent;
+
+public:
+  explicit HeaderSets(size_t len) : _parent(len) { std::iota(_parent.begin(), _parent.end(), 0); }
+
+  int find(int v) {
+    int root = v;
+    while (_parent[root] != root) {
+      root = _parent[root];
+    }
+    while (_parent[v] != root) {
+      const int next = _parent[v];
+      _parent[v] = root;
+      v = next;
+    }
+    return root;
+  }
+
+  // rep has to name its set
+  void fold(int rep, int header) { _parent[rep] = header; }
+};
+}  // namespace
+
+LoopForest::LoopForest(FlowGraphSnapshot const& shape) {
+  grow(shape.size());
+
+  // Preorder numbers and the last preorder number under each vertex, making ancestry a range check
+  std::vector<int> pre(shape.size(), -1);
+  std::vector<int> vert;
+  std::vector<int> last(shape.size());
+  std::vector<std::pair<int, uint32_t>> path;
+  pre[shape.root()] = 0;
+  vert.push_back(shape.root());
+  path.emplace_back(shape.root(), 0);
+  while (!path.empty()) {
+    auto& [v, next_edge] = path.back();
+    std::span<EdgeData const> out = shape.successors(v);
+    if (next_edge == out.size()) {
+      last[pre[v]] = static_cast<int>(vert.size()) - 1;
+      path.pop_back();
+      continue;
+    }
+
+    const int target = out[next_edge++]._target;
+    if (pre[target] == -1) {
+      pre[target] = static_cast<int>(vert.size());
+      vert.push_back(target);
+      path.emplace_back(target, 0);
+    }
+  }
+  const int nreached = static_cast<int>(vert.size());
+  const auto is_ancestor = [&last](int w, int v) { return w <= v && v <= last[w]; };
+
+  // Everything below works on preorder numbers. A predecessor edge into w is a back edge when it comes from under w
+  // in the DFS tree, edges from vertices the root can't reach are dropped. Edges Ramalingam's correction carries up to
+  // an irreducible header are kept in a list per header on the side
+  std::vector<int> carried_head(nreached, -1);
+  std::vector<std::pair<int, int>> carried;
+
+  // Innermost loops are found first, so a loop's id is always smaller than its parent's
+  HeaderSets sets(nreached);
+  std::vector<int> loop_of(nreached, -1);
+  std::vector<int> headed_by(nreached, -1);
+  std::vector<bool> in_body(nreached);
+  std::vector<int> body;
+  std::vector<int> worklist;
+  for (int w = nreached - 1; w >= 0; w--) {
+    body.clear();
+    bool self_loop = false;
+    for (EdgeData const& ed : shape.predecessors(vert[w])) {
+      const int v = pre[ed._target];
+      if (v == -1 || !is_ancestor(w, v)) {
+        continue;
+      }
+      if (v == w) {
+        self_loop = true;
+        continue;
+      }
+      const int rep = sets.find(v);
+      if (!in_body[rep]) {
+        in_body[rep] = true;
+        body.push_back(rep);
+      }
+    }
+
+    bool reducible = true;
+    const auto visit_pred = [&](int y) {
+      const int rep = sets.find(y);
+      if (!is_ancestor(w, rep)) {
+        // Entered around w, so the loop is irreducible. The folded edge is handed to w so loops enclosing this one
+        // still see it without rescanning the body
+        reducible = false;
+        carried.emplace_back(rep, carried_head[w]);
+        carried_head[w] = static_cast<int>(carried.size()) - 1;
+      } else if (rep != w && !in_body[rep]) {
+        in_body[rep] = true;
+        body.push_back(rep);
+        worklist.push_back(rep);
+      }
+    };
+    worklist.assign(body.begin(), body.end());
+    while (!worklist.empty()) {
+      const int x = worklist.back();
+      worklist.pop_back();
+      for (EdgeData const& ed : shape.predecessors(vert[x])) {
+        const int y = pre[ed._target];
+        if (y != -1 && !is_ancestor(x, y)) {
+          visit_pred(y);
+        }
+      }
+      for (int e = carried_head[x]; e != -1; e = carried[e].second) {
+        visit_pred(carried[e].first);
+      }
+    }
+
+    if (body.empty() && !self_loop) {
+      continue;
+    }
+    const int id = static_cast<int>(_loops.size());
+    _loops.push_back(Loop{
+      ._header = vert[w],
+      ._parent = -1,
+      ._depth = 0,
+      ._reducible = reducible,
+      ._blocks = {},
+      ._children = {},
+      ._entries = {},
+    });
+    headed_by[w] = id;
+    loop_of[w] = id;
+    for (int x : body) {
+      in_body[x] = false;
+      if (headed_by[x] != -1) {
+        _loops[headed_by[x]]._parent = id;
+      } else {
+        loop_of[x] = id;
+      }
+      sets.fold(x, w);
+    }
+  }
+
+  for (int id = static_cast<int>(_loops.size()) - 1; id >= 0; id--) {
+    Loop& loop = _loops[id];
+    loop._blocks.push_back(loop._header);
+    if (loop._parent == -1) {
+      loop._depth = 1;
+      _top_level.push_back(id);
+    } else {
+      loop._depth = _loops[loop._parent]._depth + 1;
+      _loops[loop._parent]._children.push_back(id);
+    }
+  }
+  for (int w = 0; w < nreached; w++) {
+    _loop_of[vert[w]] = loop_of[w];
+    _headed_by[vert[w]] = headed_by[w];
+    if (loop_of[w] != -1 && headed_by[w] != loop_of[w]) {
+      _loops[loop_of[w]]._blocks.push_back(vert[w]);
+    }
+  }
+
+  // Any edge coming from outside a loop into something other than its header is another entry
+  if (std::all_of(_loops.begin(), _loops.end(), [](Loop const& loop) { return loop._reducible; })) {
+    return;
+  }
+  for (int w = 0; w < nreached; w++) {
+    const int v = vert[w];
+    for (EdgeData const& ed : shape.predecessors(v)) {
+      if (pre[ed._target] == -1) {
+        continue;
+      }
+      for (int l = _loop_of[v]; l != -1 && !contains(l, ed._target); l = _loops[l]._parent) {
+        std::vector<int>& entries = _loops[l]._entries;
+        if (v != _loops[l]._header && std::find(entries.begin(), entries.end(), v) == entries.end()) {
+          entries.push_back(v);
+        }
+      }
+    }
+  }
+}
+
+LoopForest LoopForest::compute(FlowGraphBase const& graph) { return LoopForest(FlowGraphSnapshot(graph)); }
+
+void LoopForest::grow(size_t size) {
+  if (size > _loop_of.size()) {
+    _loop_of.resize(size, -1);
+    _headed_by.resize(size, -1);
+  }
+}
+
+std::vector<int> LoopForest::body(int id) const {
+  std::vector<int> result;
+  std::vector<int> pending{id};
+  while (!pending.empty()) {
+    Loop const& loop = _loops[pending.back()];
+    pending.pop_back();
+    result.insert(result.end(), loop._blocks.begin(), loop._blocks.end());
+    pending.insert(pending.end(), loop._children.begin(), loop._children.end());
+  }
+  return result;
+}
+
+std::vector<int> LoopForest::exits(FlowGraphBase const& graph, int id) const {
+  std::vector<int> result;
+  for (int v : body(id)) {
+    for (EdgeData const& ed : graph.vertex(v)->_out) {
+      if (!contains(id, ed._target) && std::find(result.begin(), result.end(), ed._target) == result.end()) {
+        result.push_back(ed._target);
+      }
+    }
+  }
+  return result;
+}
+
+void LoopForest::collapse(std::span<int const> members, int header, int repl) {
+  grow(repl + 1);
+  _loop_of[repl] = _loop_of[header];
+
+  // The replacement takes the header's place, every other member drops out of whichever loop held it
+  for (int m : members) {
+    if (_loop_of[m] == -1) {
+      continue;
+    }
+    Loop& loop = _loops[_loop_of[m]];
+    for (std::vector<int>* list : {&loop._blocks, &loop._entries}) {
+      if (m == header) {
+        std::replace(list->begin(), list->end(), m, repl);
+      } else {
+        list->erase(std::remove(list->begin(), list->end(), m), list->end());
+      }
+    }
+    _loop_of[m] = -1;
+  }
+
+  if (_headed_by[header] != -1) {
+    _loops[_headed_by[header]]._header = repl;
+    _headed_by[repl] = _headed_by[header];
+    _headed_by[header] = -1;
+  }
+}
+}  // namespace decomp
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "utl/FlowGraph.hh"
+
+namespace decomp {
+class FlowGraphSnapshot;
+
+// Loop nesting forest of a FlowGraph, found with Havlak's algorithm using Ramalingam's correction so irreducible
+// loops cost near-linear time too. Every loop is identified by the first of its vertices a depth first search from the
+// root reaches, which for a reducible loop is the header dominating it. Irreducible loops also list their other entries
+class LoopForest {
+public:
+  struct Loop {
+    int _header;
+    // Enclosing loop, -1 for outermost loops
+    int _parent;
+    // 1 for outermost loops
+    int _depth;
+    bool _reducible;
+    // Vertices whose innermost loop is this one, header first
+    std::vector<int> _blocks;
+    std::vector<int> _children;
+    // Vertices other than the header that are entered from outside the loop, empty when reducible
+    std::vector<int> _entries;
+  };
+
+private:
+  std::vector<Loop> _loops;
+  // Innermost loop of each vertex, -1 outside every loop
+  std::vector<int> _loop_of;
+  // Loop headed by each vertex, -1 if it isn't a header
+  std::vector<int> _headed_by;
+  std::vector<int> _top_level;
+
+  void grow(size_t size);
+
+public:
+  LoopForest() = default;
+  explicit LoopForest(FlowGraphSnapshot const& shape);
+  static LoopForest compute(FlowGraphBase const& graph);
+
+  size_t num_loops() const { return _loops.size(); }
+  Loop const& loop(int id) const { return _loops[id]; }
+  std::span<int const> top_level() const { return _top_level; }
+
+  int loop_of(int v) const { return static_cast<size_t>(v) < _loop_of.size() ? _loop_of[v] : -1; }
+  int headed_by(int v) const { return static_cast<size_t>(v) < _headed_by.size() ? _headed_by[v] : -1; }
+  bool is_header(int v) const { return headed_by(v) != -1; }
+  // Number of loops around v, 0 outside every loop
+  int depth(int v) const { return loop_of(v) == -1 ? 0 : _loops[loop_of(v)]._depth; }
+  // Whether v is in the loop or any loop nested inside it
+  bool contains(int id, int v) const {
+    for (int l = loop_of(v); l != -1 && _loops[l]._depth >= _loops[id]._depth; l = _loops[l]._parent) {
+      if (l == id) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Every vertex of the loop including nested loops, header first
+  std::vector<int> body(int id) const;
+  // Distinct vertices outside the loop that an edge leaves it for
+  std::vector<int> exits(FlowGraphBase const& graph, int id) const;
+
+  // Call after members have been replaced in the graph by repl, same contract as DominatorTree::collapse. Members other
+  // than header may not head loops of their own, which holds for every acyclic region the structurizer collapses
+  void collapse(std::span<int const> members, int header, int repl);
+};
+}  // namespace decomp
@@ -0,0 +1,114 @@
+#include "utl/MappedFile.hh"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace decomp {
+ErrorOr<MappedFile> MappedFile::open(std::string const& path) {
+  MappedFile ret;
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(
+    path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return "Failed to open file";
+  }
+  ret._file_handle = file;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    return "Failed to query file size";
+  }
+  if (file_size.QuadPart == 0) {
+    return "File is empty";
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    return "Failed to create file mapping";
+  }
+  ret._map_handle = mapping;
+
+  void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (base == nullptr) {
+    return "Failed to map file";
+  }
+  ret._base = static_cast<uint8_t const*>(base);
+  ret._size = static_cast<size_t>(file_size.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return "Failed to open file";
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return "Failed to query file size";
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return "File is empty";
+  }
+
+  void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping holds its own reference to the file
+  close(fd);
+  if (base == MAP_FAILED) {
+    return "Failed to map file";
+  }
+  ret._base = static_cast<uint8_t const*>(base);
+  ret._size = static_cast<size_t>(st.st_size);
+#endif
+
+  return ret;
+}
+
+MappedFile::MappedFile(MappedFile&& rhs) { *this = std::move(rhs); }
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) {
+  if (this == &rhs) {
+    return *this;
+  }
+
+  unmap();
+  _base = std::exchange(rhs._base, nullptr);
+  _size = std::exchange(rhs._size, 0);
+#if defined(_WIN32)
+  _file_handle = std::exchange(rhs._file_handle, nullptr);
+  _map_handle = std::exchange(rhs._map_handle, nullptr);
+#endif
+  return *this;
+}
+
+void MappedFile::unmap() {
+#if defined(_WIN32)
+  if (_base != nullptr) {
+    UnmapViewOfFile(_base);
+  }
+  if (_map_handle != nullptr) {
+    CloseHandle(_map_handle);
+  }
+  if (_file_handle != nullptr) {
+    CloseHandle(_file_handle);
+  }
+  _file_handle = nullptr;
+  _map_handle = nullptr;
+#else
+  if (_base != nullptr) {
+    munmap(const_cast<uint8_t*>(_base), _size);
+  }
+#endif
+  _base = nullptr;
+  _size = 0;
+}
+}  // namespace decomp
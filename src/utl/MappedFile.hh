@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "utl/Either.hh"
+
+namespace decomp {
+// Read-only memory mapping of a whole file
+// Nothing is read up front, pages are faulted in by the OS the first time they are touched
+class MappedFile {
+private:
+  uint8_t const* _base = nullptr;
+  size_t _size = 0;
+#if defined(_WIN32)
+  void* _file_handle = nullptr;
+  void* _map_handle = nullptr;
+#endif
+
+  MappedFile() {}
+  void unmap();
+
+public:
+  static ErrorOr<MappedFile> open(std::string const& path);
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&& rhs);
+  MappedFile& operator=(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile&& rhs);
+  ~MappedFile() { unmap(); }
+
+  uint8_t const* data() const { return _base; }
+  size_t size() const { return _size; }
+
+  // Bounds checked view into the file, empty if [off, off + len) isn't fully contained in the file
+  std::span<uint8_t const> view(size_t off, size_t len) const {
+    if (off > _size || len > _size - off) {
+      return {};
+    }
+    return {_base + off, len};
+  }
+};
+}  // namespace decomp
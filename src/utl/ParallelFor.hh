@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace decomp {
+namespace detail {
+// Remaining index range of one worker. The owner takes from the front, thieves split off the back half
+struct alignas(64) StealableRange {
+  std::mutex _lock;
+  size_t _begin = 0;
+  size_t _end = 0;
+
+  bool pop_front(size_t& idx) {
+    std::lock_guard guard(_lock);
+    if (_begin == _end) {
+      return false;
+    }
+    idx = _begin++;
+    return true;
+  }
+
+  bool steal_back(size_t& begin, size_t& end) {
+    std::lock_guard guard(_lock);
+    const size_t remaining = _end - _begin;
+    if (remaining == 0) {
+      return false;
+    }
+    end = _end;
+    _end -= (remaining + 1) / 2;
+    begin = _end;
+    return true;
+  }
+};
+}  // namespace detail
+
+inline size_t resolve_thread_count(size_t num_threads) {
+  return num_threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : num_threads;
+}
+
+// Calls fn(i) for every i in [0, count) across num_threads workers (0 picks the hardware thread count), returning once
+// all calls are done. Each worker starts on an even share of the range and steals half of another worker's remainder
+// when it runs out, so uneven per-index costs still balance. The calling thread is one of the workers
+template <typename Fn>
+void parallel_for(size_t count, size_t num_threads, Fn&& fn) {
+  num_threads = std::min(resolve_thread_count(num_threads), std::max<size_t>(count, 1));
+  if (num_threads == 1) {
+    for (size_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::vector<detail::StealableRange> ranges(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    ranges[i]._begin = count * i / num_threads;
+    ranges[i]._end = count * (i + 1) / num_threads;
+  }
+
+  auto worker = [&ranges, &fn, num_threads](size_t self) {
+    detail::StealableRange& own = ranges[self];
+    for (;;) {
+      size_t idx;
+      while (own.pop_front(idx)) {
+        fn(idx);
+      }
+
+      // Work is never added back, so one fruitless pass over every other worker means everything is claimed
+      bool stole = false;
+      for (size_t i = 1; i < num_threads && !stole; i++) {
+        size_t begin, end;
+        if (ranges[(self + i) % num_threads].steal_back(begin, end)) {
+          std::lock_guard guard(own._lock);
+          own._begin = begin;
+          own._end = end;
+          stole = true;
+        }
+      }
+      if (!stole) {
+        return;
+      }
+    }
+  };
+
+  std::vector<std::jthread> workers;
+  workers.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; i++) {
+    workers.emplace_back(worker, i);
+  }
+  worker(0);
+}
+}  // namespace decomp
@@ -1,6 +1,7 @@
 #include "utl/PatternScan.hh"
 
 #include <cctype>
+#include <span>
 #include <vector>
 
 #include "producers/DolData.hh"
@@ -34,7 +35,7 @@ CompiledPattern compile_pattern(std::string_view pattern) {
   return ret;
 }
 
-std::optional<uint32_t> pattern_scan_linear(std::vector<uint8_t> const& raw_data, CompiledPattern const& cpat) {
+std::optional<uint32_t> pattern_scan_linear(std::span<uint8_t const> raw_data, CompiledPattern const& cpat) {
   for (size_t i = 0; (i + cpat.size()) <= raw_data.size(); i++) {
     bool found = true;
     for (size_t j = 0; j < cpat.size(); j++) {
@@ -61,14 +62,9 @@ std::optional<uint32_t> pattern_scan_code(DolData const& data, std::string_view
   CompiledPattern cpat = compile_pattern(pattern);
 
   for (decomp::DolSection const& dol_sect : data.text_section_headers()) {
-    decomp::Section const* sect = data.section_for_vaddr(dol_sect._vaddr);
-    if (sect == nullptr) {
-      continue;
-    }
-
-    std::optional<uint32_t> found_addr = pattern_scan_linear(sect->_data, cpat);
+    std::optional<uint32_t> found_addr = pattern_scan_linear(data.read_span(dol_sect._vaddr, dol_sect._size), cpat);
     if (found_addr) {
-      return *found_addr + sect->_base;
+      return *found_addr + dol_sect._vaddr;
     }
   }
 
@@ -79,14 +75,9 @@ std::optional<uint32_t> pattern_scan_code(ElfData const& data, std::string_view
   CompiledPattern cpat = compile_pattern(pattern);
 
   for (decomp::ElfSection const& elf_sect : data.text_section_headers()) {
-    decomp::Section const* sect = data.section_for_vaddr(elf_sect._vaddr);
-    if (sect == nullptr) {
-      continue;
-    }
-
-    std::optional<uint32_t> found_addr = pattern_scan_linear(sect->_data, cpat);
+    std::optional<uint32_t> found_addr = pattern_scan_linear(data.read_span(elf_sect._vaddr, elf_sect._size), cpat);
     if (found_addr) {
-      return *found_addr + sect->_base;
+      return *found_addr + elf_sect._vaddr;
     }
   }
 
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace decomp {
+// Postorder of a FlowGraph kept as a doubly linked list keyed by vertex index, so it can follow region collapses
+// without being rebuilt. Each vertex carries the rank it was listed with, a replacement inherits the rank of the
+// vertex whose slot it takes and removal leaves gaps, so comparing ranks orders any two listed vertices in O(1)
+class PostorderList {
+  std::vector<int> _next;
+  std::vector<int> _prev;
+  // -1 for vertices not in the list
+  std::vector<int64_t> _rank;
+  int _head = -1;
+  int _tail = -1;
+
+  void grow(size_t size) {
+    if (size > _rank.size()) {
+      _next.resize(size, -1);
+      _prev.resize(size, -1);
+      _rank.resize(size, -1);
+    }
+  }
+
+public:
+  PostorderList() = default;
+  // order lists vertex indices in postorder, capacity sizes the tables up front for the vertices collapses will add
+  PostorderList(std::span<int const> order, size_t capacity) {
+    grow(capacity);
+    for (int v : order) {
+      grow(v + 1);
+      _rank[v] = _tail == -1 ? 0 : _rank[_tail] + 1;
+      _prev[v] = _tail;
+      (_tail == -1 ? _head : _next[_tail]) = v;
+      _tail = v;
+    }
+  }
+
+  int first() const { return _head; }
+  // -1 past the last vertex
+  int next(int v) const { return _next[v]; }
+  bool contains(int v) const { return static_cast<size_t>(v) < _rank.size() && _rank[v] != -1; }
+  // Whether a comes before b, both have to be listed
+  bool precedes(int a, int b) const { return _rank[a] < _rank[b]; }
+
+  // repl takes v's place and v leaves the list
+  void replace(int v, int repl) {
+    grow(repl + 1);
+    _rank[repl] = _rank[v];
+    _prev[repl] = _prev[v];
+    _next[repl] = _next[v];
+    (_prev[v] == -1 ? _head : _next[_prev[v]]) = repl;
+    (_next[v] == -1 ? _tail : _prev[_next[v]]) = repl;
+    _rank[v] = -1;
+  }
+
+  void erase(int v) {
+    (_prev[v] == -1 ? _head : _next[_prev[v]]) = _next[v];
+    (_next[v] == -1 ? _tail : _prev[_next[v]]) = _prev[v];
+    _rank[v] = -1;
+  }
+};
+}  // namespace decomp
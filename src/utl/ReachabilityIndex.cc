@@ -0,0 +1,160 @@
+#include "utl/ReachabilityIndex.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace decomp {
+namespace {
+// Postorder over every vertex, starting from the root and then from whatever it couldn't reach. Reverse walks each
+// vertex's successors back to front, which gives the second labeling a different shape
+std::vector<int> full_postorder(FlowGraphBase const& graph, bool reverse) {
+  std::vector<int> order;
+  order.reserve(graph.size());
+  std::vector<bool> visited(graph.size());
+  std::vector<std::pair<int, uint32_t>> path;
+  const auto walk_from = [&](int start) {
+    visited[start] = true;
+    path.emplace_back(start, 0);
+    while (!path.empty()) {
+      auto& [v, next_edge] = path.back();
+      EdgeList const& out = graph.vertex(v)->_out;
+      if (next_edge == out.size()) {
+        order.push_back(v);
+        path.pop_back();
+        continue;
+      }
+
+      const int target = out[reverse ? out.size() - 1 - next_edge++ : next_edge++]._target;
+      if (!visited[target]) {
+        visited[target] = true;
+        path.emplace_back(target, 0);
+      }
+    }
+  };
+
+  walk_from(graph.root()->_idx);
+  for (size_t v = 0; v < graph.size(); v++) {
+    if (!visited[v]) {
+      walk_from(static_cast<int>(v));
+    }
+  }
+  return order;
+}
+}  // namespace
+
+ReachabilityIndex::ReachabilityIndex(FlowGraphBase const& graph) : _stamp(graph.size(), 0) {
+  if (graph.size() <= kMatrixLimit) {
+    build_matrix(graph);
+  } else {
+    build_labels(graph);
+  }
+}
+
+void ReachabilityIndex::build_matrix(FlowGraphBase const& graph) {
+  _matrix = true;
+  _capacity = std::max<size_t>(2 * graph.size(), 64);
+  _words = (_capacity + 63) / 64;
+  _bits.assign(_capacity * _words, 0);
+
+  // Successors first so most rows are final after one sweep, cycles take another sweep per level of nesting
+  const std::vector<int> order = full_postorder(graph, false);
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (int v : order) {
+      uint64_t* row = &_bits[v * _words];
+      for (EdgeData const& ed : graph.vertex(v)->_out) {
+        uint64_t const* succ_row = &_bits[ed._target * _words];
+        for (size_t w = 0; w < _words; w++) {
+          const uint64_t merged = row[w] | succ_row[w];
+          changed |= merged != row[w];
+          row[w] = merged;
+        }
+        if (!test(v, ed._target)) {
+          set(v, ed._target);
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+void ReachabilityIndex::build_labels(FlowGraphBase const& graph) {
+  _matrix = false;
+  _labels.resize(graph.size());
+  for (int k = 0; k < kNumLabelings; k++) {
+    const std::vector<int> order = full_postorder(graph, k % 2 == 1);
+    for (size_t rank = 0; rank < order.size(); rank++) {
+      _labels[order[rank]][k] = Interval{static_cast<int>(rank), static_cast<int>(rank)};
+    }
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (int v : order) {
+        Interval& label = _labels[v][k];
+        for (EdgeData const& ed : graph.vertex(v)->_out) {
+          Interval const& succ = _labels[ed._target][k];
+          if (succ._low < label._low || succ._high > label._high) {
+            label._low = std::min(label._low, succ._low);
+            label._high = std::max(label._high, succ._high);
+            changed = true;
+          }
+        }
+      }
+    }
+  }
+}
+
+uint32_t ReachabilityIndex::next_epoch() {
+  if (++_epoch == 0) {
+    std::fill(_stamp.begin(), _stamp.end(), 0);
+    _epoch = 1;
+  }
+  return _epoch;
+}
+
+bool ReachabilityIndex::search(FlowGraphBase const& graph, int from, int to) {
+  const uint32_t epoch = next_epoch();
+  _pending.clear();
+  for (EdgeData const& ed : graph.vertex(from)->_out) {
+    _pending.push_back(ed._target);
+  }
+  while (!_pending.empty()) {
+    const int v = _pending.back();
+    _pending.pop_back();
+    if (v == to) {
+      return true;
+    }
+    if (_stamp[v] == epoch || !labels_allow(v, to)) {
+      continue;
+    }
+    _stamp[v] = epoch;
+    for (EdgeData const& ed : graph.vertex(v)->_out) {
+      _pending.push_back(ed._target);
+    }
+  }
+  return false;
+}
+
+void ReachabilityIndex::collapse(FlowGraphBase const& graph, int header, int repl) {
+  if (_matrix && static_cast<size_t>(repl) >= _capacity) {
+    *this = ReachabilityIndex(graph);
+    return;
+  }
+  _stamp.resize(graph.size(), 0);
+
+  if (!_matrix) {
+    _labels.resize(graph.size());
+    _labels[repl] = _labels[header];
+    return;
+  }
+
+  std::copy_n(&_bits[header * _words], _words, &_bits[repl * _words]);
+  if (test(header, header)) {
+    set(repl, repl);
+  }
+  for (size_t v = 0; v < graph.size(); v++) {
+    if (test(v, header)) {
+      set(v, repl);
+    }
+  }
+}
+}  // namespace decomp
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "utl/FlowGraph.hh"
+
+namespace decomp {
+// Answers whether a path leads from one vertex of a FlowGraph to another. Graphs up to kMatrixLimit vertices keep the
+// whole transitive closure as a bit matrix, so a query is one bit test. Larger graphs keep interval labels from a few
+// depth first orders, which rule out most pairs without looking at the graph, and search whatever they can't decide
+class ReachabilityIndex {
+public:
+  static constexpr size_t kMatrixLimit = 1024;
+  static constexpr int kNumLabelings = 2;
+
+private:
+  // Lowest and highest postorder rank of anything reachable from a vertex, itself included. If u reaches v then v's
+  // interval sits inside u's
+  struct Interval {
+    int _low;
+    int _high;
+  };
+
+  bool _matrix = false;
+  // Rows set aside for the matrix, collapses add vertices until it runs out and the index is rebuilt
+  size_t _capacity = 0;
+  size_t _words = 0;
+  std::vector<uint64_t> _bits;
+  std::vector<std::array<Interval, kNumLabelings>> _labels;
+  // Scratch space for searches, a vertex is visited when its stamp matches _epoch
+  std::vector<uint32_t> _stamp;
+  uint32_t _epoch = 0;
+  std::vector<int> _pending;
+
+  bool test(int from, int to) const { return (_bits[from * _words + to / 64] >> (to % 64)) & 1; }
+  void set(int from, int to) { _bits[from * _words + to / 64] |= uint64_t(1) << (to % 64); }
+  bool labels_allow(int from, int to) const {
+    for (int k = 0; k < kNumLabelings; k++) {
+      if (_labels[to][k]._low < _labels[from][k]._low || _labels[to][k]._high > _labels[from][k]._high) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void build_matrix(FlowGraphBase const& graph);
+  void build_labels(FlowGraphBase const& graph);
+  uint32_t next_epoch();
+  bool search(FlowGraphBase const& graph, int from, int to);
+
+public:
+  ReachabilityIndex() = default;
+  explicit ReachabilityIndex(FlowGraphBase const& graph);
+
+  bool uses_matrix() const { return _matrix; }
+
+  // Whether a path of at least one edge leads from `from` to `to`, a vertex only reaches itself around a cycle
+  bool reaches(FlowGraphBase const& graph, int from, int to) {
+    if (_matrix) {
+      return test(from, to);
+    }
+    return labels_allow(from, to) && search(graph, from, to);
+  }
+
+  // Call after a region has been replaced in the graph by repl, same contract as DominatorTree::collapse. Everything
+  // reaching the region reaches it through header, and header reaches all of it, so repl simply inherits header's
+  // answers. Other edge changes aren't tracked, the index has to be rebuilt for those
+  void collapse(FlowGraphBase const& graph, int header, int repl);
+};
+}  // namespace decomp
@@ -0,0 +1,279 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "AnalysisPipeline.hh"
+#include "ppc/BinaryContext.hh"
+#include "ppc/LivenessCursor.hh"
+#include "utl/ParallelFor.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+
+constexpr uint32_t dform(uint32_t op, uint32_t rd, uint32_t ra, int16_t simm) {
+  return (op << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t xo31(uint32_t rd, uint32_t ra, uint32_t rb, uint32_t xo) {
+  return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (xo << 1);
+}
+constexpr uint32_t xo63(uint32_t frd, uint32_t fra, uint32_t frb, uint32_t xo) {
+  return (63 << 26) | (frd << 21) | (fra << 16) | (frb << 11) | (xo << 1);
+}
+constexpr uint32_t cmpwi(uint32_t crf, uint32_t ra, int16_t simm) { return dform(11, crf << 2, ra, simm); }
+constexpr uint32_t bc(uint32_t bo, uint32_t bi, int32_t rel) {
+  return (16 << 26) | (bo << 21) | (bi << 16) | (static_cast<uint32_t>(rel) & 0xfffc);
+}
+constexpr uint32_t b(int32_t rel, bool link) { return (18 << 26) | (static_cast<uint32_t>(rel) & 0x3fffffc) | link; }
+
+void push_be(std::vector<char>& out, uint32_t word) {
+  out.push_back(static_cast<char>(word >> 24));
+  out.push_back(static_cast<char>(word >> 16));
+  out.push_back(static_cast<char>(word >> 8));
+  out.push_back(static_cast<char>(word));
+}
+
+// Functions with a standard frame setup/teardown around a random body of arithmetic, stack traffic, forward and
+// backward conditional branches and calls to other functions. Sizes vary a lot so work is uneven between functions
+std::vector<char> make_program(uint32_t num_functions, std::vector<uint32_t>& starts) {
+  std::mt19937 rng(1234);
+  auto pick = [&rng](uint32_t n) { return static_cast<uint32_t>(rng() % n); };
+  constexpr uint32_t kGprs[] = {0, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 29, 30, 31};
+  auto gpr = [&pick, &kGprs]() { return kGprs[pick(std::size(kGprs))]; };
+
+  std::vector<uint32_t> body_lens;
+  uint32_t va = kProgramBase;
+  for (uint32_t fn = 0; fn < num_functions; fn++) {
+    starts.push_back(va);
+    body_lens.push_back(4 + pick(fn % 7 == 0 ? 400 : 40));
+    va += 4 * (3 + body_lens.back() + 4);
+  }
+
+  std::vector<char> code;
+  for (uint32_t fn = 0; fn < num_functions; fn++) {
+    // stwu r1, -0x40(r1); mflr r0; stw r0, 0x44(r1)
+    push_be(code, dform(37, 1, 1, -0x40));
+    push_be(code, 0x7c0802a6);
+    push_be(code, dform(36, 0, 1, 0x44));
+
+    const uint32_t body_start = starts[fn] + 12;
+    const uint32_t body_end = body_start + 4 * body_lens[fn];
+    for (uint32_t i = 0; i < body_lens[fn]; i++) {
+      const uint32_t inst_va = body_start + 4 * i;
+      const uint32_t kind = pick(20);
+      if (kind < 4) {
+        push_be(code, dform(14, gpr(), gpr(), static_cast<int16_t>(pick(128)) - 64));
+      } else if (kind < 7) {
+        push_be(code, xo31(gpr(), gpr(), gpr(), 266));
+      } else if (kind < 10) {
+        push_be(code, dform(32, gpr(), 1, static_cast<int16_t>(8 + 4 * pick(8))));
+      } else if (kind < 12) {
+        push_be(code, dform(36, gpr(), 1, static_cast<int16_t>(8 + 4 * pick(8))));
+      } else if (kind < 13) {
+        push_be(code, dform(48, pick(14), 1, static_cast<int16_t>(8 + 8 * pick(4))));
+      } else if (kind < 15) {
+        push_be(code, cmpwi(pick(8), gpr(), static_cast<int16_t>(pick(16))));
+      } else if (kind < 18) {
+        const bool backward = pick(4) == 0 && i > 0;
+        const uint32_t target = backward ? body_start + 4 * pick(i) : inst_va + 4 + 4 * pick((body_end - inst_va) / 4);
+        push_be(code, bc(pick(2) == 0 ? 12 : 4, pick(32), static_cast<int32_t>(target - inst_va)));
+      } else {
+        push_be(code, b(static_cast<int32_t>(starts[pick(num_functions)] - inst_va), true));
+      }
+    }
+
+    // lwz r0, 0x44(r1); mtlr r0; addi r1, r1, 0x40; blr
+    push_be(code, dform(32, 0, 1, 0x44));
+    push_be(code, 0x7c0803a6);
+    push_be(code, dform(14, 1, 1, 0x40));
+    push_be(code, 0x4e800020);
+  }
+  return code;
+}
+
+template <typename SetType>
+void fingerprint_liveness(BasicBlock const& block, std::vector<uint32_t>& out) {
+  // FPR and CR liveness are skipped for functions that never touch them
+  auto const* rl = get_liveness<SetType>(&block);
+  if (rl == nullptr) {
+    out.push_back(0xdeadbeef);
+    return;
+  }
+  for (LivenessCursor<SetType> cursor(block); !cursor.at_end(); cursor.next()) {
+    out.insert(out.end(), {cursor.live_in()._set, cursor.live_out()._set, cursor.def()._set, cursor.use()._set});
+  }
+  out.insert(out.end(), {rl->_input._set, rl->_output._set, rl->_overwrite._set, rl->_routine_inputs._set});
+}
+
+// Flattens everything the machine level stages produce for a function
+std::vector<uint32_t> fingerprint(FunctionAnalysis const& fa) {
+  std::vector<uint32_t> out;
+  Subroutine const& routine = fa._routine;
+  out.insert(out.end(), {routine._start_va, routine._gpr_param._set, routine._fpr_param._set});
+
+  routine._graph->foreach_real([&out](BasicBlockVertex const& bbv) {
+    BasicBlock const& block = bbv.data();
+    out.insert(out.end(), {block._block_start, block._block_end, static_cast<uint32_t>(bbv._out.size())});
+    fingerprint_liveness<GprSet>(block, out);
+    fingerprint_liveness<FprSet>(block, out);
+    fingerprint_liveness<CrSet>(block, out);
+    for (PerilogueInstructionType type : block._perilogue_types) {
+      out.push_back(static_cast<uint32_t>(type));
+    }
+  });
+
+  out.push_back(routine._stack->stack_size());
+  for (auto const* vars : {&routine._stack->var_list(), &routine._stack->param_list()}) {
+    for (StackVariable const& var : *vars) {
+      out.insert(out.end(),
+        {static_cast<uint32_t>(var._offset), static_cast<uint32_t>(var._types), var._is_param, var._is_frame_storage});
+      for (StackReference const& ref : var._refs) {
+        out.insert(out.end(), {ref._location, static_cast<uint32_t>(ref._reftype)});
+      }
+    }
+  }
+  return out;
+}
+}  // namespace
+
+TEST_CASE("parallel_for visits every index exactly once") {
+  for (size_t count : {0, 1, 7, 1000}) {
+    for (size_t num_threads : {1, 3, 8}) {
+      std::vector<std::atomic<int>> visits(count);
+      parallel_for(count, num_threads, [&visits](size_t i) {
+        // Make the front of the range much heavier than the back so workers have to steal
+        volatile uint32_t sink = 0;
+        for (size_t spin = 0; spin < (i < 10 ? 20000 : 10); spin++) {
+          sink = sink + spin;
+        }
+        visits[i]++;
+      });
+
+      for (size_t i = 0; i < count; i++) {
+        CHECK(visits[i].load() == 1);
+      }
+    }
+  }
+}
+
+TEST_CASE("Parallel pipeline matches serial pipeline") {
+  constexpr uint32_t kNumFunctions = 600;
+  std::vector<uint32_t> starts;
+  std::vector<char> code = make_program(kNumFunctions, starts);
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  std::vector<FunctionAnalysis> serial = run_pipeline(ctx, starts, AnalysisProduct::kMachineLevel, 1);
+  REQUIRE(serial.size() == kNumFunctions);
+  std::vector<std::vector<uint32_t>> expected;
+  for (size_t i = 0; i < serial.size(); i++) {
+    REQUIRE(serial[i]._routine._start_va == starts[i]);
+    expected.push_back(fingerprint(serial[i]));
+  }
+
+  for (size_t num_threads : {2, 4, 16}) {
+    std::vector<FunctionAnalysis> parallel = run_pipeline(ctx, starts, AnalysisProduct::kMachineLevel, num_threads);
+    REQUIRE(parallel.size() == kNumFunctions);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < parallel.size(); i++) {
+      mismatches += fingerprint(parallel[i]) != expected[i];
+    }
+    MESSAGE(num_threads << " threads, " << mismatches << " mismatched functions");
+    CHECK(mismatches == 0);
+  }
+}
+
+TEST_CASE("Requested products pull in the products their passes consume") {
+  CHECK(required_products(AnalysisProduct::kNone) == AnalysisProduct::kNone);
+  CHECK(required_products(AnalysisProduct::kGraph) == AnalysisProduct::kGraph);
+  CHECK(required_products(AnalysisProduct::kLiveness) == (AnalysisProduct::kGraph | AnalysisProduct::kLiveness));
+  CHECK(required_products(AnalysisProduct::kStack) == (AnalysisProduct::kGraph | AnalysisProduct::kStack));
+  CHECK(required_products(AnalysisProduct::kPerilogue) == AnalysisProduct::kMachineLevel);
+  CHECK(required_products(AnalysisProduct::kIr) == AnalysisProduct::kAll);
+}
+
+TEST_CASE("Pipeline skips passes with nothing to analyze") {
+  // Leaf function on GPRs only: addi r3, r3, 1; blr
+  // Float function that never touches r1 or CRs: fadd f1, f1, f2; blr
+  // Framed function: stwu r1, -0x20(r1); addi r1, r1, 0x20; blr
+  std::vector<char> code;
+  for (uint32_t word : {dform(14, 3, 3, 1), 0x4e800020u, xo63(1, 1, 2, 21), 0x4e800020u}) {
+    push_be(code, word);
+  }
+  for (uint32_t word : {dform(37, 1, 1, -0x20), dform(14, 1, 1, 0x20), 0x4e800020u}) {
+    push_be(code, word);
+  }
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  std::vector<FunctionAnalysis> functions(3);
+  functions[0]._routine._start_va = kProgramBase;
+  functions[1]._routine._start_va = kProgramBase + 8;
+  functions[2]._routine._start_va = kProgramBase + 16;
+  PipelineReport report = run_pipeline(ctx, functions, AnalysisProduct::kPerilogue, 1);
+
+  BasicBlock const& leaf = functions[0]._routine._graph->entrypoint()->data();
+  CHECK(leaf._gpr_lifetimes != nullptr);
+  CHECK(leaf._fpr_lifetimes == nullptr);
+  CHECK(leaf._cr_lifetimes == nullptr);
+  BasicBlock const& fp = functions[1]._routine._graph->entrypoint()->data();
+  CHECK(fp._fpr_lifetimes != nullptr);
+  CHECK(fp._cr_lifetimes == nullptr);
+  CHECK(functions[1]._routine._fpr_param.in_set(FPR::kF2));
+
+  for (FunctionAnalysis const& fa : functions) {
+    CHECK(fa._routine._products == (AnalysisProduct::kGraph | AnalysisProduct::kLiveness | AnalysisProduct::kStack |
+                                     AnalysisProduct::kPerilogue));
+    REQUIRE(fa._routine._stack != nullptr);
+  }
+  CHECK(functions[0]._routine._stack->stack_size() == 0);
+  CHECK(functions[2]._routine._stack->stack_size() == 0x20);
+
+  auto row = [&report](std::string_view name) {
+    auto it = std::find_if(report._passes.begin(), report._passes.end(), [name](PassTiming const& pass) {
+      return name == pass._name;
+    });
+    REQUIRE(it != report._passes.end());
+    return std::pair(it->_ran, it->_skipped);
+  };
+  CHECK(row("graph") == std::pair<size_t, size_t>(3, 0));
+  CHECK(row("liveness") == std::pair<size_t, size_t>(3, 0));
+  CHECK(row("fpr liveness") == std::pair<size_t, size_t>(1, 2));
+  CHECK(row("cr liveness") == std::pair<size_t, size_t>(0, 3));
+  CHECK(row("stack") == std::pair<size_t, size_t>(1, 2));
+  CHECK(row("perilogue") == std::pair<size_t, size_t>(3, 0));
+
+  // A second run finds every result already in place
+  report = run_pipeline(ctx, functions, AnalysisProduct::kMachineLevel, 1);
+  CHECK(row("graph") == std::pair<size_t, size_t>(0, 3));
+  CHECK(row("liveness") == std::pair<size_t, size_t>(0, 3));
+  CHECK(row("stack") == std::pair<size_t, size_t>(0, 3));
+}
+
+TEST_CASE("Graph only pipeline reports just the graph pass") {
+  std::vector<char> code;
+  for (uint32_t word : {dform(37, 1, 1, -0x20), dform(14, 1, 1, 0x20), 0x4e800020u}) {
+    push_be(code, word);
+  }
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  std::vector<FunctionAnalysis> functions(1);
+  functions[0]._routine._start_va = kProgramBase;
+  for (size_t ran : {1, 0}) {
+    PipelineReport report = run_pipeline(ctx, functions, AnalysisProduct::kGraph, 1);
+    REQUIRE(report._passes.size() == 1);
+    CHECK(std::string_view(report._passes[0]._name) == "graph");
+    CHECK(report._passes[0]._ran == ran);
+    CHECK(report._passes[0]._skipped == 1 - ran);
+  }
+  CHECK(functions[0]._routine._products == AnalysisProduct::kGraph);
+  CHECK(functions[0]._routine._graph != nullptr);
+  CHECK(functions[0]._routine._stack == nullptr);
+}
@@ -0,0 +1,86 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "dbgutil/Disassembler.hh"
+#include "ppc/PpcDisasm.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kNumPrimaryOpcodes = 64;
+// Words per extended opcode key, and per primary opcode for those without extended opcodes
+constexpr uint32_t kSamplesPerKey = 4;
+constexpr uint32_t kSamplesPerOpcode = 1024;
+constexpr uint32_t kExtendedMask = 0x3ff << 1;
+
+constexpr bool has_extended_opcode(uint32_t opcd) {
+  return opcd == 4 || opcd == 19 || opcd == 31 || opcd == 59 || opcd == 63;
+}
+
+uint32_t fnv1a(uint32_t hash, std::string const& text) {
+  for (char c : text) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
+
+// Everything the decoder produced for a word, spelled out through the debug printers
+std::string describe(uint32_t word) {
+  MetaInst inst;
+  disasm_single(0x80003100, word, inst);
+  std::ostringstream out;
+  out << static_cast<int>(inst._op) << ' ' << static_cast<uint32_t>(inst._flags) << ' ' << inst._reads.size() << ' '
+      << inst._writes.size() << ' ';
+  write_inst_info(inst, out);
+  if (inst._op != InstOperation::kInvalid) {
+    write_inst_disassembly(inst, out);
+  }
+  return out.str();
+}
+
+// Hash of the decodes of every extended opcode key (or a spread of words) under one primary opcode, with the
+// remaining operand fields randomized
+uint32_t decode_fingerprint(uint32_t opcd, std::mt19937& rng) {
+  uint32_t hash = 2166136261u;
+  if (has_extended_opcode(opcd)) {
+    for (uint32_t key = 0; key < 0x400; key++) {
+      for (uint32_t i = 0; i < kSamplesPerKey; i++) {
+        hash = fnv1a(hash, describe((opcd << 26) | (rng() & 0x3ffffff & ~kExtendedMask) | (key << 1)));
+      }
+    }
+  } else {
+    for (uint32_t i = 0; i < kSamplesPerOpcode; i++) {
+      hash = fnv1a(hash, describe((opcd << 26) | (rng() & 0x3ffffff)));
+    }
+  }
+  return hash;
+}
+
+// decode_fingerprint of every primary opcode, recorded with the switch based decoder the opcode table replaced
+constexpr uint32_t kSwitchDecoderFingerprints[] = {
+  0x1c6669c5, 0x1c6669c5, 0x1c6669c5, 0xfe72a486, 0x32e22f8b, 0x1c6669c5, 0x1c6669c5, 0xd9fdfa94,
+  0x60524b8b, 0x1c6669c5, 0xaeb3badb, 0xe9bee2de, 0xe46035ff, 0xf24bad79, 0x197f2089, 0x3f80bd67,
+  0xe1277f08, 0x642b7143, 0xbd2cd8fd, 0xffeaa412, 0x426b94d4, 0xf6173381, 0x1c6669c5, 0x47609f17,
+  0x254da993, 0xaca326dd, 0xa93692b4, 0x9b5c650b, 0x184fb654, 0x98ed0233, 0x1c6669c5, 0x9a2c9267,
+  0xc32f3850, 0x714689b6, 0xcecf57c1, 0x417863bd, 0x98500e25, 0xc6b189f4, 0x319910dc, 0x503766b6,
+  0xf186e536, 0x3defa51a, 0x55bd7c6f, 0xb6a144f6, 0xe7258414, 0x837f6500, 0x36600065, 0x0294483d,
+  0xb90f9820, 0x9f611084, 0x9edf915a, 0xcc893af2, 0xe3cfff70, 0x1e954326, 0x62c23b14, 0xbffa3557,
+  0x171c87a2, 0x83933800, 0x1c6669c5, 0xf241e201, 0xbcb99e15, 0x174e8a77, 0x1c6669c5, 0x9e92657e,
+};
+}  // namespace
+
+TEST_CASE("Decoder matches the switch based decoder it replaced") {
+  static_assert(std::size(kSwitchDecoderFingerprints) == kNumPrimaryOpcodes);
+  std::mt19937 rng(0x5ca1ab1e);
+  for (uint32_t opcd = 0; opcd < kNumPrimaryOpcodes; opcd++) {
+    CAPTURE(opcd);
+    CHECK(decode_fingerprint(opcd, rng) == kSwitchDecoderFingerprints[opcd]);
+  }
+}
@@ -1,12 +1,22 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <algorithm>
 #include <array>
+#include <numeric>
+#include <random>
 #include <sstream>
+#include <thread>
 #include <utility>
 #include <variant>
+#include <vector>
 
+#include "utl/DominatorTree.hh"
 #include "utl/FlowGraph.hh"
+#include "utl/FlowGraphSnapshot.hh"
+#include "utl/LoopForest.hh"
+#include "utl/PostorderList.hh"
+#include "utl/ReachabilityIndex.hh"
 
 using namespace decomp;
 
@@ -80,6 +90,122 @@ std::pair<FlowGraph<int>, std::array<int, 15>> make_basic_flowgraph() {
   return std::make_pair(std::move(ret), vertices);
 }
 
+// Dominator sets by plain dataflow iteration, slow but simple enough to trust. Vertices the start can't reach are left
+// at -1
+template <bool Forward>
+std::vector<int> reference_idoms(FlowGraphSnapshot const& shape) {
+  const size_t n = shape.size();
+  const int start = Forward ? shape.root() : shape.terminal();
+  std::vector<bool> reached(n);
+  shape.preorder<Forward>([&reached](int idx) { reached[idx] = true; }, start);
+
+  std::vector<std::vector<bool>> dom(n, std::vector<bool>(n, true));
+  dom[start].assign(n, false);
+  dom[start][start] = true;
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (size_t v = 0; v < n; v++) {
+      if (!reached[v] || static_cast<int>(v) == start) {
+        continue;
+      }
+      std::vector<bool> meet(n, true);
+      for (EdgeData const& ed : shape.edges<!Forward>(v)) {
+        if (reached[ed._target]) {
+          for (size_t i = 0; i < n; i++) {
+            meet[i] = meet[i] && dom[ed._target][i];
+          }
+        }
+      }
+      meet[v] = true;
+      if (meet != dom[v]) {
+        dom[v] = std::move(meet);
+        changed = true;
+      }
+    }
+  }
+
+  // The immediate dominator is the strict dominator with the most dominators of its own
+  std::vector<int> idom(n, -1);
+  idom[start] = start;
+  for (size_t v = 0; v < n; v++) {
+    if (!reached[v] || static_cast<int>(v) == start) {
+      continue;
+    }
+    size_t best_depth = 0;
+    for (size_t d = 0; d < n; d++) {
+      if (d != v && dom[v][d]) {
+        const size_t depth = std::count(dom[d].begin(), dom[d].end(), true);
+        if (depth > best_depth) {
+          best_depth = depth;
+          idom[v] = static_cast<int>(d);
+        }
+      }
+    }
+  }
+  return idom;
+}
+
+// Natural loop of h, the union over every back edge into h of what reaches the edge's source without passing h, leaving
+// out anything the root can't reach. Empty when nothing dominated by h jumps back to it
+std::vector<int> reference_natural_loop(FlowGraphSnapshot const& shape, DominatorTree const& dom, int h) {
+  std::vector<bool> in_loop(shape.size());
+  std::vector<int> pending;
+  for (EdgeData const& ed : shape.predecessors(h)) {
+    if (dom.dominates(h, ed._target)) {
+      pending.push_back(ed._target);
+    }
+  }
+  if (pending.empty()) {
+    return {};
+  }
+  in_loop[h] = true;
+  while (!pending.empty()) {
+    const int v = pending.back();
+    pending.pop_back();
+    if (in_loop[v]) {
+      continue;
+    }
+    in_loop[v] = true;
+    for (EdgeData const& ed : shape.predecessors(v)) {
+      if (dom.contains(ed._target)) {
+        pending.push_back(ed._target);
+      }
+    }
+  }
+
+  std::vector<int> result;
+  for (size_t v = 0; v < shape.size(); v++) {
+    if (in_loop[v]) {
+      result.push_back(static_cast<int>(v));
+    }
+  }
+  return result;
+}
+
+// Reducible when the reachable graph is acyclic with every edge into a dominator taken out
+bool reference_reducible(FlowGraphSnapshot const& shape, DominatorTree const& dom) {
+  std::vector<int> num_preds(shape.size());
+  for (size_t v = 0; v < shape.size(); v++) {
+    for (EdgeData const& ed : shape.successors(v)) {
+      num_preds[ed._target] += dom.contains(v) && !dom.dominates(ed._target, v);
+    }
+  }
+  std::vector<int> ready{shape.root()};
+  size_t num_visited = 0;
+  while (!ready.empty()) {
+    const int v = ready.back();
+    ready.pop_back();
+    num_visited++;
+    for (EdgeData const& ed : shape.successors(v)) {
+      if (!dom.dominates(ed._target, v) && --num_preds[ed._target] == 0) {
+        ready.push_back(ed._target);
+      }
+    }
+  }
+  return num_visited == static_cast<size_t>(std::count_if(
+                          dom.idoms().begin(), dom.idoms().end(), [](int idom) { return idom != -1; }));
+}
+
 TEST_CASE("Test node iteration helpers") {
   auto [gr, vertices] = make_basic_flowgraph();
 
@@ -88,7 +214,7 @@ TEST_CASE("Test node iteration helpers") {
     CHECK(fv.is_real());
     niter++;
   });
-  CHECK((gr.size() - 2) == niter);
+  CHECK((gr.size() - 2) == static_cast<size_t>(niter));
 
   niter = gr.accumulate_real(
     [](FlowVertex<int>& fv, int niter) {
@@ -96,7 +222,7 @@ TEST_CASE("Test node iteration helpers") {
       return niter + 1;
     },
     0);
-  CHECK((gr.size() - 2) == niter);
+  CHECK((gr.size() - 2) == static_cast<size_t>(niter));
 
   FlowVertex<int>* fv;
   fv = gr.find_real([](FlowVertex<int>& fv) {
@@ -130,7 +256,7 @@ TEST_CASE("Test node edge iteration helpers") {
   auto [gr2, vertices2] = make_multiexit_flowgraph();
   gr2.foreach_exit([&gr2, &vertices2](FlowVertex<int>& fv) {
     CHECK(gr2.is_exit_vertex(&fv));
-    CHECK(fv.data() < vertices2.size());
+    CHECK(static_cast<size_t>(fv.data()) < vertices2.size());
     vertices2[fv.data()] = -1;
   });
   CHECK(vertices2[0] != -1);
@@ -394,3 +520,623 @@ TEST_CASE("Test dominator tree") {
   expected_pdom[vertices[14]] = gr.terminal()->_idx;
   CHECK(expected_pdom == pdom);
 }
+
+TEST_CASE("Test edge lists spilling past inline storage") {
+  FlowGraph<int> gr;
+  const int head = gr.emplace_vertex(0);
+  gr.emplace_link(gr.root()->_idx, head, BlockTransfer::kFallthrough);
+
+  // Switch-like fan-out well past the inline edges
+  constexpr int kNumCases = 12;
+  std::vector<int> cases;
+  for (int i = 0; i < kNumCases; i++) {
+    cases.push_back(gr.emplace_vertex(i + 1));
+    const auto tr = static_cast<BlockTransfer>(static_cast<uint32_t>(BlockTransfer::kFirstSwitchCase) + i);
+    gr.emplace_link(head, cases.back(), tr);
+    gr.emplace_link(cases.back(), gr.terminal()->_idx, BlockTransfer::kUnconditional);
+  }
+
+  REQUIRE(gr.vertex(head)->_out.size() == kNumCases);
+  REQUIRE(gr.terminal()->_in.size() == kNumCases);
+  for (int i = 0; i < kNumCases; i++) {
+    CHECK(gr.vertex(head)->_out[i]._target == cases[i]);
+    CHECK(gr.terminal()->_in[i]._target == cases[i]);
+  }
+
+  // Copies and moves keep every edge, moving a spilled list leaves the source empty
+  EdgeList copy = gr.vertex(head)->_out;
+  CHECK(copy == gr.vertex(head)->_out);
+  EdgeList moved = std::move(copy);
+  CHECK(copy.empty());
+  CHECK(moved == gr.vertex(head)->_out);
+
+  // Detaching a case removes it from both lists around it
+  gr.detach(gr.vertex(cases[3]));
+  CHECK(gr.vertex(head)->_out.size() == kNumCases - 1);
+  CHECK(gr.terminal()->_in.size() == kNumCases - 1);
+  CHECK(std::none_of(gr.vertex(head)->_out.begin(), gr.vertex(head)->_out.end(), [&cases](EdgeData const& ed) {
+    return ed._target == cases[3];
+  }));
+  CHECK(gr.vertex(head)->_out[3]._target == cases[4]);
+}
+
+TEST_CASE("Test vertex storage growth") {
+  FlowGraph<int> gr;
+  constexpr int kNumVertices = 5000;
+  int prev = gr.root()->_idx;
+  for (int i = 0; i < kNumVertices; i++) {
+    const int cur = gr.emplace_vertex(i);
+    gr.emplace_link(prev, cur, i % 2 == 0 ? BlockTransfer::kFallthrough : BlockTransfer::kUnconditional);
+    prev = cur;
+  }
+  gr.emplace_link(prev, gr.terminal()->_idx, BlockTransfer::kFallthrough);
+
+  // Splitting moves vertices around, indices stay valid
+  const int first = gr.entrypoint()->_idx;
+  const int split = gr.insert_after(gr.vertex(first), -1, BlockTransfer::kFallthrough);
+  CHECK(gr.vertex(first)->_out.size() == 1);
+  CHECK(gr.vertex(first)->_out[0]._target == split);
+  CHECK(gr.vertex(split)->_in[0]._target == first);
+  CHECK(gr.vertex(gr.vertex(split)->_out[0]._target)->data() == 1);
+
+  // The untemplated base sees the same vertices as the graph
+  FlowGraphBase const& base = gr;
+  int visited = 0;
+  int data_sum = 0;
+  for (size_t i = 0; i < gr.size(); i++) {
+    CHECK(base.vertex(i) == gr.vertex(i));
+    CHECK(gr.vertex(i)->_idx == static_cast<int>(i));
+  }
+  gr.preorder_fwd(
+    [&visited, &data_sum](FlowVertex<int>& fv) {
+      if (fv.is_real()) {
+        visited++;
+        data_sum += fv.data();
+      }
+    },
+    gr.root());
+  CHECK(visited == kNumVertices + 1);
+  CHECK(data_sum == kNumVertices * (kNumVertices - 1) / 2 - 1);
+
+  // Moving the graph hands over the storage
+  FlowGraph<int> moved = std::move(gr);
+  CHECK(moved.size() == kNumVertices + 3);
+  CHECK(static_cast<FlowGraphBase&>(moved).vertex(split) == moved.vertex(split));
+  std::vector<int> dom = moved.compute_dom_tree();
+  CHECK(dom[split] == first);
+}
+
+TEST_CASE("Test snapshot matches graph shape") {
+  auto [gr, vertices] = make_basic_flowgraph();
+  // One vertex nothing reaches, and one left detached
+  const int unreachable = gr.emplace_vertex(100);
+  gr.emplace_link(unreachable, vertices[9], BlockTransfer::kUnconditional);
+  const int detached = gr.emplace_vertex(101);
+  gr.emplace_link(vertices[10], detached, BlockTransfer::kUnconditional);
+  gr.detach(gr.vertex(detached));
+
+  FlowGraphSnapshot shape(gr);
+  REQUIRE(shape.size() == gr.size());
+  CHECK(shape.root() == gr.root()->_idx);
+  CHECK(shape.terminal() == gr.terminal()->_idx);
+  for (size_t i = 0; i < gr.size(); i++) {
+    auto const* v = gr.vertex(i);
+    CHECK(std::equal(v->_out.begin(), v->_out.end(), shape.successors(i).begin(), shape.successors(i).end()));
+    CHECK(std::equal(v->_in.begin(), v->_in.end(), shape.predecessors(i).begin(), shape.predecessors(i).end()));
+    CHECK(shape.is_real(i) == (v->is_real() && !v->_detached));
+    CHECK(shape.is_exit(i) == gr.is_exit_vertex(v));
+  }
+  CHECK(shape.flags(shape.root()) == SnapshotVertexFlags::kPreheader);
+  CHECK(shape.flags(shape.terminal()) == SnapshotVertexFlags::kPostExit);
+
+  // Postorder covers exactly what's reachable, and every tree edge points at something finished earlier
+  std::vector<int> position(shape.size(), -1);
+  for (size_t i = 0; i < shape.postorder().size(); i++) {
+    position[shape.postorder()[i]] = static_cast<int>(i);
+  }
+  CHECK(shape.postorder().size() == gr.size() - 2);
+  CHECK(position[unreachable] == -1);
+  CHECK(position[detached] == -1);
+  CHECK(position[shape.root()] == static_cast<int>(shape.postorder().size()) - 1);
+  CHECK(shape.rpo().front() == shape.root());
+  CHECK(std::equal(shape.rpo().begin(), shape.rpo().end(), shape.postorder().rbegin(), shape.postorder().rend()));
+
+  std::vector<int> graph_preorder;
+  gr.preorder_fwd([&graph_preorder](FlowVertex<int>& fv) { graph_preorder.push_back(fv._idx); }, gr.root());
+  std::vector<int> shape_preorder;
+  shape.preorder<true>([&shape_preorder](int idx) { shape_preorder.push_back(idx); }, shape.root());
+  CHECK(shape_preorder == graph_preorder);
+
+  // Dominators of what's reachable don't change
+  std::vector<int> dom = shape.compute_dom_tree();
+  CHECK(dom[vertices[9]] == vertices[2]);
+  CHECK(dom[vertices[11]] == vertices[9]);
+  CHECK(dom[vertices[14]] == vertices[1]);
+  CHECK(dom == gr.compute_dom_tree());
+}
+
+TEST_CASE("Test dominators match dataflow on random graphs") {
+  std::mt19937 rng(0xd0d0);
+  auto pick = [&rng](uint32_t n) { return static_cast<int>(rng() % n); };
+
+  size_t mismatches = 0;
+  size_t num_unreachable = 0;
+  for (int round = 0; round < 400; round++) {
+    // Arbitrary edges, irreducible loops, infinite loops and vertices nothing reaches included
+    FlowGraph<int> gr;
+    const int num_blocks = 1 + pick(80);
+    std::vector<int> vertices;
+    for (int i = 0; i < num_blocks; i++) {
+      vertices.push_back(gr.emplace_vertex(i));
+    }
+    gr.emplace_link(gr.root()->_idx, vertices[0], BlockTransfer::kFallthrough);
+    for (int i = 0; i < num_blocks; i++) {
+      for (int edges = pick(4); edges > 0; edges--) {
+        gr.emplace_link(vertices[i], vertices[pick(num_blocks)], BlockTransfer::kUnconditional);
+      }
+      if (i == num_blocks - 1 || pick(6) == 0) {
+        gr.emplace_link(vertices[i], gr.terminal()->_idx, BlockTransfer::kUnconditional);
+      }
+    }
+
+    FlowGraphSnapshot shape(gr);
+    const std::vector<int> dom = shape.compute_dom_tree();
+    const std::vector<int> pdom = shape.compute_pdom_tree();
+    const std::vector<int> expected_dom = reference_idoms<true>(shape);
+    const std::vector<int> expected_pdom = reference_idoms<false>(shape);
+    for (size_t v = 0; v < shape.size(); v++) {
+      mismatches += expected_dom[v] != dom[v];
+      mismatches += expected_pdom[v] != pdom[v];
+      num_unreachable += expected_dom[v] == -1 || expected_pdom[v] == -1;
+    }
+    CHECK(dom == gr.compute_dom_tree());
+  }
+  CHECK(mismatches == 0);
+  // Make sure the generator actually exercises the unreachable paths
+  CHECK(num_unreachable > 0);
+}
+
+TEST_CASE("Test dominator tree queries") {
+  auto [gr, vertices] = make_basic_flowgraph();
+  const int unreachable = gr.emplace_vertex(100);
+  gr.emplace_link(unreachable, vertices[9], BlockTransfer::kUnconditional);
+  DominatorTree dom(gr.compute_dom_tree());
+
+  CHECK(dom.root() == gr.root()->_idx);
+  CHECK(dom.idom(vertices[9]) == vertices[2]);
+  CHECK(dom.depth(gr.root()->_idx) == 0);
+  CHECK(dom.depth(vertices[2]) == 3);
+  CHECK(dom.depth(vertices[12]) == 6);
+  std::vector<int> children(dom.children(vertices[2]).begin(), dom.children(vertices[2]).end());
+  std::sort(children.begin(), children.end());
+  CHECK(children == std::vector<int>{vertices[3], vertices[4], vertices[9]});
+
+  CHECK(dom.dominates(vertices[2], vertices[12]));
+  CHECK(dom.dominates(vertices[2], vertices[2]));
+  CHECK(!dom.strictly_dominates(vertices[2], vertices[2]));
+  CHECK(!dom.dominates(vertices[3], vertices[9]));
+  CHECK(!dom.dominates(vertices[12], vertices[2]));
+  CHECK(!dom.contains(unreachable));
+  CHECK(!dom.dominates(unreachable, vertices[9]));
+  CHECK(!dom.dominates(gr.root()->_idx, unreachable));
+
+  // Every pair agrees with walking up the idoms
+  DominatorTree pdom(gr.compute_pdom_tree());
+  size_t mismatches = 0;
+  for (DominatorTree const* tree : {&dom, &pdom}) {
+    for (int m = 0; m < static_cast<int>(gr.size()); m++) {
+      std::vector<bool> walked(gr.size());
+      for (int it = m; tree->contains(m); it = tree->idom(it)) {
+        walked[it] = true;
+        if (it == tree->idom(it)) {
+          break;
+        }
+      }
+      for (int n = 0; n < static_cast<int>(gr.size()); n++) {
+        mismatches += tree->dominates(n, m) != walked[n];
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("Test dominator tree collapse at the root") {
+  // 0 -> 1 -> 2 and 0 -> 3, with the region {0, 1} collapsed into 4
+  DominatorTree dom(std::vector<int>{0, 0, 1, 0});
+  const std::array<int, 2> members{0, 1};
+  dom.collapse(members, 0, 4);
+
+  CHECK(dom.root() == 4);
+  CHECK(dom.idoms() == std::vector<int>{-1, -1, 4, 4, 4});
+  CHECK(dom.children(4).size() == 2);
+  dom.reindex();
+  CHECK(dom.dominates(4, 2));
+  CHECK(dom.dominates(4, 3));
+  CHECK(!dom.dominates(2, 3));
+  CHECK(dom.depth(2) == 1);
+}
+
+TEST_CASE("Test dominator trees stay exact through updates") {
+  std::mt19937 rng(0x1dd0);
+  auto pick = [&rng](uint32_t n) { return static_cast<int>(rng() % n); };
+
+  size_t mismatches = 0;
+  size_t num_collapses = 0;
+  for (int round = 0; round < 200; round++) {
+    FlowGraph<int> gr;
+    const int num_blocks = 2 + pick(40);
+    std::vector<int> vertices;
+    for (int i = 0; i < num_blocks; i++) {
+      vertices.push_back(gr.emplace_vertex(i));
+    }
+    gr.emplace_link(gr.root()->_idx, vertices[0], BlockTransfer::kFallthrough);
+    for (int i = 0; i < num_blocks; i++) {
+      for (int edges = pick(3); edges > 0; edges--) {
+        gr.emplace_link(vertices[i], vertices[pick(num_blocks)], BlockTransfer::kUnconditional);
+      }
+      if (i == num_blocks - 1 || pick(5) == 0) {
+        gr.emplace_link(vertices[i], gr.terminal()->_idx, BlockTransfer::kUnconditional);
+      }
+    }
+    DominatorTree dom = DominatorTree::dominators(gr);
+    DominatorTree pdom = DominatorTree::postdominators(gr);
+
+    for (int step = 0; step < 30; step++) {
+      std::vector<int> live;
+      gr.foreach_real([&live](FlowVertex<int> const& v) { live.push_back(v._idx); });
+      const int a = live[pick(live.size())];
+      const uint32_t op = pick(3);
+      if (op == 0) {
+        const int b = live[pick(live.size())];
+        gr.emplace_link(a, b, BlockTransfer::kUnconditional);
+        dom.insert_edge(gr, a, b);
+        pdom.insert_edge(gr, a, b);
+      } else if (op == 1 && !gr.vertex(a)->_out.empty()) {
+        const int b = gr.vertex(a)->_out[pick(gr.vertex(a)->_out.size())]._target;
+        gr.remove_link(a, b);
+        dom.delete_edge(gr, a, b);
+        pdom.delete_edge(gr, a, b);
+      } else if (op == 2) {
+        // Grow a single entry region from a, taking successors whose predecessors are all inside already
+        std::vector<int> members{a};
+        for (size_t i = 0; i < members.size() && members.size() < 6; i++) {
+          for (EdgeData const& ed : gr.vertex(members[i])->_out) {
+            FlowVertex<int> const* succ = gr.vertex(ed._target);
+            const bool inside = std::all_of(succ->_in.begin(), succ->_in.end(), [&members](EdgeData const& in) {
+              return std::find(members.begin(), members.end(), in._target) != members.end();
+            });
+            if (succ->is_real() && inside && std::find(members.begin(), members.end(), succ->_idx) == members.end()) {
+              members.push_back(succ->_idx);
+            }
+          }
+        }
+        const int repl = gr.substitute_region(members, -1);
+        dom.collapse(members, a, repl);
+        pdom.collapse(members, a, repl);
+        num_collapses += members.size() > 1;
+      }
+      mismatches += !dom.matches(gr);
+      mismatches += !pdom.matches(gr);
+    }
+
+    // Queries agree with the index once it's rebuilt
+    std::vector<bool> walked_dominates;
+    for (int n = 0; n < static_cast<int>(gr.size()); n++) {
+      for (int m = 0; m < static_cast<int>(gr.size()); m++) {
+        walked_dominates.push_back(dom.dominates(n, m));
+      }
+    }
+    dom.reindex();
+    for (int n = 0; n < static_cast<int>(gr.size()); n++) {
+      for (int m = 0; m < static_cast<int>(gr.size()); m++) {
+        mismatches += dom.dominates(n, m) != walked_dominates[n * gr.size() + m];
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(num_collapses > 0);
+}
+
+TEST_CASE("Test loop nesting forest") {
+  auto [gr, vertices] = make_basic_flowgraph();
+  LoopForest loops = LoopForest::compute(gr);
+
+  REQUIRE(loops.num_loops() == 2);
+  REQUIRE(loops.is_header(vertices[1]));
+  REQUIRE(loops.is_header(vertices[11]));
+  const int outer = loops.headed_by(vertices[1]);
+  const int inner = loops.headed_by(vertices[11]);
+  CHECK(loops.loop(inner)._parent == outer);
+  CHECK(loops.loop(outer)._parent == -1);
+  CHECK(std::vector<int>(loops.top_level().begin(), loops.top_level().end()) == std::vector<int>{outer});
+  CHECK(loops.loop(outer)._reducible);
+  CHECK(loops.depth(vertices[0]) == 0);
+  CHECK(loops.depth(vertices[5]) == 1);
+  CHECK(loops.depth(vertices[12]) == 2);
+  CHECK(loops.depth(vertices[14]) == 0);
+  CHECK(loops.contains(outer, vertices[12]));
+  CHECK(!loops.contains(inner, vertices[13]));
+
+  std::vector<int> outer_body = loops.body(outer);
+  CHECK(outer_body.front() == vertices[1]);
+  std::sort(outer_body.begin(), outer_body.end());
+  CHECK(outer_body == std::vector<int>(vertices.begin() + 1, vertices.end() - 1));
+  CHECK(loops.exits(gr, outer) == std::vector<int>{vertices[14]});
+  CHECK(loops.exits(gr, inner) == std::vector<int>{vertices[13]});
+
+  // Two way entry into a cycle, whichever side the search reaches first heads it
+  FlowGraph<int> irr;
+  const int a = irr.emplace_vertex(0);
+  const int b = irr.emplace_vertex(1);
+  const int c = irr.emplace_vertex(2);
+  const int d = irr.emplace_vertex(3);
+  irr.emplace_link(irr.root()->_idx, a, BlockTransfer::kFallthrough);
+  irr.emplace_link(a, b, BlockTransfer::kConditionTrue);
+  irr.emplace_link(a, c, BlockTransfer::kConditionFalse);
+  irr.emplace_link(b, c, BlockTransfer::kUnconditional);
+  irr.emplace_link(c, b, BlockTransfer::kConditionTrue);
+  irr.emplace_link(c, d, BlockTransfer::kConditionFalse);
+  irr.emplace_link(d, d, BlockTransfer::kConditionTrue);
+  irr.emplace_link(d, irr.terminal()->_idx, BlockTransfer::kConditionFalse);
+  LoopForest irr_loops = LoopForest::compute(irr);
+
+  REQUIRE(irr_loops.num_loops() == 2);
+  const int cycle = irr_loops.headed_by(b);
+  REQUIRE(cycle != -1);
+  CHECK(!irr_loops.loop(cycle)._reducible);
+  CHECK(irr_loops.loop(cycle)._entries == std::vector<int>{c});
+  CHECK(irr_loops.loop_of(c) == cycle);
+  REQUIRE(irr_loops.is_header(d));
+  CHECK(irr_loops.loop(irr_loops.headed_by(d))._blocks == std::vector<int>{d});
+  CHECK(irr_loops.loop(irr_loops.headed_by(d))._reducible);
+}
+
+TEST_CASE("Test loop nesting forest matches natural loops") {
+  std::mt19937 rng(0x100f);
+  auto pick = [&rng](uint32_t n) { return static_cast<int>(rng() % n); };
+
+  size_t mismatches = 0;
+  size_t num_reducible = 0;
+  size_t num_irreducible = 0;
+  size_t num_collapses = 0;
+  for (int round = 0; round < 400; round++) {
+    // Mostly forward edges so a fair share of graphs come out reducible
+    FlowGraph<int> gr;
+    const int num_blocks = 2 + pick(40);
+    std::vector<int> vertices;
+    for (int i = 0; i < num_blocks; i++) {
+      vertices.push_back(gr.emplace_vertex(i));
+    }
+    gr.emplace_link(gr.root()->_idx, vertices[0], BlockTransfer::kFallthrough);
+    for (int i = 0; i < num_blocks; i++) {
+      for (int edges = 1 + pick(2); edges > 0; edges--) {
+        const int target = pick(8) == 0 ? pick(num_blocks) : std::min(num_blocks - 1, i + 1 + pick(4));
+        gr.emplace_link(vertices[i], vertices[target], BlockTransfer::kUnconditional);
+      }
+      if (i == num_blocks - 1) {
+        gr.emplace_link(vertices[i], gr.terminal()->_idx, BlockTransfer::kUnconditional);
+      }
+    }
+
+    FlowGraphSnapshot shape(gr);
+    DominatorTree dom(shape.compute_dom_tree());
+    // The first call builds the forest, racing readers all get the same one
+    LoopForest const* other = nullptr;
+    std::thread reader([&shape, &other] { other = &shape.loops(); });
+    LoopForest const& loops = shape.loops();
+    reader.join();
+    CHECK(&loops == other);
+    CHECK(&loops == &shape.loops());
+
+    // Every loop sits inside its parent
+    for (int id = 0; id < static_cast<int>(loops.num_loops()); id++) {
+      const int parent = loops.loop(id)._parent;
+      if (parent != -1) {
+        for (int v : loops.body(id)) {
+          mismatches += !loops.contains(parent, v);
+        }
+      }
+    }
+
+    if (!reference_reducible(shape, dom)) {
+      num_irreducible++;
+      mismatches += std::all_of(loops.top_level().begin(), loops.top_level().end(), [&loops](int id) {
+        std::vector<int> pending{id};
+        while (!pending.empty()) {
+          LoopForest::Loop const& loop = loops.loop(pending.back());
+          pending.pop_back();
+          if (!loop._reducible) {
+            return false;
+          }
+          pending.insert(pending.end(), loop._children.begin(), loop._children.end());
+        }
+        return true;
+      });
+      continue;
+    }
+
+    num_reducible++;
+    for (size_t h = 0; h < shape.size(); h++) {
+      std::vector<int> expected = reference_natural_loop(shape, dom, static_cast<int>(h));
+      const int id = loops.headed_by(static_cast<int>(h));
+      if (id == -1) {
+        mismatches += !expected.empty();
+        continue;
+      }
+      std::vector<int> body = loops.body(id);
+      mismatches += body.front() != static_cast<int>(h);
+      mismatches += !loops.loop(id)._reducible;
+      std::sort(body.begin(), body.end());
+      mismatches += body != expected;
+    }
+
+    // Collapse single entry regions and compare the loops around each vertex against a recompute
+    LoopForest updated = LoopForest::compute(gr);
+    for (int step = 0; step < 10; step++) {
+      std::vector<int> live;
+      gr.foreach_real([&live, &updated](FlowVertex<int> const& v) { live.push_back(v._idx); });
+      const int a = live[pick(live.size())];
+      std::vector<int> members{a};
+      for (size_t i = 0; i < members.size() && members.size() < 6; i++) {
+        for (EdgeData const& ed : gr.vertex(members[i])->_out) {
+          FlowVertex<int> const* succ = gr.vertex(ed._target);
+          const bool inside = std::all_of(succ->_in.begin(), succ->_in.end(), [&members](EdgeData const& in) {
+            return std::find(members.begin(), members.end(), in._target) != members.end();
+          });
+          if (succ->is_real() && inside && !updated.is_header(succ->_idx) &&
+              std::find(members.begin(), members.end(), succ->_idx) == members.end()) {
+            members.push_back(succ->_idx);
+          }
+        }
+      }
+      const int repl = gr.substitute_region(members, -1);
+      updated.collapse(members, a, repl);
+      num_collapses += members.size() > 1;
+
+      LoopForest fresh = LoopForest::compute(gr);
+      const auto headers = [](LoopForest const& forest, int v) {
+        std::vector<int> result;
+        for (int l = forest.loop_of(v); l != -1; l = forest.loop(l)._parent) {
+          result.push_back(forest.loop(l)._header);
+        }
+        return result;
+      };
+      for (int v = 0; v < static_cast<int>(gr.size()); v++) {
+        mismatches += headers(updated, v) != headers(fresh, v);
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+  // Make sure the generator covers both kinds of graph
+  CHECK(num_reducible > 0);
+  CHECK(num_irreducible > 0);
+  CHECK(num_collapses > 0);
+}
+
+TEST_CASE("Test reachability index") {
+  std::mt19937 rng(0x4eac);
+  auto pick = [&rng](uint32_t n) { return static_cast<int>(rng() % n); };
+
+  // Paths of at least one edge by plain search
+  const auto reference_reaches = [](FlowGraphBase const& gr, int from, int to) {
+    std::vector<bool> visited(gr.size());
+    std::vector<int> pending;
+    for (EdgeData const& ed : gr.vertex(from)->_out) {
+      pending.push_back(ed._target);
+    }
+    while (!pending.empty()) {
+      const int v = pending.back();
+      pending.pop_back();
+      if (v == to) {
+        return true;
+      }
+      if (!visited[v]) {
+        visited[v] = true;
+        for (EdgeData const& ed : gr.vertex(v)->_out) {
+          pending.push_back(ed._target);
+        }
+      }
+    }
+    return false;
+  };
+
+  size_t mismatches = 0;
+  size_t num_reaching = 0;
+  size_t num_labeled = 0;
+  for (int round = 0; round < 60; round++) {
+    // Every fourth graph is too big for the matrix
+    FlowGraph<int> gr;
+    const int num_blocks = round % 4 == 3 ? 1500 + pick(500) : 2 + pick(60);
+    std::vector<int> vertices;
+    for (int i = 0; i < num_blocks; i++) {
+      vertices.push_back(gr.emplace_vertex(i));
+    }
+    gr.emplace_link(gr.root()->_idx, vertices[0], BlockTransfer::kFallthrough);
+    for (int i = 0; i < num_blocks; i++) {
+      for (int edges = pick(3); edges > 0; edges--) {
+        const int target = pick(10) == 0 ? pick(num_blocks) : std::min(num_blocks - 1, i + 1 + pick(4));
+        gr.emplace_link(vertices[i], vertices[target], BlockTransfer::kUnconditional);
+      }
+      if (i == num_blocks - 1 || pick(8) == 0) {
+        gr.emplace_link(vertices[i], gr.terminal()->_idx, BlockTransfer::kUnconditional);
+      }
+    }
+    ReachabilityIndex reach(gr);
+    num_labeled += !reach.uses_matrix();
+
+    for (int step = 0; step < 20; step++) {
+      std::vector<int> live;
+      gr.foreach_real([&live](FlowVertex<int> const& v) { live.push_back(v._idx); });
+      for (int query = 0; query < 200; query++) {
+        const int a = live[pick(live.size())];
+        const int b = query % 8 == 0 ? a : live[pick(live.size())];
+        const bool expected = reference_reaches(gr, a, b);
+        mismatches += reach.reaches(gr, a, b) != expected;
+        num_reaching += expected;
+      }
+
+      // Single entry region grown from a random vertex, same as the dominator tree update test
+      const int a = live[pick(live.size())];
+      std::vector<int> members{a};
+      for (size_t i = 0; i < members.size() && members.size() < 6; i++) {
+        for (EdgeData const& ed : gr.vertex(members[i])->_out) {
+          FlowVertex<int> const* succ = gr.vertex(ed._target);
+          const bool inside = std::all_of(succ->_in.begin(), succ->_in.end(), [&members](EdgeData const& in) {
+            return std::find(members.begin(), members.end(), in._target) != members.end();
+          });
+          if (succ->is_real() && inside && std::find(members.begin(), members.end(), succ->_idx) == members.end()) {
+            members.push_back(succ->_idx);
+          }
+        }
+      }
+      const int repl = gr.substitute_region(members, -1);
+      reach.collapse(gr, a, repl);
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(num_reaching > 0);
+  CHECK(num_labeled > 0);
+}
+
+TEST_CASE("Test postorder list splicing") {
+  std::mt19937 rng(0x9057);
+  auto pick = [&rng](uint32_t n) { return static_cast<int>(rng() % n); };
+
+  size_t mismatches = 0;
+  for (int round = 0; round < 40; round++) {
+    std::vector<int> expected(2 + pick(200));
+    std::iota(expected.begin(), expected.end(), 0);
+    std::shuffle(expected.begin(), expected.end(), rng);
+    PostorderList post(expected, expected.size());
+    int next_idx = static_cast<int>(expected.size());
+
+    while (expected.size() > 1) {
+      // Replace one vertex and drop a few others, the way a region collapse does
+      const size_t slot = pick(expected.size());
+      const int repl = next_idx++;
+      post.replace(expected[slot], repl);
+      expected[slot] = repl;
+      for (int drop = pick(4); drop > 0 && expected.size() > 1; drop--) {
+        size_t victim = pick(expected.size());
+        if (expected[victim] == repl) {
+          continue;
+        }
+        post.erase(expected[victim]);
+        expected.erase(expected.begin() + victim);
+      }
+
+      std::vector<int> walked;
+      for (int v = post.first(); v != -1; v = post.next(v)) {
+        walked.push_back(v);
+      }
+      mismatches += walked != expected;
+      for (size_t i = 1; i < expected.size(); i++) {
+        mismatches += !post.precedes(expected[i - 1], expected[i]);
+      }
+      for (int v = 0; v < next_idx; v++) {
+        mismatches += post.contains(v) != (std::find(expected.begin(), expected.end(), v) != expected.end());
+      }
+    }
+  }
+  CHECK(mismatches == 0);
+}
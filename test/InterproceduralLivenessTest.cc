@@ -0,0 +1,166 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "ppc/BinaryContext.hh"
+#include "ppc/InterproceduralLiveness.hh"
+#include "ppc/LivenessCursor.hh"
+#include "ppc/ProgramDiscovery.hh"
+#include "ppc/RegisterLiveness.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+constexpr uint32_t kFunctionSize = 0x40;
+constexpr uint32_t kBlr = 0x4e800020;
+constexpr uint32_t kNop = 0x60000000;
+// Nothing is mapped here, calls to it can't be resolved to a subroutine
+constexpr uint32_t kUnmappedVa = 0x80100000;
+
+constexpr uint32_t function_va(uint32_t idx) { return kProgramBase + idx * kFunctionSize; }
+constexpr uint32_t addi(uint32_t rd, uint32_t ra, int16_t simm) {
+  return (14 << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t add(uint32_t rd, uint32_t ra, uint32_t rb) {
+  return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (266 << 1);
+}
+constexpr uint32_t cmpwi(uint32_t ra, int16_t simm) { return (11 << 26) | (ra << 16) | static_cast<uint16_t>(simm); }
+constexpr uint32_t beq(int32_t rel) { return (16 << 26) | (12 << 21) | (2 << 16) | (static_cast<uint32_t>(rel) & 0xfffc); }
+constexpr uint32_t bl(uint32_t from, uint32_t to) { return (18 << 26) | ((to - from) & 0x3fffffc) | 1; }
+
+void push_be(std::vector<char>& out, uint32_t word) {
+  out.push_back(static_cast<char>(word >> 24));
+  out.push_back(static_cast<char>(word >> 16));
+  out.push_back(static_cast<char>(word >> 8));
+  out.push_back(static_cast<char>(word));
+}
+
+enum Function : uint32_t {
+  kCaller,
+  kLeaf,
+  kWrapper,
+  kRecursive,
+  kUnresolvedWrapper,
+  kForwarder,
+  kNumFunctions,
+};
+
+std::vector<char> make_program() {
+  const std::vector<std::vector<uint32_t>> bodies = {
+    // li r5, 7; li r3, 1; bl leaf; add r3, r3, r5; blr
+    {addi(5, 0, 7), addi(3, 0, 1), bl(function_va(kCaller) + 8, function_va(kLeaf)), add(3, 3, 5), kBlr},
+    // addi r3, r3, 1; blr
+    {addi(3, 3, 1), kBlr},
+    // bl leaf; blr
+    {bl(function_va(kWrapper), function_va(kLeaf)), kBlr},
+    // cmpwi r3, 0; beq done; addi r3, r3, -1; bl recursive; done: blr
+    {cmpwi(3, 0), beq(12), addi(3, 3, -1), bl(function_va(kRecursive) + 12, function_va(kRecursive)), kBlr},
+    // bl unmapped; blr
+    {bl(function_va(kUnresolvedWrapper), kUnmappedVa), kBlr},
+    // li r3, 1; bl unresolved_wrapper; blr
+    {addi(3, 0, 1), bl(function_va(kForwarder) + 4, function_va(kUnresolvedWrapper)), kBlr},
+  };
+
+  std::vector<char> code;
+  for (std::vector<uint32_t> const& body : bodies) {
+    for (uint32_t word : body) {
+      push_be(code, word);
+    }
+    for (size_t i = body.size(); i < kFunctionSize / 4; i++) {
+      push_be(code, kNop);
+    }
+  }
+  return code;
+}
+
+GprSet live_out_at(Subroutine const& routine, uint32_t va) {
+  BasicBlock const* block = routine._graph->block_by_vaddr(va);
+  REQUIRE(block != nullptr);
+  return live_out_at<GprSet>(*block, (va - block->_block_start) / 4);
+}
+
+FunctionTable discover_all(BinaryContext const& ctx) {
+  std::vector<uint32_t> roots;
+  for (uint32_t fn = 0; fn < kNumFunctions; fn++) {
+    roots.push_back(function_va(fn));
+  }
+  FunctionTable table = discover_functions(ctx, roots);
+  REQUIRE(table._routines.size() == kNumFunctions);
+  return table;
+}
+}  // namespace
+
+TEST_CASE("Calls only clobber what the callee writes") {
+  std::vector<char> code = make_program();
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+  const uint32_t call_va = function_va(kCaller) + 8;
+
+  FunctionTable abi_table = discover_all(ctx);
+  for (Subroutine& routine : abi_table._routines) {
+    run_liveness_analysis(routine, ctx);
+  }
+  // The ABI contract kills r5 at the call
+  CHECK(!live_out_at(abi_table._routines[kCaller], call_va).in_set(GPR::kR5));
+  CHECK(abi_table._routines[kWrapper]._gpr_param == GprSet());
+
+  FunctionTable table = discover_all(ctx);
+  run_interprocedural_liveness(table, ctx, 2);
+
+  Subroutine const& leaf = table._routines[kLeaf];
+  CHECK(leaf._gpr_param == gpr_mask_literal<GPR::kR3>());
+  CHECK(leaf._gpr_clobber == gpr_mask_literal<GPR::kR3>());
+  CHECK(leaf._fpr_clobber == FprSet());
+  CHECK(leaf._cr_clobber == CrSet());
+
+  // r5 survives the call to leaf and is read afterwards
+  Subroutine const& caller = table._routines[kCaller];
+  CHECK(live_out_at(caller, call_va).in_set(GPR::kR5));
+  CHECK(live_out_at(caller, call_va).in_set(GPR::kR3));
+  CHECK(caller._gpr_clobber == gpr_mask_literal<GPR::kR3, GPR::kR5>());
+
+  // Wrappers forward their callee's parameters
+  CHECK(table._routines[kWrapper]._gpr_param == gpr_mask_literal<GPR::kR3>());
+  CHECK(table._routines[kWrapper]._gpr_clobber == gpr_mask_literal<GPR::kR3>());
+}
+
+TEST_CASE("Recursive calls keep the ABI contract") {
+  std::vector<char> code = make_program();
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  FunctionTable table = discover_all(ctx);
+  run_interprocedural_liveness(table, ctx);
+
+  // The recursive call may read any parameter, not just the r3 this routine reads itself
+  Subroutine const& recursive = table._routines[kRecursive];
+  CHECK(recursive._gpr_param == kParameterSetGpr);
+  CHECK(recursive._gpr_clobber == kCallerSavedGpr);
+  CHECK(recursive._fpr_clobber == kCallerSavedFpr);
+}
+
+TEST_CASE("Wrappers around unresolved calls forward every parameter") {
+  std::vector<char> code = make_program();
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+  const uint32_t li_va = function_va(kForwarder);
+
+  FunctionTable abi_table = discover_all(ctx);
+  for (Subroutine& routine : abi_table._routines) {
+    run_liveness_analysis(routine, ctx);
+  }
+  CHECK(live_out_at(abi_table._routines[kForwarder], li_va).in_set(GPR::kR3));
+
+  FunctionTable table = discover_all(ctx);
+  run_interprocedural_liveness(table, ctx);
+
+  // Whatever the unresolved callee reads has to show up as a parameter of the wrapper
+  Subroutine const& wrapper = table._routines[kUnresolvedWrapper];
+  CHECK(wrapper._gpr_param == kParameterSetGpr);
+  CHECK(wrapper._fpr_param == kParameterSetFpr);
+  CHECK(wrapper._gpr_clobber == kCallerSavedGpr);
+
+  // So r3 is still live going into the call through the wrapper
+  CHECK(live_out_at(table._routines[kForwarder], li_va).in_set(GPR::kR3));
+}
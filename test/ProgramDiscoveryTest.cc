@@ -0,0 +1,125 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "ppc/BinaryContext.hh"
+#include "ppc/ProgramDiscovery.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+constexpr uint32_t kBlr = 0x4e800020;
+constexpr uint32_t kNop = 0x60000000;
+
+constexpr uint32_t bl(uint32_t from, uint32_t to) { return (18 << 26) | ((to - from) & 0x3fffffc) | 1; }
+
+void push_be(std::vector<char>& out, uint32_t word) {
+  out.push_back(static_cast<char>(word >> 24));
+  out.push_back(static_cast<char>(word >> 16));
+  out.push_back(static_cast<char>(word >> 8));
+  out.push_back(static_cast<char>(word));
+}
+
+// Lays out one function per callee list, each a run of bl instructions followed by blr, kFunctionSize bytes apart
+constexpr uint32_t kFunctionSize = 0x40;
+constexpr uint32_t function_va(uint32_t idx) { return kProgramBase + idx * kFunctionSize; }
+
+std::vector<char> make_program(std::vector<std::vector<uint32_t>> const& callees) {
+  std::vector<char> code;
+  for (uint32_t fn = 0; fn < callees.size(); fn++) {
+    REQUIRE(callees[fn].size() < kFunctionSize / 4);
+    uint32_t va = function_va(fn);
+    for (uint32_t target : callees[fn]) {
+      push_be(code, bl(va, target));
+      va += 4;
+    }
+    push_be(code, kBlr);
+    for (va += 4; va < function_va(fn + 1); va += 4) {
+      push_be(code, kNop);
+    }
+  }
+  return code;
+}
+
+std::vector<uint32_t> starts_of(FunctionTable const& table) {
+  std::vector<uint32_t> starts;
+  for (Subroutine const& routine : table._routines) {
+    starts.push_back(routine._start_va);
+  }
+  return starts;
+}
+}  // namespace
+
+TEST_CASE("Discovery follows direct calls from the entrypoint") {
+  // Past the end of the program
+  constexpr uint32_t kUnmapped = function_va(64);
+  // 0 -> 1, 2; 1 -> 3, 1; 2 -> 1, unmapped; 4 is never called
+  std::vector<char> code = make_program({
+    {function_va(1), function_va(2)},
+    {function_va(3), function_va(1)},
+    {function_va(1), kUnmapped},
+    {},
+    {function_va(0)},
+  });
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  ErrorOr<FunctionTable> table = discover_program(ctx, 2);
+  REQUIRE(!table.is_error());
+  CHECK(starts_of(table.val()) == std::vector<uint32_t>{function_va(0), function_va(1), function_va(2), function_va(3)});
+
+  Subroutine const* routine = table.val().find(function_va(2));
+  REQUIRE(routine != nullptr);
+  REQUIRE(routine->_graph != nullptr);
+  CHECK(routine->_graph->_direct_calls == std::vector<uint32_t>{function_va(1), kUnmapped});
+  CHECK(table.val().find(function_va(4)) == nullptr);
+}
+
+TEST_CASE("Discovery finds the same functions regardless of thread count") {
+  constexpr uint32_t kNumFunctions = 4000;
+  // Every function calls a few pseudo random others, function i only calls functions with a larger index when i is
+  // odd, so some of the program stays unreachable
+  std::vector<std::vector<uint32_t>> callees(kNumFunctions);
+  for (uint32_t fn = 0; fn < kNumFunctions; fn++) {
+    for (uint32_t c = 0; c < 2 + fn % 3; c++) {
+      uint32_t target = (fn * 2654435761u + c * 40503u) % kNumFunctions;
+      if (fn % 2 == 1 && target <= fn) {
+        continue;
+      }
+      callees[fn].push_back(function_va(target));
+    }
+  }
+  std::vector<char> code = make_program(callees);
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  // Serial reference walk over the call lists
+  std::set<uint32_t> reachable{0};
+  std::vector<uint32_t> stack{0};
+  while (!stack.empty()) {
+    const uint32_t fn = stack.back();
+    stack.pop_back();
+    for (uint32_t target : callees[fn]) {
+      const uint32_t target_idx = (target - kProgramBase) / kFunctionSize;
+      if (reachable.insert(target_idx).second) {
+        stack.push_back(target_idx);
+      }
+    }
+  }
+  std::vector<uint32_t> expected;
+  for (uint32_t fn : reachable) {
+    expected.push_back(function_va(fn));
+  }
+  REQUIRE(expected.size() > kNumFunctions / 4);
+  REQUIRE(expected.size() < kNumFunctions);
+
+  for (size_t num_threads : {1, 2, 8}) {
+    CAPTURE(num_threads);
+    ErrorOr<FunctionTable> table = discover_program(ctx, num_threads);
+    REQUIRE(!table.is_error());
+    CHECK(starts_of(table.val()) == expected);
+  }
+}
@@ -0,0 +1,271 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "ppc/BinaryContext.hh"
+#include "ppc/LivenessCursor.hh"
+#include "ppc/RegisterLiveness.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+
+using namespace decomp;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+constexpr uint32_t kBlr = 0x4e800020;
+constexpr int kMaxLoopDepth = 4;
+
+constexpr uint32_t dform(uint32_t op, uint32_t rd, uint32_t ra, int16_t simm) {
+  return (op << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t add(uint32_t rd, uint32_t ra, uint32_t rb) {
+  return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (266 << 1);
+}
+constexpr uint32_t fadd(uint32_t frd, uint32_t fra, uint32_t frb) {
+  return (63 << 26) | (frd << 21) | (fra << 16) | (frb << 11) | (21 << 1);
+}
+constexpr uint32_t cmpwi(uint32_t crf, uint32_t ra, int16_t simm) { return dform(11, crf << 2, ra, simm); }
+constexpr uint32_t bc(uint32_t bo, uint32_t bi, int32_t rel) {
+  return (16 << 26) | (bo << 21) | (bi << 16) | (static_cast<uint32_t>(rel) & 0xfffc);
+}
+
+// Nested loops with conditional skips inside, moving values between a small pool of registers so liveness has to
+// travel around the back edges several times before settling
+class LoopFunctionBuilder {
+private:
+  std::mt19937& _rng;
+  std::vector<uint32_t> _words;
+
+  uint32_t pick(uint32_t n) { return static_cast<uint32_t>(_rng() % n); }
+  uint32_t gpr() { return 3 + pick(10); }
+  uint32_t fpr() { return 1 + pick(8); }
+
+  void emit_straight() {
+    switch (pick(4)) {
+      case 0:
+        _words.push_back(add(gpr(), gpr(), gpr()));
+        break;
+      case 1:
+        _words.push_back(dform(14, gpr(), gpr(), static_cast<int16_t>(pick(64))));
+        break;
+      case 2:
+        _words.push_back(fadd(fpr(), fpr(), fpr()));
+        break;
+      default:
+        _words.push_back(cmpwi(pick(8), gpr(), static_cast<int16_t>(pick(16))));
+        break;
+    }
+  }
+
+  void emit_body(int depth) {
+    const uint32_t len = 2 + pick(6);
+    for (uint32_t i = 0; i < len; i++) {
+      const uint32_t kind = pick(8);
+      if (kind < 2 && depth < kMaxLoopDepth) {
+        emit_loop(depth + 1);
+      } else if (kind < 3) {
+        // Conditionally skip over a few instructions
+        const size_t branch = _words.size();
+        _words.push_back(0);
+        for (uint32_t skipped = 1 + pick(3); skipped > 0; skipped--) {
+          emit_straight();
+        }
+        _words[branch] = bc(pick(2) == 0 ? 12 : 4, pick(32), static_cast<int32_t>(4 * (_words.size() - branch)));
+      } else {
+        emit_straight();
+      }
+    }
+  }
+
+  void emit_loop(int depth) {
+    const size_t head = _words.size();
+    emit_body(depth);
+    const uint32_t crf = pick(8);
+    _words.push_back(cmpwi(crf, gpr(), static_cast<int16_t>(pick(16))));
+    const size_t latch = _words.size();
+    _words.push_back(bc(4, crf * 4 + 2, -static_cast<int32_t>(4 * (latch - head))));
+  }
+
+public:
+  explicit LoopFunctionBuilder(std::mt19937& rng) : _rng(rng) {}
+
+  std::vector<uint32_t> build() {
+    _words.clear();
+    emit_body(0);
+    _words.push_back(kBlr);
+    return _words;
+  }
+};
+
+void push_be(std::vector<char>& out, uint32_t word) {
+  out.push_back(static_cast<char>(word >> 24));
+  out.push_back(static_cast<char>(word >> 16));
+  out.push_back(static_cast<char>(word >> 8));
+  out.push_back(static_cast<char>(word));
+}
+
+template <typename SetType>
+void fingerprint_liveness(BasicBlock const& block, std::vector<uint32_t>& out) {
+  // FPR and CR liveness are skipped for functions that never touch them
+  auto const* rl = get_liveness<SetType>(&block);
+  if (rl == nullptr) {
+    out.push_back(0xdeadbeef);
+    return;
+  }
+  for (LivenessCursor<SetType> cursor(block); !cursor.at_end(); cursor.next()) {
+    out.insert(out.end(), {cursor.live_in()._set, cursor.live_out()._set, cursor.def()._set, cursor.use()._set});
+  }
+  out.insert(out.end(), {rl->_input._set, rl->_output._set, rl->_overwrite._set, rl->_routine_inputs._set});
+}
+
+std::vector<uint32_t> fingerprint(Subroutine const& routine) {
+  std::vector<uint32_t> out{routine._gpr_param._set,
+    routine._fpr_param._set,
+    routine._gpr_clobber._set,
+    routine._fpr_clobber._set,
+    routine._cr_clobber._set};
+  routine._graph->foreach_real([&out](BasicBlockVertex const& bbv) {
+    fingerprint_liveness<GprSet>(bbv.data(), out);
+    fingerprint_liveness<FprSet>(bbv.data(), out);
+    fingerprint_liveness<CrSet>(bbv.data(), out);
+  });
+  return out;
+}
+
+uint32_t fnv1a(std::vector<uint32_t> const& words) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t word : words) {
+    hash = (hash ^ word) * 16777619u;
+  }
+  return hash;
+}
+
+// fnv1a(fingerprint(...)) of every function the first test generates, recorded with the sweeping solver liveness had
+// before the worklist. That solver was run with the decoder's current register reads, where a branch that ignores its
+// condition doesn't read BI, and classes the current pass would skip are recorded as skipped
+constexpr uint32_t kSweepFingerprints[] = {
+  0x4c23dedd, 0xf8a4c78c, 0xab1cdea7, 0xb893ff64, 0xf0ab714d, 0xac4e9b8b, 0xc00179f5, 0xc2608215, 0xf3d6be55,
+  0x5d1cb1f8, 0x697df8f5, 0x47e9ad0e, 0xd86b793d, 0xca4c2243, 0xcdf4f7f3, 0x96c758e0, 0xaf5e8857, 0xeaf75660,
+  0xcf79d47d, 0x492716db, 0x3eb5e0b2, 0xefe6d40c, 0x29ed142a, 0x67a28e73, 0xbf32bcca, 0xbad414fb, 0x61a09493,
+  0x5fcb521f, 0x534dede8, 0x3fb6bc3b, 0x884acd40, 0x78d10517, 0xb4c444bb, 0xe8007fdb, 0xe9959345, 0x7b507d07,
+  0xbc0b5bc6, 0x82994184, 0xc4c30fee, 0x2f8eb96c, 0x225a9e37, 0x71665ec9, 0x08786163, 0xa59abb2b, 0xbcf50246,
+  0xcc388ec0, 0x8f5cbdce, 0x4a3b1bf6, 0x212767ad, 0x648c5528, 0x67e363f3, 0x535da7ed, 0x5477a9e5, 0xd3226c2f,
+  0x6dfbc6ba, 0x9b0e71b4, 0x61f52ade, 0xcd28ee45, 0x921c80b6, 0x571824e6, 0x1538b72f, 0x5f34f465, 0xb6249c5e,
+  0x1884529f, 0xca9baae8, 0xd9d4a268, 0x67b7d8ef, 0xdd3ef923, 0x3723452b, 0x1eb69f42, 0x69968012, 0xc7f4750a,
+  0x5ef470e3, 0xbb3d2e2e, 0x10a3d144, 0x626695fb, 0x6d113117, 0xb36a6c08, 0xfe3da953, 0x316cf98f, 0x7264b94b,
+  0x80acec62, 0x2e64a2b2, 0x8a49fe2e, 0xb8710932, 0x8b1ff2be, 0xfd0679bb, 0x5d452117, 0x2177e94f, 0x75348270,
+  0xc191340b, 0x6123b18f, 0x84d231a9, 0x128b42ad, 0xbe0c41ba, 0xe1ef0bde, 0x7755ad1b, 0x599d3d48, 0xe1d406a5,
+  0x77d9cd5a, 0xa77207e0, 0x3585aa9c, 0xf9175dfd, 0x08115ef6, 0x1eda486f, 0x1a5098b4, 0x5511de97, 0xb11024ec,
+  0xacb659a9, 0xc722a1c8, 0x6a264681, 0x7bc4551a, 0x4229cc66, 0xf9115997, 0x0658dcff, 0xc036c1b0, 0x050c7c26,
+  0x94006717, 0x384f8d8f, 0x8b51f8fe, 0x6f484d4d, 0x00f44653, 0xbe7407d0, 0xa4be6bcf, 0x4e0e809c, 0xec966000,
+  0x788f035d, 0x7e22af16, 0x3b4e8b7f, 0x01629459, 0x309c1c79, 0x71981efd, 0x72c8768e, 0x5d51533f, 0xdf790705,
+  0x3a98a44d, 0x8546b49c, 0xc351bfba, 0x7c9df883, 0xbc8a36b3, 0xb20dfc0f, 0xa6d27315, 0xd56b8cde, 0xd6518b6c,
+  0xa31f1893, 0xb0454b65, 0xec629173, 0xeb234aab, 0x856de396, 0xf89177d8, 0x52e73075, 0x8f9416de, 0x96454768,
+  0xd71e3bcf, 0x05c3d2dc, 0x6c56ef06, 0xbfc06b7e, 0xdde3b71f, 0xa4b9292d, 0xc775feb5, 0xf43fea45, 0x4dfe861e,
+  0x0322a934, 0xaabd05fa, 0x5a6aeebe, 0xbe5f958c, 0x39410d6d, 0x30127d2c, 0x22b45456, 0xe670fcb9, 0xec080e39,
+  0xd7dec458, 0x969df657, 0x311b27cd, 0xbaf99297, 0x94dfd440, 0x4e982ae4, 0x914a8251, 0x4d5ef711, 0x5da3d3cd,
+  0x26c1e6d4, 0x18a8a383, 0xe08f0463, 0x35d900a4, 0x532e4da8, 0xe664cd1f, 0x47726e02, 0x508e914d, 0xf78b9393,
+  0x83ee1d64, 0x50fe12f1, 0x33edd41d, 0x0b0c18f0, 0xe9e57d9c, 0x1140a657, 0xf4fdc08b, 0x703e950e, 0x4fbf37b7,
+  0xae5514b3, 0x6f15e1fb, 0x28901d6d, 0x340351a9, 0x4fe50786, 0xb012f901, 0x242a9823, 0xdb07ebb4, 0xd57bd246,
+  0x4ad14d5f, 0xee8ca2ee, 0x59771ab4, 0xd9c1a116, 0x7375ec85, 0x8a00b5e1, 0x59947cd7, 0x0683f08c, 0xeb90c32a,
+  0x7b5ed001, 0x5149499e, 0x1702285c, 0x65638393, 0x4bddf66a, 0x13ff14ca, 0x463b3527, 0xed91aa9b, 0x3ddbd687,
+  0x7aeb959e, 0x3108d382, 0xb7222725, 0x2e55cd1d, 0xeec2576d, 0x65b99cd9, 0xd242ffc1, 0x67a6a3a3, 0x532c0ef5,
+  0xebb07c68, 0x2229cb1c, 0x528f4e49, 0x1d649388, 0x0c398046, 0x5e0407e3, 0x8e5d80ce, 0x650b7ea3, 0xbd28bf98,
+  0x46c2c504, 0x5f5062bd, 0xf0a1f701, 0xf3f5b12f, 0xd2196228, 0xc06a97f6, 0x3bef581f, 0xe4f16c25, 0x605a41f3,
+  0x7c44b0a5, 0x3b92381d, 0x73c9a916, 0x8beab644, 0xb1c4af80, 0xf4595cf0, 0xcdd9e00b, 0xdd76a540, 0xa535bf92,
+  0x3628b644, 0xe7ff855e, 0xd5730f26, 0xbcde0c89, 0xb7ed38a2, 0x60b2bc80, 0x4c597b40, 0x2c1ac35e, 0xc1385151,
+  0x540a7d1e, 0x054bbee5, 0x1ed9ba9d, 0x81832f10, 0x0d9d3d00, 0x0f6ec768, 0x596ee530, 0x539b6657, 0x34bc2c97,
+  0xbcda1f79, 0xfb27d8b4, 0x6ff3611f, 0xa1fe885e, 0x6de132d1, 0xe2a9835d, 0xe526b8d3, 0x0191fe54, 0xcf2980c9,
+  0xec571b63, 0xa3144cf1, 0x4b298d07, 0x36be9984, 0x1941ab2f, 0x780f5da5, 0x88b5074f, 0x0c6deead, 0x73fc28ed,
+  0x3ae38809, 0x3747ac88, 0x590019ec,
+};
+}  // namespace
+
+TEST_CASE("Worklist liveness matches full sweeps on loop nests") {
+  constexpr uint32_t kNumFunctions = 300;
+  std::mt19937 rng(4321);
+  LoopFunctionBuilder builder(rng);
+
+  std::vector<uint32_t> starts;
+  std::vector<char> code;
+  for (uint32_t fn = 0; fn < kNumFunctions; fn++) {
+    starts.push_back(kProgramBase + static_cast<uint32_t>(code.size()));
+    for (uint32_t word : builder.build()) {
+      push_be(code, word);
+    }
+  }
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  LivenessStats worklist_stats;
+  LivenessStats sweep_stats;
+  static_assert(std::size(kSweepFingerprints) == kNumFunctions);
+  size_t mismatches = 0;
+  size_t recorded_mismatches = 0;
+  for (uint32_t i = 0; i < kNumFunctions; i++) {
+    Subroutine worklist_routine;
+    run_graph_analysis(worklist_routine, ctx, starts[i]);
+    run_liveness_analysis(worklist_routine, ctx, {}, LivenessSolver::kWorklist, &worklist_stats);
+
+    Subroutine sweep_routine;
+    run_graph_analysis(sweep_routine, ctx, starts[i]);
+    run_liveness_analysis(sweep_routine, ctx, {}, LivenessSolver::kFullSweep, &sweep_stats);
+
+    mismatches += fingerprint(worklist_routine) != fingerprint(sweep_routine);
+    recorded_mismatches += fnv1a(fingerprint(worklist_routine)) != kSweepFingerprints[i];
+  }
+  CHECK(mismatches == 0);
+  CHECK(recorded_mismatches == 0);
+
+  MESSAGE("propagate visits " << worklist_stats._propagate_visits << " vs " << sweep_stats._propagate_visits
+                              << ", backpropagate visits " << worklist_stats._backpropagate_visits << " vs "
+                              << sweep_stats._backpropagate_visits);
+  CHECK(worklist_stats._propagate_visits < sweep_stats._propagate_visits);
+  CHECK(worklist_stats._backpropagate_visits < sweep_stats._backpropagate_visits);
+}
+
+TEST_CASE("Liveness cursor steps back to the same sets it stepped forward through") {
+  constexpr uint32_t kNumFunctions = 50;
+  std::mt19937 rng(8765);
+  LoopFunctionBuilder builder(rng);
+
+  std::vector<uint32_t> starts;
+  std::vector<char> code;
+  for (uint32_t fn = 0; fn < kNumFunctions; fn++) {
+    starts.push_back(kProgramBase + static_cast<uint32_t>(code.size()));
+    for (uint32_t word : builder.build()) {
+      push_be(code, word);
+    }
+  }
+  BinaryContext ctx = create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+
+  size_t mismatches = 0;
+  for (uint32_t start : starts) {
+    Subroutine routine;
+    run_graph_analysis(routine, ctx, start);
+    run_liveness_analysis(routine, ctx);
+
+    routine._graph->foreach_real([&mismatches](BasicBlockVertex const& bbv) {
+      std::vector<GprSet> forward;
+      LivenessCursor<GprSet> cursor(bbv.data());
+      for (; !cursor.at_end(); cursor.next()) {
+        forward.insert(forward.end(), {cursor.live_in(), cursor.live_out(), cursor.def(), cursor.use()});
+        mismatches += live_out_at<GprSet>(bbv.data(), cursor.index()) != cursor.live_out();
+      }
+      // The block's last live_out carries over to the end position
+      mismatches += !forward.empty() && cursor.live_in() != forward[forward.size() - 3];
+
+      std::vector<GprSet> backward;
+      while (cursor.index() > 0) {
+        cursor.prev();
+        backward.insert(backward.begin(), {cursor.live_in(), cursor.live_out(), cursor.def(), cursor.use()});
+      }
+      mismatches += forward != backward;
+    });
+  }
+  CHECK(mismatches == 0);
+}
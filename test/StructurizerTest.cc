@@ -0,0 +1,308 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <variant>
+#include <vector>
+
+#include "hll/SemanticPreservingStructurizer.hh"
+#include "ir/GekkoTranslator.hh"
+#include "ppc/BinaryContext.hh"
+#include "ppc/SubroutineGraph.hh"
+#include "ppc/SubroutineStack.hh"
+
+using namespace decomp;
+using namespace decomp::hll;
+using namespace decomp::ppc;
+
+namespace {
+constexpr uint32_t kProgramBase = 0x80003100;
+constexpr uint32_t kBlr = 0x4e800020;
+// Branch options for bc, taken when the condition bit is set or clear
+constexpr uint32_t kIfTrue = 12;
+constexpr uint32_t kIfFalse = 4;
+
+constexpr uint32_t dform(uint32_t op, uint32_t rd, uint32_t ra, int16_t simm) {
+  return (op << 26) | (rd << 21) | (ra << 16) | static_cast<uint16_t>(simm);
+}
+constexpr uint32_t add(uint32_t rd, uint32_t ra, uint32_t rb) {
+  return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (266 << 1);
+}
+constexpr uint32_t cmpwi(uint32_t crf, uint32_t ra, int16_t simm) { return dform(11, crf << 2, ra, simm); }
+constexpr uint32_t bc(uint32_t bo, uint32_t bi, int32_t rel) {
+  return (16 << 26) | (bo << 21) | (bi << 16) | (static_cast<uint32_t>(rel) & 0xfffc);
+}
+constexpr uint32_t b(int32_t rel) { return (18 << 26) | (static_cast<uint32_t>(rel) & 0x3fffffc); }
+
+struct Assembler {
+  std::mt19937 _rng{0x57c7};
+  std::vector<uint32_t> _words;
+
+  uint32_t pick(uint32_t n) { return static_cast<uint32_t>(_rng() % n); }
+
+  uint32_t here() const { return kProgramBase + static_cast<uint32_t>(4 * _words.size()); }
+  void straight() { _words.push_back(add(3 + pick(10), 3 + pick(10), 3 + pick(10))); }
+
+  // Compare followed by a conditional branch whose target is patched in later, the condition bit is kept in the slot
+  // until then
+  size_t branch_slot() {
+    const uint32_t crf = pick(8);
+    _words.push_back(cmpwi(crf, 3 + pick(10), static_cast<int16_t>(pick(16))));
+    _words.push_back(crf * 4 + pick(3));
+    return _words.size() - 1;
+  }
+  // Points the branch in slot at the next instruction emitted
+  void patch(size_t slot, uint32_t bo) {
+    _words[slot] = bc(bo, _words[slot], static_cast<int32_t>(4 * (_words.size() - slot)));
+  }
+
+  void statement(int depth, bool loops) {
+    const uint32_t kind = pick(loops ? 10 : 9);
+    if (kind < 3 || depth == 3) {
+      straight();
+    } else if (kind < 5) {
+      const size_t skip = branch_slot();
+      body(depth + 1, 1 + pick(2), loops);
+      patch(skip, pick(2) == 0 ? kIfTrue : kIfFalse);
+    } else if (kind < 7) {
+      const size_t to_else = branch_slot();
+      body(depth + 1, 1 + pick(2), loops);
+      const size_t to_end = _words.size();
+      _words.push_back(0);
+      patch(to_else, kIfFalse);
+      body(depth + 1, 1 + pick(2), loops);
+      _words[to_end] = b(static_cast<int32_t>(4 * (_words.size() - to_end)));
+    } else if (kind < 9) {
+      // Short-circuited condition, either every term skips the body or all but the last jump straight into it
+      const bool any_of = pick(2) == 0;
+      std::vector<size_t> skips;
+      std::vector<size_t> enters;
+      for (uint32_t terms = 2 + pick(3); terms > 1; terms--) {
+        (any_of ? enters : skips).push_back(branch_slot());
+      }
+      skips.push_back(branch_slot());
+      for (size_t enter : enters) {
+        patch(enter, kIfTrue);
+      }
+      body(depth + 1, 1 + pick(2), loops);
+      for (size_t skip : skips) {
+        patch(skip, kIfFalse);
+      }
+    } else {
+      const size_t head = _words.size();
+      body(depth + 1, 1 + pick(3), loops);
+      const size_t latch = branch_slot();
+      _words[latch] = bc(kIfTrue, _words[latch], -static_cast<int32_t>(4 * (latch - head)));
+    }
+  }
+
+  void body(int depth, uint32_t len, bool loops) {
+    for (uint32_t i = 0; i < len; i++) {
+      statement(depth, loops);
+    }
+    straight();
+  }
+
+  BinaryContext context() const {
+    std::vector<char> code;
+    for (uint32_t word : _words) {
+      code.push_back(static_cast<char>(word >> 24));
+      code.push_back(static_cast<char>(word >> 16));
+      code.push_back(static_cast<char>(word >> 8));
+      code.push_back(static_cast<char>(word));
+    }
+    return create_raw(kProgramBase, kProgramBase, code.data(), code.size());
+  }
+};
+
+// translate_subroutine is still a work in progress, the structurizer only looks at the block shape so that is copied
+// straight over from the subroutine graph
+ir::IrRoutine load(BinaryContext const& ctx, uint32_t start) {
+  Subroutine routine;
+  run_graph_analysis(routine, ctx, start);
+  ir::IrRoutine ir(routine);
+  for (size_t i = 0; i < routine._graph->size(); i++) {
+    ir._graph.vertex(i)->_out = routine._graph->vertex(i)->_out;
+    ir._graph.vertex(i)->_in = routine._graph->vertex(i)->_in;
+  }
+  return ir;
+}
+
+struct TreeShape {
+  std::vector<ACNRef> _leaves;
+  std::vector<ACNType> _kinds;
+  // Combined conditions of every CCond, one per node
+  std::vector<size_t> _ccond_sizes;
+  bool _well_formed = true;
+};
+
+void walk_tree(ACNPool const& pool, ACNRef ref, TreeShape& shape) {
+  if (ref >= pool.size()) {
+    shape._well_formed = false;
+    return;
+  }
+  AbstractControlNode const* node = pool.node(ref);
+  shape._kinds.push_back(node->_type);
+  switch (node->_type) {
+    case ACNType::Basic:
+      shape._leaves.push_back(ref);
+      break;
+    case ACNType::Seq:
+      for (ACNRef sub : pool.get<Seq>(ref)->_seq) {
+        walk_tree(pool, sub, shape);
+      }
+      break;
+    case ACNType::If:
+      walk_tree(pool, pool.get<If>(ref)->_head, shape);
+      walk_tree(pool, pool.get<If>(ref)->_true, shape);
+      break;
+    case ACNType::IfElse:
+      walk_tree(pool, pool.get<IfElse>(ref)->_head, shape);
+      walk_tree(pool, pool.get<IfElse>(ref)->_true, shape);
+      walk_tree(pool, pool.get<IfElse>(ref)->_false, shape);
+      break;
+    case ACNType::CCond:
+      shape._ccond_sizes.push_back(pool.get<CCond>(ref)->_nodes.size());
+      for (CCond::CCondNode const& cn : pool.get<CCond>(ref)->_nodes) {
+        for (auto const& operand : {cn._lhs, cn._rhs}) {
+          if (std::holds_alternative<ACNRef>(operand)) {
+            walk_tree(pool, std::get<ACNRef>(operand), shape);
+          }
+        }
+      }
+      break;
+    default:
+      shape._well_formed = false;
+      break;
+  }
+}
+
+// A fully reduced tree has to hold every block the routine can reach exactly once
+bool covers_every_block(ir::IrRoutine const& ir, HLLControlTree const& tree, TreeShape& shape) {
+  walk_tree(tree._pool, tree._root, shape);
+  std::vector<ACNRef> expected;
+  for (ir::IrBlockVertex const& v : ir._graph) {
+    if (v.is_real() && !v._in.empty()) {
+      expected.push_back(static_cast<ACNRef>(v._idx));
+    }
+  }
+  std::vector<ACNRef> leaves = shape._leaves;
+  std::sort(leaves.begin(), leaves.end());
+  return shape._well_formed && leaves == expected;
+}
+}  // namespace
+
+TEST_CASE("Test structurizer reduces short-circuited conditions") {
+  Assembler as;
+  std::vector<uint32_t> starts;
+  std::vector<size_t> num_ifs;
+  std::vector<std::vector<size_t>> ccond_sizes;
+
+  // if (a && b && ...) body, every term skips the body so the terms nest as plain ifs
+  for (size_t terms = 2; terms <= 4; terms++) {
+    starts.push_back(as.here());
+    num_ifs.push_back(terms);
+    ccond_sizes.push_back({});
+    std::vector<size_t> skips;
+    for (size_t i = 0; i < terms; i++) {
+      skips.push_back(as.branch_slot());
+    }
+    as.straight();
+    for (size_t skip : skips) {
+      as.patch(skip, kIfFalse);
+    }
+    as.straight();
+    as._words.push_back(kBlr);
+  }
+
+  // if (a || b) body, the first term jumps straight into the body
+  starts.push_back(as.here());
+  num_ifs.push_back(1);
+  ccond_sizes.push_back({1});
+  const size_t to_body = as.branch_slot();
+  const size_t to_end = as.branch_slot();
+  as.patch(to_body, kIfTrue);
+  as.straight();
+  as.patch(to_end, kIfFalse);
+  as.straight();
+  as._words.push_back(kBlr);
+
+  BinaryContext ctx = as.context();
+  for (size_t i = 0; i < starts.size(); i++) {
+    CAPTURE(i);
+    ir::IrRoutine ir = load(ctx, starts[i]);
+    SemanticPreservingStructurizer sps(true);
+    HLLControlTree tree = run_control_flow_analysis(&sps, ir);
+    CHECK(sps.dominator_checks() > 0);
+    CHECK(sps.dominator_mismatches() == 0);
+    REQUIRE(tree._root != kInvalidACNRef);
+
+    TreeShape shape;
+    CHECK(covers_every_block(ir, tree, shape));
+    CHECK(shape._ccond_sizes == ccond_sizes[i]);
+    CHECK(static_cast<size_t>(std::count(shape._kinds.begin(), shape._kinds.end(), ACNType::If)) == num_ifs[i]);
+  }
+}
+
+TEST_CASE("Test structurizer keeps dominator trees exact on generated CFGs") {
+  Assembler as;
+  std::vector<uint32_t> acyclic;
+  std::vector<uint32_t> cyclic;
+  for (int i = 0; i < 150; i++) {
+    acyclic.push_back(as.here());
+    as.body(0, 2 + as.pick(10), false);
+    as._words.push_back(kBlr);
+    cyclic.push_back(as.here());
+    as.body(0, 2 + as.pick(10), true);
+    as._words.push_back(kBlr);
+  }
+  // Big enough that the dominator trees are only checked at a stride
+  for (int i = 0; i < 2; i++) {
+    acyclic.push_back(as.here());
+    as.body(0, 400, false);
+    as._words.push_back(kBlr);
+  }
+  BinaryContext ctx = as.context();
+
+  size_t mismatches = 0;
+  size_t num_checks = 0;
+  size_t bad_trees = 0;
+  size_t num_reduced = 0;
+  size_t num_cyclic_reduced = 0;
+  size_t num_cconds = 0;
+  for (uint32_t start : acyclic) {
+    ir::IrRoutine ir = load(ctx, start);
+    SemanticPreservingStructurizer sps(true);
+    HLLControlTree tree = run_control_flow_analysis(&sps, ir);
+    mismatches += sps.dominator_mismatches();
+    num_checks += sps.dominator_checks();
+    if (tree._root != kInvalidACNRef) {
+      TreeShape shape;
+      bad_trees += !covers_every_block(ir, tree, shape);
+      num_cconds += shape._ccond_sizes.size();
+      num_reduced++;
+    }
+  }
+  for (uint32_t start : cyclic) {
+    ir::IrRoutine ir = load(ctx, start);
+    SemanticPreservingStructurizer sps(true);
+    HLLControlTree tree = run_control_flow_analysis(&sps, ir);
+    mismatches += sps.dominator_mismatches();
+    num_checks += sps.dominator_checks();
+    if (tree._root != kInvalidACNRef) {
+      TreeShape shape;
+      bad_trees += !covers_every_block(ir, tree, shape);
+      num_cyclic_reduced++;
+    }
+  }
+
+  CHECK(mismatches == 0);
+  CHECK(num_checks > acyclic.size() + cyclic.size());
+  CHECK(bad_trees == 0);
+  // Structured code without loops always reduces, loops wait on the cyclic pass
+  CHECK(num_reduced == acyclic.size());
+  CHECK(num_cyclic_reduced < cyclic.size());
+  CHECK(num_cconds > 0);
+}